@@ -36,6 +36,7 @@
 #include <AMReX_StateData.H>
 #include <AMReX_PlotFileUtil.H>
 #include <AMReX_Print.H>
+#include <AMReX_AsyncOut.H>
 
 #ifdef AMREX_USE_FBOXLIB_MG
 #include <mg_cpp_f.h>
@@ -85,6 +86,7 @@ namespace
     int  probinit_natonce;
     bool plot_files_output;
     int  checkpoint_nfiles;
+    int  checkpoint_deltas;
     int  regrid_on_restart;
     int  use_efficient_regrid;
     int  plotfile_on_restart;
@@ -117,6 +119,7 @@ Amr::Initialize ()
     probinit_natonce         = 512;
     plot_files_output        = true;
     checkpoint_nfiles        = 64;
+    checkpoint_deltas        = 0;
     regrid_on_restart        = 0;
     use_efficient_regrid     = 0;
     plotfile_on_restart      = 0;
@@ -235,6 +238,7 @@ Amr::InitAmr ()
     last_plotfile          = 0;
     last_smallplotfile     = -1;
     last_checkpoint        = 0;
+    n_delta_checkpoints    = 0;
     record_run_info        = false;
     record_grid_info       = false;
     file_name_digits       = 5;
@@ -772,6 +776,10 @@ Amr::writePlotFile ()
     BL_PROFILE_REGION_START("Amr::writePlotFile()");
     BL_PROFILE("Amr::writePlotFile()");
 
+    if (AsyncOut::UseAsyncOut()) {
+        AsyncOut::Test();
+    }
+
     VisMF::SetNOutFiles(plot_nfiles);
     VisMF::Header::Version currentVersion(VisMF::GetHeaderVersion());
     VisMF::SetHeaderVersion(plot_headerversion);
@@ -871,12 +879,21 @@ Amr::writePlotFile ()
 
 	amrex::Print() << "Write plotfile time = " << dPlotFileTime << "  seconds" << "\n\n";
     }
-    ParallelDescriptor::Barrier("Amr::writePlotFile::end");
+    if (AsyncOut::UseAsyncOut()) {
+      // ---- rename it once the data of all the processes are on disk
+      AsyncOut::OnComplete([pltfileTemp, pltfile] () {
+        if(ParallelDescriptor::IOProcessor()) {
+          std::rename(pltfileTemp.c_str(), pltfile.c_str());
+        }
+      });
+    } else {
+      ParallelDescriptor::Barrier("Amr::writePlotFile::end");
 
-    if(ParallelDescriptor::IOProcessor()) {
-      std::rename(pltfileTemp.c_str(), pltfile.c_str());
+      if(ParallelDescriptor::IOProcessor()) {
+        std::rename(pltfileTemp.c_str(), pltfile.c_str());
+      }
+      ParallelDescriptor::Barrier("Renaming temporary plotfile.");
     }
-    ParallelDescriptor::Barrier("Renaming temporary plotfile.");
     //
     // the plotfile file now has the regular name
     //
@@ -1634,6 +1651,10 @@ Amr::checkPoint ()
     BL_PROFILE_REGION_START("Amr::checkPoint()");
     BL_PROFILE("Amr::checkPoint()");
 
+    if (AsyncOut::UseAsyncOut()) {
+        AsyncOut::Test();
+    }
+
     VisMF::SetNOutFiles(checkpoint_nfiles);
     //
     // In checkpoint files always write out FABs in NATIVE format.
@@ -1644,6 +1665,11 @@ Amr::checkPoint ()
 
     VisMF::Header::Version currentVersion(VisMF::GetHeaderVersion());
     VisMF::SetHeaderVersion(checkpoint_headerversion);
+    //
+    // Checkpoints are never compressed lossily.
+    //
+    Real thePrevCompressionTol(VisMF::GetCompressionTol());
+    VisMF::SetCompressionTol(0.0);
 
     Real dCheckPointTime0 = ParallelDescriptor::second();
 
@@ -1663,6 +1689,22 @@ Amr::checkPoint ()
 
   const std::string ckfileTemp(ckfile + ".temp");
 
+  //
+  // A delta checkpoint writes only the fabs that changed since the
+  // previous checkpoint and refers to that one for the others, so the
+  // previous one must be complete and kept.
+  //
+  const bool deltaCheckPoint(checkpoint_deltas > 0                      &&
+                             n_delta_checkpoints < checkpoint_deltas    &&
+                             ! last_checkpoint_file.empty()             &&
+                             last_checkpoint_file != ckfile);
+  if(checkpoint_deltas > 0) {
+    if (AsyncOut::UseAsyncOut()) {
+      AsyncOut::Finish();
+    }
+    VisMF::SetDeltaBase(ckfileTemp, deltaCheckPoint ? last_checkpoint_file : std::string());
+  }
+
   while(sretry.TryFileOutput()) {
 
     StateData::ClearFabArrayHeaderNames();
@@ -1787,21 +1829,37 @@ Amr::checkPoint ()
 
 	amrex::Print() << "checkPoint() time = " << dCheckPointTime << " secs." << '\n';
     }
-    ParallelDescriptor::Barrier("Amr::checkPoint::end");
+    if (AsyncOut::UseAsyncOut()) {
+      // ---- rename it once the data of all the processes are on disk
+      AsyncOut::OnComplete([ckfileTemp, ckfile] () {
+        if(ParallelDescriptor::IOProcessor()) {
+          std::rename(ckfileTemp.c_str(), ckfile.c_str());
+        }
+      });
+    } else {
+      ParallelDescriptor::Barrier("Amr::checkPoint::end");
 
-    if(ParallelDescriptor::IOProcessor()) {
-      std::rename(ckfileTemp.c_str(), ckfile.c_str());
+      if(ParallelDescriptor::IOProcessor()) {
+        std::rename(ckfileTemp.c_str(), ckfile.c_str());
+      }
+      ParallelDescriptor::Barrier("Renaming temporary checkPoint file.");
     }
-    ParallelDescriptor::Barrier("Renaming temporary checkPoint file.");
 
   }  // end while
 
+  if(checkpoint_deltas > 0) {
+    VisMF::SetDeltaBase(std::string(), std::string());
+    last_checkpoint_file = ckfile;
+    n_delta_checkpoints  = deltaCheckPoint ? n_delta_checkpoints + 1 : 0;
+  }
+
   //
   // Restore the previous FAB format.
   //
   FArrayBox::setFormat(thePrevFormat);
 
   VisMF::SetHeaderVersion(currentVersion);
+  VisMF::SetCompressionTol(thePrevCompressionTol);
 
   BL_PROFILE_REGION_STOP("Amr::checkPoint()");
 }
@@ -2951,6 +3009,11 @@ Amr::initPltAndChk ()
     //
     if (plot_nfiles       == -1) plot_nfiles       = ParallelDescriptor::NProcs();
     if (checkpoint_nfiles == -1) checkpoint_nfiles = ParallelDescriptor::NProcs();
+    //
+    // The number of checkpoints written as deltas of the previous one
+    // between full checkpoints.
+    //
+    pp.query("checkpoint_deltas", checkpoint_deltas);
     
     check_file_root = "chk";
     pp.query("check_file",check_file_root);
@@ -14,6 +14,7 @@
 #include <AMReX_BLProfiler.H>
 #include <AMReX_Print.H>
 #include <AMReX_VisMF.H>
+#include <AMReX_AsyncOut.H>
 
 #ifdef AMREX_USE_EB
 #include <AMReX_EBFabFactory.H>
@@ -288,7 +289,11 @@ AmrLevel::writePlotFile (const std::string& dir,
     //
     std::string TheFullPath = FullPath;
     TheFullPath += BaseName;
-    VisMF::Write(plotMF,TheFullPath,how,true);
+    if (AsyncOut::UseAsyncOut()) {
+        VisMF::AsyncWrite(plotMF,TheFullPath,true);
+    } else {
+        VisMF::Write(plotMF,TheFullPath,how,true);
+    }
 
     levelDirectoryCreated = false;  // ---- now that the plotfile is finished
 }
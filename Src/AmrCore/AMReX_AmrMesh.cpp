@@ -333,13 +333,19 @@ AmrMesh::MaxRefRatio (int lev) const
 void 
 AmrMesh::SetDistributionMap (int lev, const DistributionMapping& dmap_in)
 { 
-    if (dmap[lev] != dmap_in) dmap[lev] = dmap_in;
+    if (dmap[lev] != dmap_in) {
+        dmap[lev] = dmap_in;
+        dmap[lev].ShareOnNode();
+    }
 }
 
 void
 AmrMesh::SetBoxArray (int lev, const BoxArray& ba_in)
 {
-    if (grids[lev] != ba_in) grids[lev] = ba_in;
+    if (grids[lev] != ba_in) {
+        grids[lev] = ba_in;
+        grids[lev].ShareOnNode();
+    }
 }
 
 void
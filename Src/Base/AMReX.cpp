@@ -20,6 +20,7 @@
 #include <AMReX_MultiFab.H>
 #include <AMReX_iMultiFab.H>
 #include <AMReX_VisMF.H>
+#include <AMReX_AsyncOut.H>
 #endif
 
 #ifdef BL_LAZY
@@ -431,6 +432,7 @@ amrex::Initialize (int& argc, char**& argv, bool build_parm_parse,
     MultiFab::Initialize();
     iMultiFab::Initialize();
     VisMF::Initialize();
+    AsyncOut::Initialize();
     BL_PROFILE_INITPARAMS();
 #endif
 
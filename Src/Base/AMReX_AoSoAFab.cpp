@@ -0,0 +1,313 @@
+
+#include <algorithm>
+
+#include <AMReX_AoSoAFab.H>
+#include <AMReX_FArrayBox.H>
+#include <AMReX_FabArray.H>
+#include <AMReX_Arena.H>
+
+namespace amrex {
+
+int AoSoAFab::default_block_size = 1;
+
+AoSoAFab::AoSoAFab (const Box& bx, int ncomp, bool alloc, bool)
+    :
+    AoSoAFab(bx, ncomp, default_block_size, alloc)
+{
+}
+
+AoSoAFab::AoSoAFab (const Box& bx, int ncomp, int a_block, bool alloc)
+    :
+    domain(bx),
+    nvar(ncomp),
+    block(a_block)
+{
+    BL_ASSERT(block > 0);
+    if (alloc) resize(bx, ncomp);
+}
+
+AoSoAFab::AoSoAFab (AoSoAFab&& rhs) noexcept
+    :
+    domain(rhs.domain),
+    nvar(rhs.nvar),
+    block(rhs.block),
+    truesize(rhs.truesize),
+    dptr(rhs.dptr),
+    ptr_owner(rhs.ptr_owner)
+{
+    rhs.dptr      = nullptr;
+    rhs.truesize  = 0;
+    rhs.ptr_owner = false;
+}
+
+void
+AoSoAFab::resize (const Box& bx, int ncomp)
+{
+    const long nblocks = (bx.numPts() + block - 1) / block;
+    const long n = nblocks * block * ncomp;
+
+    domain = bx;
+    nvar   = ncomp;
+
+    if (dptr == nullptr || n > truesize)
+    {
+        clear();
+        truesize  = n;
+        dptr      = static_cast<Real*>(The_Arena()->alloc(truesize*sizeof(Real)));
+        ptr_owner = true;
+    }
+}
+
+void
+AoSoAFab::clear ()
+{
+    if (dptr && ptr_owner) {
+        The_Arena()->free(dptr);
+    }
+    dptr      = nullptr;
+    truesize  = 0;
+    ptr_owner = false;
+}
+
+//
+// Calls f(line_begin, len) for the i-lines of bx.
+//
+template <class F>
+void
+AoSoAFab::ForEachLine (const Box& bx, F f)
+{
+    const auto& len3 = bx.length3d();
+    for     (int k = 0; k < len3[2]; ++k) {
+        for (int j = 0; j < len3[1]; ++j) {
+            f(IntVect{AMREX_D_DECL(bx.smallEnd(0),
+                                   bx.smallEnd(1)+j,
+                                   bx.smallEnd(2)+k)}, len3[0]);
+        }
+    }
+}
+
+//
+// Calls f(k, t) for the cells of bx in box order, where k is the offset of
+// component 0 of the cell and t counts the cells.
+//
+template <class F>
+void
+AoSoAFab::ForEachCell (const Box& bx, F f) const
+{
+    BL_ASSERT(domain.contains(bx));
+
+    const long nb = static_cast<long>(block)*nvar;
+    long t = 0;
+    ForEachLine(bx, [&] (const IntVect& line_begin, int len) {
+        const long c0 = domain.index(line_begin);
+        for (int i = 0; i < len; ++i, ++t) {
+            const long c = c0 + i;
+            f((c/block)*nb + c%block, t);
+        }
+    });
+}
+
+void
+AoSoAFab::setVal (Real val)
+{
+    std::fill(dptr, dptr+truesize, val);
+}
+
+void
+AoSoAFab::setVal (Real val, const Box& bx, int comp, int ncomp)
+{
+    BL_ASSERT(comp >= 0 && comp+ncomp <= nvar);
+    const long b = block;
+    ForEachCell(bx, [&] (long k, long) {
+        for (int n = comp; n < comp+ncomp; ++n) {
+            dptr[k+n*b] = val;
+        }
+    });
+}
+
+void
+AoSoAFab::setComplement (Real val, const Box& bx, int comp, int ncomp)
+{
+    const BoxList bl = amrex::boxDiff(domain, bx);
+    for (const Box& b : bl) {
+        setVal(val, b, comp, ncomp);
+    }
+}
+
+AoSoAFab&
+AoSoAFab::copy (const AoSoAFab& src, const Box& srcbox, int srccomp,
+                const Box& destbox, int destcomp, int numcomp)
+{
+    BL_ASSERT(srcbox.sameSize(destbox));
+    BL_ASSERT(srccomp >= 0 && srccomp+numcomp <= src.nComp());
+    BL_ASSERT(destcomp >= 0 && destcomp+numcomp <= nvar);
+
+    const IntVect shift = srcbox.smallEnd() - destbox.smallEnd();
+    const long sb = src.block;
+    const long db = block;
+    const long snb = sb*src.nvar;
+    const Real* sp = src.dptr;
+    const long dnb = db*nvar;
+    ForEachLine(destbox, [&] (const IntVect& line_begin, int len) {
+        const long cd0 = domain.index(line_begin);
+        const long cs0 = src.domain.index(line_begin + shift);
+        for (int i = 0; i < len; ++i) {
+            const long cd = cd0 + i;
+            const long cs = cs0 + i;
+            const long kd = (cd/db)*dnb + cd%db;
+            const long ks = (cs/sb)*snb + cs%sb;
+            for (int n = 0; n < numcomp; ++n) {
+                dptr[kd+(destcomp+n)*db] = sp[ks+(srccomp+n)*sb];
+            }
+        }
+    });
+    return *this;
+}
+
+AoSoAFab&
+AoSoAFab::plus (const AoSoAFab& src, const Box& srcbox, const Box& destbox,
+                int srccomp, int destcomp, int numcomp)
+{
+    BL_ASSERT(srcbox.sameSize(destbox));
+    BL_ASSERT(srccomp >= 0 && srccomp+numcomp <= src.nComp());
+    BL_ASSERT(destcomp >= 0 && destcomp+numcomp <= nvar);
+
+    const IntVect shift = srcbox.smallEnd() - destbox.smallEnd();
+    const long sb = src.block;
+    const long db = block;
+    const long snb = sb*src.nvar;
+    const Real* sp = src.dptr;
+    const long dnb = db*nvar;
+    ForEachLine(destbox, [&] (const IntVect& line_begin, int len) {
+        const long cd0 = domain.index(line_begin);
+        const long cs0 = src.domain.index(line_begin + shift);
+        for (int i = 0; i < len; ++i) {
+            const long cd = cd0 + i;
+            const long cs = cs0 + i;
+            const long kd = (cd/db)*dnb + cd%db;
+            const long ks = (cs/sb)*snb + cs%sb;
+            for (int n = 0; n < numcomp; ++n) {
+                dptr[kd+(destcomp+n)*db] += sp[ks+(srccomp+n)*sb];
+            }
+        }
+    });
+    return *this;
+}
+
+std::size_t
+AoSoAFab::copyToMem (const Box& srcbox, int srccomp, int numcomp, void* dst) const
+{
+    if (!srcbox.ok()) return 0;
+
+    BL_ASSERT(srccomp >= 0 && srccomp+numcomp <= nvar);
+
+    Real* d = static_cast<Real*>(dst);
+    const long b = block;
+    ForEachCell(srcbox, [&] (long k, long t) {
+        for (int n = 0; n < numcomp; ++n) {
+            d[t*numcomp+n] = dptr[k+(srccomp+n)*b];
+        }
+    });
+    return sizeof(Real)*numcomp*srcbox.numPts();
+}
+
+std::size_t
+AoSoAFab::copyFromMem (const Box& dstbox, int dstcomp, int numcomp, const void* src)
+{
+    if (!dstbox.ok()) return 0;
+
+    BL_ASSERT(dstcomp >= 0 && dstcomp+numcomp <= nvar);
+
+    const Real* s = static_cast<const Real*>(src);
+    const long b = block;
+    ForEachCell(dstbox, [&] (long k, long t) {
+        for (int n = 0; n < numcomp; ++n) {
+            dptr[k+(dstcomp+n)*b] = s[t*numcomp+n];
+        }
+    });
+    return sizeof(Real)*numcomp*dstbox.numPts();
+}
+
+void
+AoSoAFab::copyFrom (const FArrayBox& src, const Box& bx, int srccomp, int destcomp, int numcomp)
+{
+    BL_ASSERT(src.box().contains(bx));
+    BL_ASSERT(srccomp >= 0 && srccomp+numcomp <= src.nComp());
+    BL_ASSERT(destcomp >= 0 && destcomp+numcomp <= nvar);
+
+    const long b  = block;
+    const long nb = b*nvar;
+    ForEachLine(bx, [&] (const IntVect& line_begin, int len) {
+        const long c0 = domain.index(line_begin);
+        for (int n = 0; n < numcomp; ++n) {
+            const Real* sp = src.dataPtr(line_begin, srccomp+n);
+            for (int i = 0; i < len; ++i) {
+                const long c = c0 + i;
+                dptr[(c/b)*nb + c%b + (destcomp+n)*b] = sp[i];
+            }
+        }
+    });
+}
+
+void
+AoSoAFab::copyTo (FArrayBox& dst, const Box& bx, int srccomp, int destcomp, int numcomp) const
+{
+    BL_ASSERT(dst.box().contains(bx));
+    BL_ASSERT(srccomp >= 0 && srccomp+numcomp <= nvar);
+    BL_ASSERT(destcomp >= 0 && destcomp+numcomp <= dst.nComp());
+
+    const long b  = block;
+    const long nb = b*nvar;
+    ForEachLine(bx, [&] (const IntVect& line_begin, int len) {
+        const long c0 = domain.index(line_begin);
+        for (int n = 0; n < numcomp; ++n) {
+            Real* dp = dst.dataPtr(line_begin, destcomp+n);
+            for (int i = 0; i < len; ++i) {
+                const long c = c0 + i;
+                dp[i] = dptr[(c/b)*nb + c%b + (srccomp+n)*b];
+            }
+        }
+    });
+}
+
+void
+Copy (FabArray<AoSoAFab>& dst, const FabArray<FArrayBox>& src,
+      int srccomp, int dstcomp, int numcomp, int nghost)
+{
+    BL_ASSERT(dst.boxArray() == src.boxArray());
+    BL_ASSERT(dst.DistributionMap() == src.DistributionMap());
+    BL_ASSERT(dst.nGrow() >= nghost && src.nGrow() >= nghost);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(dst,true); mfi.isValid(); ++mfi)
+    {
+        const Box& bx = mfi.growntilebox(nghost);
+        if (bx.ok()) {
+            dst[mfi].copyFrom(src[mfi], bx, srccomp, dstcomp, numcomp);
+        }
+    }
+}
+
+void
+Copy (FabArray<FArrayBox>& dst, const FabArray<AoSoAFab>& src,
+      int srccomp, int dstcomp, int numcomp, int nghost)
+{
+    BL_ASSERT(dst.boxArray() == src.boxArray());
+    BL_ASSERT(dst.DistributionMap() == src.DistributionMap());
+    BL_ASSERT(dst.nGrow() >= nghost && src.nGrow() >= nghost);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(dst,true); mfi.isValid(); ++mfi)
+    {
+        const Box& bx = mfi.growntilebox(nghost);
+        if (bx.ok()) {
+            src[mfi].copyTo(dst[mfi], bx, srccomp, dstcomp, numcomp);
+        }
+    }
+}
+
+}
@@ -0,0 +1,219 @@
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <AMReX.H>
+#include <AMReX_AsyncOut.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_ParmParse.H>
+
+namespace amrex {
+namespace AsyncOut {
+
+namespace
+{
+    bool use_async_out = false;
+    long max_bytes     = 4096L*1024L*1024L;
+
+    struct Task
+    {
+        std::function<void()> f;
+        long                  nbytes;
+    };
+
+    //
+    // The tasks are numbered in the order they are submitted.  An
+    // OnComplete function is due when the tasks up to its ticket are done.
+    //
+    struct Callback
+    {
+        long                  ticket;
+        std::function<void()> f;
+    };
+
+    std::thread             io_thread;
+    std::mutex              mtx;
+    std::condition_variable cv;
+    std::deque<Task>        queue;
+    bool                    stop      = false;
+    long                    submitted = 0;
+    long                    completed = 0;
+    long                    staged    = 0;
+    std::string             error_msg;
+
+    std::deque<Callback>    callbacks;
+
+    void
+    Work ()
+    {
+        for (;;)
+        {
+            Task task;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [] { return stop || !queue.empty(); });
+                if (queue.empty()) return;
+                task = std::move(queue.front());
+                queue.pop_front();
+            }
+
+            std::string msg;
+            try {
+                task.f();
+            } catch (const std::exception& e) {
+                msg = e.what();
+            }
+            task.f = nullptr;  // free the staging buffer before counting it out
+
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                ++completed;
+                staged -= task.nbytes;
+                if (!msg.empty() && error_msg.empty()) {
+                    error_msg = msg;
+                }
+            }
+            cv.notify_all();
+        }
+    }
+
+    //! Abort if a task failed.  mtx must be held.
+    void
+    CheckError ()
+    {
+        if (!error_msg.empty()) {
+            amrex::Abort("AsyncOut: " + error_msg);
+        }
+    }
+}
+
+void
+Initialize ()
+{
+    ParmParse pp("amrex");
+    pp.query("async_out", use_async_out);
+
+    long max_mb = max_bytes/(1024L*1024L);
+    pp.query("async_out_max_mb", max_mb);
+    max_bytes = (max_mb < 0) ? -1 : max_mb*1024L*1024L;
+
+    amrex::ExecOnFinalize(AsyncOut::Finalize);
+}
+
+void
+Finalize ()
+{
+    Finish();
+
+    if (io_thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stop = true;
+        }
+        cv.notify_all();
+        io_thread.join();
+    }
+
+    stop      = false;
+    submitted = 0;
+    completed = 0;
+    staged    = 0;
+    use_async_out = false;
+}
+
+bool
+UseAsyncOut ()
+{
+    return use_async_out;
+}
+
+void
+Reserve (long nbytes)
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [nbytes] {
+        return staged == 0 || max_bytes < 0 || staged + nbytes <= max_bytes;
+    });
+    CheckError();
+    staged += nbytes;
+}
+
+void
+Submit (std::function<void()>&& task, long nbytes)
+{
+    if (!io_thread.joinable()) {
+        io_thread = std::thread(Work);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        queue.push_back(Task{std::move(task), nbytes});
+        ++submitted;
+    }
+    cv.notify_all();
+}
+
+void
+OnComplete (std::function<void()>&& f)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    callbacks.push_back(Callback{submitted, std::move(f)});
+}
+
+void
+Wait ()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [] { return completed == submitted; });
+    CheckError();
+}
+
+bool
+Test ()
+{
+    int ndue = 0;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        CheckError();
+        for (const auto& cb : callbacks) {
+            if (cb.ticket > completed) break;
+            ++ndue;
+        }
+    }
+    //
+    // The callbacks are registered collectively, so the k-th one is the
+    // same on all the processes.
+    //
+    ParallelDescriptor::ReduceIntMin(ndue);
+
+    for (int i = 0; i < ndue; ++i) {
+        std::function<void()> f = std::move(callbacks.front().f);
+        callbacks.pop_front();
+        f();
+    }
+
+    return callbacks.empty();
+}
+
+void
+Finish ()
+{
+    Wait();
+    //
+    // The other processes may still be writing to the files of this one.
+    //
+    ParallelDescriptor::Barrier("AsyncOut::Finish");
+
+    while (!callbacks.empty()) {
+        std::function<void()> f = std::move(callbacks.front().f);
+        callbacks.pop_front();
+        f();
+    }
+}
+
+}
+}
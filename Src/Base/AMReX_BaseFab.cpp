@@ -4,9 +4,11 @@
 #include <AMReX_BaseFab.H>
 #include <AMReX_BArena.H>
 #include <AMReX_CArena.H>
+#include <AMReX_PArena.H>
 
 #if !defined(BL_NO_FORT)
 #include <AMReX_BaseFab_f.H>
+#include <AMReX_BaseFabSIMD.H>
 #endif
 
 #ifdef BL_MEM_PROFILING
@@ -20,6 +22,8 @@ long private_total_bytes_allocated_in_fabs_hwm = 0L;
 long private_total_cells_allocated_in_fabs     = 0L;
 long private_total_cells_allocated_in_fabs_hwm = 0L;
 
+bool BaseFab_cxx_kernels = true;
+
 int BF_init::m_cnt = 0;
 
 namespace
@@ -33,7 +37,9 @@ BF_init::BF_init ()
     {
         BL_ASSERT(the_arena == 0);
 
-#if defined(BL_COALESCE_FABS)
+#if defined(BL_POOL_FABS)
+        the_arena = new PArena;
+#elif defined(BL_COALESCE_FABS)
         the_arena = new CArena;
 #else
         the_arena = new BArena;
@@ -178,6 +184,11 @@ BaseFab<Real>::performCopy (const BaseFab<Real>& src,
     BL_ASSERT(srccomp >= 0 && srccomp+numcomp <= src.nComp());
     BL_ASSERT(destcomp >= 0 && destcomp+numcomp <= nComp());
 
+    if (BaseFab_cxx_kernels) {
+        simd::fabCopy(*this, destbox, destcomp, src, srcbox, srccomp, numcomp);
+        return;
+    }
+
     amrex_fort_fab_copy(AMREX_ARLIM_3D(destbox.loVect()), AMREX_ARLIM_3D(destbox.hiVect()),
 		  BL_TO_FORTRAN_N_3D(*this,destcomp),
 		  BL_TO_FORTRAN_N_3D(src,srccomp), AMREX_ARLIM_3D(srcbox.loVect()),
@@ -241,6 +252,11 @@ BaseFab<Real>::performSetVal (Real       val,
     BL_ASSERT(domain.contains(bx));
     BL_ASSERT(comp >= 0 && comp + ncomp <= nvar);
 
+    if (BaseFab_cxx_kernels) {
+        simd::fabSetVal(*this, bx, comp, ncomp, val);
+        return;
+    }
+
     amrex_fort_fab_setval(AMREX_ARLIM_3D(bx.loVect()), AMREX_ARLIM_3D(bx.hiVect()),
 		    BL_TO_FORTRAN_N_3D(*this,comp), &ncomp,
 		    &val);
@@ -286,6 +302,12 @@ BaseFab<Real>::norm (const Box& bx,
 
     Real nrm = 0.0;
 
+    if (BaseFab_cxx_kernels && (p == 0 || p == 1))
+    {
+        return (p == 0) ? simd::fabNorm0(*this, bx, comp, ncomp)
+                        : simd::fabNorm1(*this, bx, comp, ncomp);
+    }
+
     if (p == 0 || p == 1)
     {
 	nrm = amrex_fort_fab_norm(AMREX_ARLIM_3D(bx.loVect()), AMREX_ARLIM_3D(bx.hiVect()),
@@ -309,6 +331,10 @@ BaseFab<Real>::sum (const Box& bx,
     BL_ASSERT(domain.contains(bx));
     BL_ASSERT(comp >= 0 && comp + ncomp <= nvar);
 
+    if (BaseFab_cxx_kernels) {
+        return simd::fabSum(*this, bx, comp, ncomp);
+    }
+
     return amrex_fort_fab_sum(AMREX_ARLIM_3D(bx.loVect()), AMREX_ARLIM_3D(bx.hiVect()),
 			BL_TO_FORTRAN_N_3D(*this,comp), &ncomp);
 }
@@ -329,6 +355,11 @@ BaseFab<Real>::plus (const BaseFab<Real>& src,
     BL_ASSERT(srccomp >= 0 && srccomp+numcomp <= src.nComp());
     BL_ASSERT(destcomp >= 0 && destcomp+numcomp <= nComp());
 
+    if (BaseFab_cxx_kernels) {
+        simd::fabPlus(*this, destbox, destcomp, src, srcbox, srccomp, numcomp);
+        return *this;
+    }
+
     amrex_fort_fab_plus(AMREX_ARLIM_3D(destbox.loVect()), AMREX_ARLIM_3D(destbox.hiVect()),
 		  BL_TO_FORTRAN_N_3D(*this,destcomp),
 		  BL_TO_FORTRAN_N_3D(src,srccomp), AMREX_ARLIM_3D(srcbox.loVect()),
@@ -353,6 +384,11 @@ BaseFab<Real>::mult (const BaseFab<Real>& src,
     BL_ASSERT(srccomp >= 0 && srccomp+numcomp <= src.nComp());
     BL_ASSERT(destcomp >= 0 && destcomp+numcomp <= nComp());
 
+    if (BaseFab_cxx_kernels) {
+        simd::fabMult(*this, destbox, destcomp, src, srcbox, srccomp, numcomp);
+        return *this;
+    }
+
     amrex_fort_fab_mult(AMREX_ARLIM_3D(destbox.loVect()), AMREX_ARLIM_3D(destbox.hiVect()),
 		  BL_TO_FORTRAN_N_3D(*this,destcomp),
 		  BL_TO_FORTRAN_N_3D(src,srccomp), AMREX_ARLIM_3D(srcbox.loVect()),
@@ -377,6 +413,11 @@ BaseFab<Real>::saxpy (Real a, const BaseFab<Real>& src,
     BL_ASSERT( srccomp >= 0 &&  srccomp+numcomp <= src.nComp());
     BL_ASSERT(destcomp >= 0 && destcomp+numcomp <=     nComp());
 
+    if (BaseFab_cxx_kernels) {
+        simd::fabSaxpy(*this, destbox, destcomp, a, src, srcbox, srccomp, numcomp);
+        return *this;
+    }
+
     amrex_fort_fab_saxpy(AMREX_ARLIM_3D(destbox.loVect()), AMREX_ARLIM_3D(destbox.hiVect()),
 		   BL_TO_FORTRAN_N_3D(*this,destcomp),
 		   &a,
@@ -402,6 +443,11 @@ BaseFab<Real>::xpay (Real a, const BaseFab<Real>& src,
     BL_ASSERT( srccomp >= 0 &&  srccomp+numcomp <= src.nComp());
     BL_ASSERT(destcomp >= 0 && destcomp+numcomp <=     nComp());
 
+    if (BaseFab_cxx_kernels) {
+        simd::fabXpay(*this, destbox, destcomp, a, src, srcbox, srccomp, numcomp);
+        return *this;
+    }
+
     amrex_fort_fab_xpay(AMREX_ARLIM_3D(destbox.loVect()), AMREX_ARLIM_3D(destbox.hiVect()),
 		  BL_TO_FORTRAN_N_3D(*this,destcomp),
 		  &a,
@@ -529,6 +575,11 @@ BaseFab<Real>::linComb (const BaseFab<Real>& f1,
     BL_ASSERT(comp2 >= 0 && comp2+numcomp <= f2.nComp());
     BL_ASSERT(comp  >= 0 && comp +numcomp <=    nComp());
 
+    if (BaseFab_cxx_kernels) {
+        simd::fabLinComb(*this, b, comp, alpha, f1, b1, comp1, beta, f2, b2, comp2, numcomp);
+        return *this;
+    }
+
     amrex_fort_fab_lincomb(AMREX_ARLIM_3D(b.loVect()), AMREX_ARLIM_3D(b.hiVect()),
 		     BL_TO_FORTRAN_N_3D(*this,comp),
 		     &alpha, BL_TO_FORTRAN_N_3D(f1,comp1), AMREX_ARLIM_3D(b1.loVect()),
@@ -550,6 +601,10 @@ BaseFab<Real>::dot (const Box& xbx, int xcomp,
     BL_ASSERT(xcomp >= 0 && xcomp+numcomp <=   nComp());
     BL_ASSERT(ycomp >= 0 && ycomp+numcomp <= y.nComp());
 
+    if (BaseFab_cxx_kernels) {
+        return simd::fabDot(*this, xbx, xcomp, y, ybx, ycomp, numcomp);
+    }
+
     return amrex_fort_fab_dot(AMREX_ARLIM_3D(xbx.loVect()), AMREX_ARLIM_3D(xbx.hiVect()),
 			BL_TO_FORTRAN_N_3D(*this,xcomp),
 			BL_TO_FORTRAN_N_3D(y,ycomp), AMREX_ARLIM_3D(ybx.loVect()),
@@ -5,6 +5,13 @@
 #include <AMReX_Utility.H>
 #include <AMReX_MFIter.H>
 #include <AMReX_BaseFab.H>
+#include <AMReX_BLProfiler.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_NodeShared.H>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
 
 #ifdef BL_MEM_PROFILING
 #include <AMReX_MemProfiler.H>
@@ -16,6 +23,99 @@
 
 namespace amrex {
 
+namespace {
+    //
+    // The low ends of the pieces BoxList::maxSize chops [lo,hi] into,
+    // followed by hi+1.
+    //
+    Vector<int>
+    LatticeCuts (int lo, int hi, int chunk)
+    {
+        Vector<int> cut;
+        cut.push_back(hi+1);
+
+        const int len = hi - lo + 1;
+        if (len > chunk)
+        {
+            int ratio = 1;
+            int bs    = chunk;
+            int nlen  = len;
+            while ((bs%2 == 0) && (nlen%2 == 0))
+            {
+                ratio *= 2;
+                bs    /= 2;
+                nlen  /= 2;
+            }
+            const int numblk = nlen/bs + (nlen%bs ? 1 : 0);
+            const int sz     = nlen/numblk;
+            const int extra  = nlen%numblk;
+            for (int k = 0; k < numblk-1; k++)
+            {
+                const int ksize = (k < extra ? sz+1 : sz) * ratio;
+                cut.push_back(cut.back() - ksize);
+            }
+        }
+
+        cut.push_back(lo);
+        std::reverse(cut.begin(), cut.end());
+        return cut;
+    }
+
+    bool
+    SameBoxes (const BARef& a, const BARef& b)
+    {
+        if (a.m_lattice && b.m_lattice) {
+            return a.m_lattice_cut == b.m_lattice_cut && a.m_lattice_except == b.m_lattice_except;
+        } else if (!a.m_lattice && !b.m_lattice && !a.m_shared_abox && !b.m_shared_abox) {
+            return a.m_abox == b.m_abox;
+        } else {
+            const long N = a.numBoxes();
+            if (N != b.numBoxes()) return false;
+            for (long i = 0; i < N; ++i) {
+                if (a.getBox(i) != b.getBox(i)) return false;
+            }
+            return true;
+        }
+    }
+
+    //
+    // Sort in parallel: the chunks are sorted by the threads and then
+    // merged pairwise.
+    //
+    template <class T>
+    void
+    ParallelSort (Vector<T>& v)
+    {
+        const int N = v.size();
+#ifdef _OPENMP
+        const int nchunks = omp_in_parallel() ? 1 : std::min(omp_get_max_threads(), std::max(N/4096,1));
+        if (nchunks > 1)
+        {
+            Vector<long> b(nchunks+1);
+            for (int i = 0; i <= nchunks; ++i) {
+                b[i] = static_cast<long>(N) * i / nchunks;
+            }
+#pragma omp parallel for
+            for (int i = 0; i < nchunks; ++i) {
+                std::sort(v.begin()+b[i], v.begin()+b[i+1]);
+            }
+            for (int w = 1; w < nchunks; w *= 2)
+            {
+#pragma omp parallel for
+                for (int i = 0; i < nchunks; i += 2*w) {
+                    if (i+w < nchunks) {
+                        std::inplace_merge(v.begin()+b[i], v.begin()+b[i+w],
+                                           v.begin()+b[std::min(i+2*w,nchunks)]);
+                    }
+                }
+            }
+            return;
+        }
+#endif
+        std::sort(v.begin(), v.end());
+    }
+}
+
 #ifdef BL_MEM_PROFILING
 int  BARef::numboxarrays         = 0;
 int  BARef::numboxarrays_hwm     = 0;
@@ -27,6 +127,7 @@ long BARef::total_hash_bytes_hwm = 0L;
 
 bool    BARef::initialized = false;
 bool BoxArray::initialized = false;
+int  BoxArray::compact_min_boxes = 4096;
 
 namespace {
     const int bl_ignore_max = 100000;
@@ -74,7 +175,13 @@ BARef::BARef (std::istream& is)
 }
 
 BARef::BARef (const BARef& rhs) 
-    : m_abox(rhs.m_abox) // don't copy hash
+    : m_abox(rhs.m_shared_abox
+             ? Vector<Box>(rhs.m_shared_abox, rhs.m_shared_abox+rhs.m_shared_size)
+             : rhs.m_abox), // don't copy hash
+      m_lattice(rhs.m_lattice),
+      m_lattice_size(rhs.m_lattice_size),
+      m_lattice_cut(rhs.m_lattice_cut),
+      m_lattice_except(rhs.m_lattice_except)
 {
 #ifdef BL_MEM_PROFILING
     updateMemoryUsage_box(1);
@@ -83,6 +190,9 @@ BARef::BARef (const BARef& rhs)
 
 BARef::~BARef ()
 {
+    if (m_shared_id >= 0) {
+        NodeShared::Release(m_shared_id);
+    }
 #ifdef BL_MEM_PROFILING
     updateMemoryUsage_box(-1);
     updateMemoryUsage_hash(-1);
@@ -153,6 +263,135 @@ BARef::resize (long n) {
     m_abox.resize(n);
     hash.clear();
     has_hashmap = false;
+    bvh_index.clear();
+    bvh_node.clear();
+    bvh_level.clear();
+    has_bvh = false;
+#ifdef BL_MEM_PROFILING
+    updateMemoryUsage_box(1);
+#endif
+}
+
+void
+BARef::setBox (int i, const Box& bx)
+{
+    unshare();
+    if (m_lattice) {
+        m_lattice_except[i] = bx;
+    } else {
+        m_abox[i] = bx;
+    }
+}
+
+Box
+BARef::latticeBox (int i) const
+{
+    BL_ASSERT(m_lattice && i >= 0 && i < m_lattice_size);
+
+    if (!m_lattice_except.empty()) {
+        auto it = m_lattice_except.find(i);
+        if (it != m_lattice_except.end()) return it->second;
+    }
+    //
+    // maxSize chops the box in direction 0, then each of the pieces in
+    // direction 1, and so on.  The low piece of a box keeps its place in
+    // the list, and the others are appended from the high end down.
+    //
+    long nprev[AMREX_SPACEDIM];
+    nprev[0] = 1;
+    for (int d = 1; d < AMREX_SPACEDIM; ++d) {
+        nprev[d] = nprev[d-1] * (m_lattice_cut[d-1].size()-1);
+    }
+
+    long idx = i;
+    IntVect lo, hi;
+    for (int d = AMREX_SPACEDIM-1; d >= 0; --d)
+    {
+        const int n = m_lattice_cut[d].size() - 1;
+        int q = 0;
+        if (idx >= nprev[d]) {
+            const long r = idx - nprev[d];
+            idx = r / (n-1);
+            q   = n - 1 - static_cast<int>(r % (n-1));
+        }
+        lo[d] = m_lattice_cut[d][q];
+        hi[d] = m_lattice_cut[d][q+1] - 1;
+    }
+    return Box(lo, hi);
+}
+
+int
+BARef::latticeIndex (const IntVect& q) const
+{
+    long idx = 0, nprev = 1;
+    for (int d = 0; d < AMREX_SPACEDIM; ++d)
+    {
+        const int n = m_lattice_cut[d].size() - 1;
+        if (q[d] > 0) {
+            idx = nprev + idx*(n-1) + (n-1-q[d]);
+        }
+        nprev *= n;
+    }
+    return idx;
+}
+
+void
+BARef::unshare (bool release)
+{
+    if (m_shared_abox == nullptr) return;
+
+    m_abox.assign(m_shared_abox, m_shared_abox+m_shared_size);
+    if (m_shared_bvh_node) {
+        bvh_node.assign(m_shared_bvh_node, m_shared_bvh_node+bvh_level.back());
+        bvh_index.assign(m_shared_bvh_index, m_shared_bvh_index+m_shared_size);
+    }
+#ifdef BL_MEM_PROFILING
+    updateMemoryUsage_box(1);
+#endif
+    if (release) {
+        NodeShared::Release(m_shared_id);
+    }
+    m_shared_abox      = nullptr;
+    m_shared_size      = 0;
+    m_shared_bvh_node  = nullptr;
+    m_shared_bvh_index = nullptr;
+    m_shared_id        = -1;
+}
+
+Vector<long>
+BARef::bvhLevels (long n)
+{
+    Vector<long> level(1, 0);
+    long m = (n + bvh_leaf_size - 1) / bvh_leaf_size;
+    while (m > 0)
+    {
+        level.push_back(level.back() + m);
+        m = (m > 1) ? (m + 1) / 2 : 0;
+    }
+    return level;
+}
+
+void
+BARef::unlattice ()
+{
+    if (!m_lattice) return;
+
+#ifdef BL_MEM_PROFILING
+    updateMemoryUsage_box(-1);
+#endif
+    m_abox.resize(m_lattice_size);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (long i = 0; i < m_lattice_size; ++i) {
+        m_abox[i] = latticeBox(i);
+    }
+    m_lattice = false;
+    m_lattice_size = 0;
+    for (auto& c : m_lattice_cut) {
+        Vector<int>().swap(c);
+    }
+    m_lattice_except.clear();
 #ifdef BL_MEM_PROFILING
     updateMemoryUsage_box(1);
 #endif
@@ -231,6 +470,13 @@ BoxArray::Initialize ()
     if (!initialized) {
 	initialized = true;
 	BARef::Initialize();
+
+        ParmParse pp("boxarray");
+        pp.query("compact_min_boxes", compact_min_boxes);
+
+        bool node_shared = false;
+        pp.query("node_shared", node_shared);
+        NodeShared::Initialize(node_shared);
     }
 
     amrex::ExecOnFinalize(BoxArray::Finalize);
@@ -239,6 +485,7 @@ BoxArray::Initialize ()
 void
 BoxArray::Finalize ()
 {
+    NodeShared::Finalize();
     initialized = false;
 }
 
@@ -463,13 +710,13 @@ BoxArray::operator== (const BoxArray& rhs) const
 {
     if (m_simple && rhs.m_simple) {
         return m_typ == rhs.m_typ && m_crse_ratio == rhs.m_crse_ratio &&
-            (m_ref == rhs.m_ref || m_ref->m_abox == rhs.m_ref->m_abox);
+            (m_ref == rhs.m_ref || SameBoxes(*m_ref, *rhs.m_ref));
     } else {
         return m_simple == rhs.m_simple
             && m_typ == rhs.m_typ
             && m_crse_ratio == rhs.m_crse_ratio
             && m_transformer->equal(*rhs.m_transformer)
-            && (m_ref == rhs.m_ref || m_ref->m_abox == rhs.m_ref->m_abox);
+            && (m_ref == rhs.m_ref || SameBoxes(*m_ref, *rhs.m_ref));
     }
 }
 
@@ -483,7 +730,7 @@ bool
 BoxArray::CellEqual (const BoxArray& rhs) const
 {
     return m_crse_ratio == rhs.m_crse_ratio
-        && (m_ref == rhs.m_ref || m_ref->m_abox == rhs.m_ref->m_abox);
+        && (m_ref == rhs.m_ref || SameBoxes(*m_ref, *rhs.m_ref));
 }
 
 BoxArray&
@@ -495,6 +742,26 @@ BoxArray::maxSize (int block_size)
 BoxArray&
 BoxArray::maxSize (const IntVect& block_size)
 {
+    if (compact_min_boxes >= 0 && size() == 1 && m_simple && m_crse_ratio == 1
+        && m_typ.cellCentered() && m_ref->getBox(0).ok())
+    {
+        const Box& bx = m_ref->getBox(0);
+        Array<Vector<int>,AMREX_SPACEDIM> cut;
+        long n = 1;
+        for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+            cut[d] = LatticeCuts(bx.smallEnd(d), bx.bigEnd(d), block_size[d]);
+            n *= cut[d].size() - 1;
+        }
+        if (n > 1 && n >= compact_min_boxes && n <= std::numeric_limits<int>::max())
+        {
+            m_ref = std::make_shared<BARef>();
+            m_ref->m_lattice = true;
+            m_ref->m_lattice_size = n;
+            m_ref->m_lattice_cut = std::move(cut);
+            return *this;
+        }
+    }
+
     BoxList blst(*this);
     blst.maxSize(block_size);
     const int N = blst.size();
@@ -766,7 +1033,7 @@ BoxArray::set (int        i,
         m_typ = ibox.ixType();
         m_transformer->setIxType(m_typ);
     }
-    m_ref->m_abox[i] = amrex::enclosedCells(ibox);
+    m_ref->setBox(i, amrex::enclosedCells(ibox));
 }
 
 Box
@@ -907,14 +1174,14 @@ BoxArray::minimalBox () const
 #endif
 	if (use_single_thread)
 	{
-	    minbox = m_ref->m_abox[0];
+	    minbox = m_ref->getBox(0);
 	    for (int i = 1; i < N; ++i) {
-		minbox.minBox(m_ref->m_abox[i]);
+		minbox.minBox(m_ref->getBox(i));
 	    }
 	}
 	else
 	{
-	    Vector<Box> bxs(nthreads, m_ref->m_abox[0]);
+	    Vector<Box> bxs(nthreads, m_ref->getBox(0));
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
@@ -926,7 +1193,7 @@ BoxArray::minimalBox () const
 #pragma omp for
 #endif
 		for (int i = 0; i < N; ++i) {
-		    bxs[tid].minBox(m_ref->m_abox[i]);
+		    bxs[tid].minBox(m_ref->getBox(i));
 		}
 	    }
 	    minbox = bxs[0];
@@ -957,16 +1224,17 @@ BoxArray::minimalBox (int& npts_avg_box) const
 #endif
 	if (use_single_thread)
 	{
-	    minbox = m_ref->m_abox[0];
-            npts_tot += m_ref->m_abox[0].numPts();
+	    minbox = m_ref->getBox(0);
+            npts_tot += minbox.numPts();
 	    for (int i = 1; i < N; ++i) {
-		minbox.minBox(m_ref->m_abox[i]);
-                npts_tot += m_ref->m_abox[i].numPts();
+                const Box& b = m_ref->getBox(i);
+		minbox.minBox(b);
+                npts_tot += b.numPts();
 	    }
 	}
 	else
 	{
-	    Vector<Box> bxs(nthreads, m_ref->m_abox[0]);
+	    Vector<Box> bxs(nthreads, m_ref->getBox(0));
 #ifdef _OPENMP
 #pragma omp parallel reduction(+:npts_tot)
 #endif
@@ -978,8 +1246,9 @@ BoxArray::minimalBox (int& npts_avg_box) const
 #pragma omp for
 #endif
 		for (int i = 0; i < N; ++i) {
-		    bxs[tid].minBox(m_ref->m_abox[i]);
-                    long npts = m_ref->m_abox[i].numPts();
+                    const Box& b = m_ref->getBox(i);
+		    bxs[tid].minBox(b);
+                    long npts = b.numPts();
                     npts_tot += npts;
 		}
 	    }
@@ -1060,6 +1329,63 @@ BoxArray::intersections (const Box&                         bx,
 {
   // This is called too many times BL_PROFILE("BoxArray::intersections()");
 
+    isects.resize(0);
+
+    if (empty()) return;
+
+    BL_ASSERT(bx.ixType() == ixType());
+
+    const Box& q = queryRegion(bx, ng);
+
+    bool super_simple = m_simple && m_crse_ratio==1 && m_typ.cellCentered();
+
+    query(q, [&] (int index) -> bool
+    {
+        const Box& ibox = super_simple ? m_ref->getBox(index) : (*this)[index];
+        const Box& isect = bx & amrex::grow(ibox,ng);
+
+        if (isect.ok())
+        {
+            isects.push_back(std::pair<int,Box>(index,isect));
+            return first_only;
+        }
+        return false;
+    });
+
+    if (!first_only) {
+        std::sort(isects.begin(), isects.end(),
+                  [] (const std::pair<int,Box>& a, const std::pair<int,Box>& b)
+                  { return a.first < b.first; });
+    }
+}
+
+void
+BoxArray::intersections (const Vector<Box>&                          bxs,
+                         Vector<std::vector< std::pair<int,Box> > >& isects,
+                         bool                                        first_only,
+                         const IntVect&                              ng) const
+{
+    BL_PROFILE("BoxArray::intersections(Vector<Box>)");
+
+    buildBVH();
+
+    const int N = bxs.size();
+    isects.resize(N);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic,64)
+#endif
+    for (int i = 0; i < N; ++i) {
+        intersections(bxs[i], isects[i], first_only, ng);
+    }
+}
+
+void
+BoxArray::hashIntersections (const Box&                         bx,
+                             std::vector< std::pair<int,Box> >& isects,
+                             bool                               first_only,
+                             const IntVect&                     ng) const
+{
     BARef::HashType& BoxHashMap = getHashMap();
 
     isects.resize(0);
@@ -1130,61 +1456,35 @@ BoxArray::complementIn (BoxList& bl, const Box& bx) const
 
     if (!empty()) 
     {
-	BARef::HashType& BoxHashMap = getHashMap();
-
 	BL_ASSERT(bx.ixType() == ixType());
 
-	Box gbx = bx;
-
-	IntVect glo = gbx.smallEnd();
-	IntVect ghi = gbx.bigEnd();
-	const IntVect& doilo = getDoiLo();
-	const IntVect& doihi = getDoiHi();
-
-	gbx.setSmall(glo - doihi).setBig(ghi + doilo);
-        gbx.refine(m_crse_ratio).coarsen(m_ref->crsn);
-	
-        const IntVect& sm = amrex::max(gbx.smallEnd()-1, m_ref->bbox.smallEnd());
-        const IntVect& bg = amrex::min(gbx.bigEnd(),     m_ref->bbox.bigEnd());
+        const Box& q = queryRegion(bx, IntVect::TheZeroVector());
 
-        Box cbx(sm,bg);
-        cbx.normalize();
-
-	if (!cbx.intersects(m_ref->bbox)) return;
+        bool super_simple = m_simple && m_crse_ratio==1 && m_typ.cellCentered();
 
-	auto TheEnd = BoxHashMap.cend();
+        std::vector<int> candidates;
+        query(q, [&] (int index) -> bool { candidates.push_back(index); return false; });
+        std::sort(candidates.begin(), candidates.end());
 
         BoxList newbl(bl.ixType());
         newbl.reserve(bl.capacity());
         BoxList newdiff(bl.ixType());
 
-        bool super_simple = m_simple && m_crse_ratio==1 && m_typ.cellCentered();
-        auto& abox = m_ref->m_abox;
-
-	for (IntVect iv = cbx.smallEnd(), End = cbx.bigEnd(); 
-	     iv <= End && bl.isNotEmpty(); 
-	     cbx.next(iv))
+        for (int i = 0, N = candidates.size(); i < N && bl.isNotEmpty(); ++i)
         {
-            auto it = BoxHashMap.find(iv);
+            const int index = candidates[i];
+            const Box& isect = (super_simple)
+                ? (bx & m_ref->getBox(index))
+                : (bx & (*this)[index]);
 
-            if (it != TheEnd)
+            if (isect.ok())
             {
-                for (const int index : it->second)
-                {
-                    const Box& isect = (super_simple)
-                        ? (bx & abox[index])
-                        : (bx & (*this)[index]);
-
-                    if (isect.ok())
-                    {
-                        newbl.clear();
-                        for (const Box& b : bl) {
-                            amrex::boxDiff(newdiff, b, isect);
-                            newbl.join(newdiff);
-                        }
-                        bl.swap(newbl);
-                    }
+                newbl.clear();
+                for (const Box& b : bl) {
+                    amrex::boxDiff(newdiff, b, isect);
+                    newbl.join(newdiff);
                 }
+                bl.swap(newbl);
             }
         }
     }
@@ -1201,6 +1501,15 @@ BoxArray::clear_hash_bin () const
         m_ref->hash.clear();
         m_ref->has_hashmap = false;
     }
+    if (m_ref->has_bvh)
+    {
+        m_ref->bvh_index.clear();
+        m_ref->bvh_node.clear();
+        m_ref->bvh_level.clear();
+        m_ref->m_shared_bvh_node = nullptr;
+        m_ref->m_shared_bvh_index = nullptr;
+        m_ref->has_bvh = false;
+    }
 }
 
 //
@@ -1239,7 +1548,7 @@ BoxArray::removeOverlap (bool simplify)
     {
         if (m_ref->m_abox[i].ok())
         {
-            intersections(m_ref->m_abox[i],isects);
+            hashIntersections(m_ref->m_abox[i],isects,false,IntVect::TheZeroVector());
 
             for (int j = 0, N = isects.size(); j < N; j++)
             {
@@ -1315,6 +1624,266 @@ BoxArray::getDoiHi () const
     return m_simple ?           m_typ.ixType() : m_transformer->doiHi();
 }
 
+Box
+BoxArray::queryRegion (const Box& bx, const IntVect& ng) const
+{
+    const Box& gbx = amrex::grow(bx,ng);
+    //
+    // A cell-centered box, so that refining it covers all the fine cells.
+    //
+    Box q(gbx.smallEnd() - getDoiHi(), gbx.bigEnd() + getDoiLo());
+    q.refine(m_crse_ratio);
+    return q;
+}
+
+template <class F>
+void
+BoxArray::bvhQuery (const Box& q, F f) const
+{
+    const auto& level = m_ref->bvh_level;
+    const Box*  node  = m_ref->bvhNode();
+    const int*  index = m_ref->bvhIndex();
+
+    if (level.size() < 2 || !q.ok()) return;
+
+    const int L = BARef::bvh_leaf_size;
+    const int N = m_ref->numBoxes();
+
+    //
+    // Depth-first, so the stack holds at most one node per level plus one.
+    //
+    std::pair<int,int> stack[128];
+    int sp = 0;
+    stack[sp++] = std::make_pair(static_cast<int>(level.size())-2, 0);
+
+    while (sp > 0)
+    {
+        const int lev = stack[--sp].first;
+        const int j   = stack[sp].second;
+
+        if (!node[level[lev]+j].intersects(q)) continue;
+
+        if (lev == 0)
+        {
+            for (int p = j*L, pend = std::min(p+L,N); p < pend; ++p)
+            {
+                const int i = index[p];
+                if (m_ref->getBox(i).intersects(q) && f(i)) return;
+            }
+        }
+        else
+        {
+            if (level[lev-1]+2*j+1 < level[lev]) {
+                stack[sp++] = std::make_pair(lev-1, 2*j+1);
+            }
+            stack[sp++] = std::make_pair(lev-1, 2*j);
+        }
+    }
+}
+
+template <class F>
+void
+BoxArray::latticeQuery (const Box& q, F f) const
+{
+    const auto& cut    = m_ref->m_lattice_cut;
+    const auto& except = m_ref->m_lattice_except;
+
+    if (!q.ok()) return;
+
+    //
+    // The boxes set to something else may reach outside the lattice.
+    //
+    bool inside = true;
+    IntVect qlo, qhi;
+    for (int d = 0; d < AMREX_SPACEDIM && inside; ++d)
+    {
+        const int n = cut[d].size() - 1;
+        inside = q.bigEnd(d) >= cut[d][0] && q.smallEnd(d) < cut[d][n];
+        qlo[d] = std::max(int(std::upper_bound(cut[d].begin(), cut[d].end(), q.smallEnd(d))
+                              - cut[d].begin()) - 1, 0);
+        qhi[d] = std::min(int(std::upper_bound(cut[d].begin(), cut[d].end(), q.bigEnd(d))
+                              - cut[d].begin()) - 1, n-1);
+    }
+
+    if (inside)
+    {
+        const Box qbx(qlo, qhi);
+        for (IntVect iv = qbx.smallEnd(), End = qbx.bigEnd(); iv <= End; qbx.next(iv))
+        {
+            const int i = m_ref->latticeIndex(iv);
+            if (except.empty() || except.count(i) == 0) {
+                if (f(i)) return;
+            }
+        }
+    }
+
+    for (const auto& kv : except) {
+        if (kv.second.intersects(q) && f(kv.first)) return;
+    }
+}
+
+template <class F>
+void
+BoxArray::query (const Box& q, F f) const
+{
+    if (m_ref->m_lattice) {
+        latticeQuery(q, f);
+    } else {
+        buildBVH();
+        bvhQuery(q, f);
+    }
+}
+
+void
+BoxArray::buildBVH () const
+{
+    if (m_ref->m_lattice || m_ref->HasBVH()) return;
+
+#ifdef _OPENMP
+    #pragma omp critical(intersections_lock)
+#endif
+    if (!m_ref->has_bvh)
+    {
+        BL_PROFILE("BoxArray::buildBVH()");
+
+        const BARef& ref = *m_ref;
+        const int N = ref.numBoxes();
+        const int L = BARef::bvh_leaf_size;
+
+        auto join = [] (Box& a, const Box& b) {
+            if (!b.ok()) return;
+            if (a.ok()) { a.minBox(b); } else { a = b; }
+        };
+
+        Box bbox;
+        for (int i = 0; i < N; ++i) {
+            join(bbox, ref.getBox(i));
+        }
+
+        //
+        // Sort the boxes along a Morton curve through their centers.
+        //
+        const int nbits = std::min(64/AMREX_SPACEDIM, 31);
+        int shift = 0;
+        if (bbox.ok()) {
+            while (static_cast<long>(bbox.size().max() >> shift) >= (1L << nbits)) ++shift;
+        }
+        const IntVect lo = bbox.smallEnd();
+
+        Vector<std::pair<std::uint64_t,int> > keys(N);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (int i = 0; i < N; ++i)
+        {
+            const Box& b = ref.getBox(i);
+            const IntVect c = b.ok() ? (b.smallEnd() + (b.bigEnd()-b.smallEnd())/2 - lo) : IntVect::TheZeroVector();
+            std::uint64_t key = 0;
+            for (int k = 0; k < nbits; ++k) {
+                for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+                    key |= static_cast<std::uint64_t>(((c[d] >> shift) >> k) & 1) << (k*AMREX_SPACEDIM + d);
+                }
+            }
+            keys[i] = std::make_pair(key, i);
+        }
+
+        ParallelSort(keys);
+
+        auto& index = ref.bvh_index;
+        auto& node  = ref.bvh_node;
+        auto& level = ref.bvh_level;
+
+        index.resize(N);
+        for (int i = 0; i < N; ++i) {
+            index[i] = keys[i].second;
+        }
+
+        //
+        // Leaves, and then each level bounding pairs of nodes of the one below.
+        //
+        level = BARef::bvhLevels(N);
+        node.assign(level.back(), Box());
+
+        const int nleaves = (N + L - 1) / L;
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (int j = 0; j < nleaves; ++j) {
+            for (int p = j*L, pend = std::min(p+L,N); p < pend; ++p) {
+                join(node[j], ref.getBox(index[p]));
+            }
+        }
+
+        for (int l = 1, nl = level.size()-1; l < nl; ++l)
+        {
+            const long below = level[l-1];
+            const long n     = level[l] - below;
+            const int  m     = level[l+1] - level[l];
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+            for (int j = 0; j < m; ++j) {
+                Box& b = node[level[l]+j];
+                b = node[below+2*j];
+                if (2*j+1 < n) join(b, node[below+2*j+1]);
+            }
+        }
+
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+        m_ref->has_bvh = true;
+    }
+}
+
+void
+BoxArray::ShareOnNode ()
+{
+    if (!NodeShared::Enabled() || m_ref->m_lattice || m_ref->m_shared_abox) return;
+
+    BL_PROFILE("BoxArray::ShareOnNode()");
+
+    BARef& ref = *m_ref;
+    const long N = ref.m_abox.size();
+    const Vector<long> level = BARef::bvhLevels(N);
+    const long nnode = level.back();
+
+    //
+    // Only the first process of the node needs the hierarchy.
+    //
+    if (NodeShared::Rank() == 0) {
+        buildBVH();
+    }
+
+    const std::size_t nbytes = (N + nnode) * sizeof(Box) + N * sizeof(int);
+
+    char* p = NodeShared::Share(nbytes,
+                                [&ref, N, nnode] (char* dst)
+                                {
+                                    Box* b = reinterpret_cast<Box*>(dst);
+                                    std::uninitialized_copy(ref.m_abox.begin(), ref.m_abox.end(), b);
+                                    std::uninitialized_copy(ref.bvh_node.begin(), ref.bvh_node.end(), b+N);
+                                    std::copy(ref.bvh_index.begin(), ref.bvh_index.end(),
+                                              reinterpret_cast<int*>(b+N+nnode));
+                                },
+                                [&ref] () { ref.unshare(false); },
+                                ref.m_shared_id);
+
+    clear_hash_bin();
+
+    const Box* b = reinterpret_cast<const Box*>(p);
+    ref.m_shared_abox       = b;
+    ref.m_shared_size       = N;
+    ref.m_shared_bvh_node   = b + N;
+    ref.m_shared_bvh_index  = reinterpret_cast<const int*>(b+N+nnode);
+    ref.bvh_level           = level;
+    ref.has_bvh             = true;
+#ifdef BL_MEM_PROFILING
+    ref.updateMemoryUsage_box(-1);
+#endif
+    Vector<Box>().swap(ref.m_abox);
+}
+
 BARef::HashType&
 BoxArray::getHashMap () const
 {
@@ -1373,6 +1942,8 @@ BoxArray::uniqify ()
 	auto p = std::make_shared<BARef>(*m_ref);
 	std::swap(m_ref,p);
     }
+    m_ref->unshare();
+    m_ref->unlattice();
     if (m_crse_ratio != 1) {
         const int N = m_ref->m_abox.size();
 #ifdef _OPENMP
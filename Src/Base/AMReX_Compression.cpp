@@ -0,0 +1,199 @@
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <AMReX_BLassert.H>
+#include <AMReX_Compression.H>
+#include <AMReX_Utility.H>
+
+namespace amrex {
+namespace Compression {
+
+namespace
+{
+    //
+    // A compressed message starts with a header whose first byte says
+    // how the rest is stored.  In a packed message, each value is XORed
+    // with one of two predictions: the previous value, or the previous
+    // value plus the previous difference.  A code byte holds the choice
+    // of prediction, the number of significant bytes left and the number
+    // of trailing zero bytes, and is followed by the significant bytes.
+    //
+    constexpr std::size_t compress_header = 8;
+    enum : char { msg_raw = 0, msg_packed = 1 };
+
+    inline int leadingZeroBytes (std::uint64_t x)
+    {
+        int n = 0;
+        while (n < 8 && (x >> 56) == 0) { x <<= 8; ++n; }
+        return n;
+    }
+
+    inline int trailingZeroBytes (std::uint64_t x)
+    {
+        int n = 0;
+        while (n < 7 && (x & 0xff) == 0) { x >>= 8; ++n; }
+        return n;
+    }
+
+    //
+    // The words are little-endian whatever the machine.
+    //
+    inline std::uint64_t load64 (const char* p)
+    {
+        std::uint64_t w;
+        std::memcpy(&w, p, 8);
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+        w = __builtin_bswap64(w);
+#endif
+        return w;
+    }
+
+    inline void store64 (char* p, std::uint64_t w)
+    {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+        w = __builtin_bswap64(w);
+#endif
+        std::memcpy(p, &w, 8);
+    }
+}
+
+std::size_t
+Capacity (std::size_t nbytes)
+{
+    return compress_header + nbytes;
+}
+
+std::uint64_t
+LossyMask (Real tol, int wordsize)
+{
+    if (tol <= 0.0) return ~std::uint64_t(0);
+
+    const int mbits = (wordsize == 8) ? 52 : 23;
+    int drop = static_cast<int>(std::floor(mbits + std::log2(tol)));
+    drop = std::max(0, std::min(drop, mbits));
+
+    if (wordsize == 8) {
+        return ~((std::uint64_t(1) << drop) - 1);
+    } else {
+        const std::uint64_t m = ~((std::uint64_t(1) << drop) - 1) & 0xffffffffULL;
+        return m | (m << 32);
+    }
+}
+
+std::size_t
+Compress (const char* src, std::size_t nbytes, char* dst, std::uint64_t mask)
+{
+    const std::size_t nwords = nbytes / 8;
+    const std::size_t ntail  = nbytes % 8;
+    const char* dst_end = dst + compress_header + nbytes - ntail;
+
+    char* out = dst + compress_header;
+    std::uint64_t prev = 0, diff = 0;
+    std::size_t i = 0;
+    for (; i < nwords && out + 9 <= dst_end; ++i)
+    {
+        const std::uint64_t w = load64(src + 8*i) & mask;
+
+        const std::uint64_t x0 = w ^ prev;
+        const std::uint64_t x1 = w ^ (prev + diff);
+        const int pred = (leadingZeroBytes(x1) + trailingZeroBytes(x1) >
+                          leadingZeroBytes(x0) + trailingZeroBytes(x0)) ? 1 : 0;
+        const std::uint64_t x = (pred) ? x1 : x0;
+
+        int nsig = 0, tz = 0;
+        if (x != 0) {
+            tz   = trailingZeroBytes(x);
+            nsig = 8 - leadingZeroBytes(x) - tz;
+        }
+        *out++ = static_cast<char>((pred << 7) | (nsig << 3) | tz);
+        const std::uint64_t y = x >> (8*tz);
+        for (int b = 0; b < nsig; ++b) {
+            *out++ = static_cast<char>((y >> (8*b)) & 0xff);
+        }
+
+        diff = w - prev;
+        prev = w;
+    }
+
+    if (i < nwords)
+    {
+        //
+        // Not worth it.
+        //
+        dst[0] = msg_raw;
+        std::memcpy(dst + compress_header, src, nbytes);
+        return compress_header + nbytes;
+    }
+
+    dst[0] = msg_packed;
+    std::memcpy(out, src + 8*nwords, ntail);
+    return (out - dst) + ntail;
+}
+
+void
+Decompress (const char* src, std::size_t count, char* dst, std::size_t nbytes)
+{
+    if (src[0] == msg_raw)
+    {
+        BL_ASSERT(count == compress_header + nbytes);
+        std::memcpy(dst, src + compress_header, nbytes);
+        return;
+    }
+
+    BL_ASSERT(src[0] == msg_packed);
+
+    const std::size_t nwords = nbytes / 8;
+    const std::size_t ntail  = nbytes % 8;
+
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(src) + compress_header;
+    std::uint64_t prev = 0, diff = 0;
+    for (std::size_t i = 0; i < nwords; ++i)
+    {
+        const int code = *in++;
+        const int pred = code >> 7;
+        const int nsig = (code >> 3) & 0xf;
+        const int tz   = code & 0x7;
+
+        std::uint64_t y = 0;
+        for (int b = 0; b < nsig; ++b) {
+            y |= std::uint64_t(*in++) << (8*b);
+        }
+        const std::uint64_t w = (y << (8*tz)) ^ ((pred) ? prev + diff : prev);
+        store64(dst + 8*i, w);
+
+        diff = w - prev;
+        prev = w;
+    }
+
+    std::memcpy(dst + 8*nwords, in, ntail);
+    BL_ASSERT(reinterpret_cast<const char*>(in) + ntail == src + count);
+    amrex::ignore_unused(count);
+}
+
+void
+Quantize (Real* p, long n, Real tol)
+{
+    if (tol <= 0.0) return;
+
+#ifdef BL_USE_FLOAT
+    typedef std::uint32_t word_t;
+#else
+    typedef std::uint64_t word_t;
+#endif
+    static_assert(sizeof(word_t) == sizeof(Real), "Quantize: unexpected Real");
+
+    const word_t mask = static_cast<word_t>(LossyMask(tol, sizeof(Real)));
+    for (long i = 0; i < n; ++i)
+    {
+        word_t w;
+        std::memcpy(&w, p + i, sizeof(Real));
+        w &= mask;
+        std::memcpy(p + i, &w, sizeof(Real));
+    }
+}
+
+}
+}
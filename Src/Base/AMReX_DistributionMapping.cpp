@@ -1,6 +1,8 @@
 
 #include <AMReX_BoxArray.H>
 #include <AMReX_MultiFab.H>
+#include <AMReX_LayoutData.H>
+#include <AMReX_ParallelReduce.H>
 #include <AMReX_DistributionMapping.H>
 #include <AMReX_ParmParse.H>
 #include <AMReX_BLProfiler.H>
@@ -10,6 +12,7 @@
 #endif
 #include <AMReX_VisMF.H>
 #include <AMReX_Utility.H>
+#include <AMReX_NodeShared.H>
 
 #include <iostream>
 #include <fstream>
@@ -19,6 +22,7 @@
 #include <map>
 #include <vector>
 #include <queue>
+#include <set>
 #include <algorithm>
 #include <numeric>
 #include <string>
@@ -35,16 +39,154 @@ namespace amrex {
     int    sfc_threshold;
     Real   max_efficiency;
     int    node_size;
+    int    compress_min_boxes;
+    Real   rebalance_efficiency;
+    Real   rebalance_max_move;
+    bool   sfc_by_node;
+    //
+    // Ranks on each node of CommunicatorAll(), if known.  Only made with
+    // sfc_by_node.
+    //
+    Vector<Vector<int> > world_nodes;
 
 // We default to SFC.
 DistributionMapping::Strategy DistributionMapping::m_Strategy = DistributionMapping::SFC;
 
 DistributionMapping::PVMF DistributionMapping::m_BuildMap = 0;
 
-const Vector<int>&
+DistributionMapping::PMapView
 DistributionMapping::ProcessorMap () const
 {
-    return m_ref->m_pmap;
+    Ref& r = *m_ref;
+    if (r.m_shared_pmap) {
+        return PMapView(&r, r.m_shared_pmap, r.m_size);
+    }
+    const Vector<int>& pmap = r.expand();
+    return PMapView(&r, pmap.data(), pmap.size());
+}
+
+const Vector<int>&
+DistributionMapping::Ref::expand ()
+{
+    bool has_pmap = true;
+    if (m_compressed || m_shared_pmap) {
+#ifdef _OPENMP
+#pragma omp atomic read
+#endif
+        has_pmap = m_has_pmap;
+    }
+
+    if (!has_pmap)
+    {
+#ifdef _OPENMP
+#pragma omp critical(dm_expand_lock)
+#endif
+        if (!m_has_pmap)
+        {
+            if (m_shared_pmap) {
+                m_pmap.assign(m_shared_pmap, m_shared_pmap+m_size);
+            } else {
+                m_pmap.resize(m_size);
+                const int nruns = m_run_start.size();
+                for (int k = 0; k < nruns; ++k) {
+                    const int iend = (k+1 < nruns) ? m_run_start[k+1] : m_size;
+                    std::fill(m_pmap.begin()+m_run_start[k], m_pmap.begin()+iend, m_run_proc[k]);
+                }
+            }
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+            m_has_pmap = true;
+        }
+    }
+
+    return m_pmap;
+}
+
+DistributionMapping::Ref::~Ref ()
+{
+    if (m_shared_id >= 0) {
+        NodeShared::Release(m_shared_id);
+    }
+}
+
+void
+DistributionMapping::Ref::unshare (bool release)
+{
+    if (m_shared_pmap == nullptr) return;
+
+    if (!m_has_pmap) {
+        m_pmap.assign(m_shared_pmap, m_shared_pmap+m_size);
+    }
+    if (release) {
+        NodeShared::Release(m_shared_id);
+    }
+    m_shared_pmap = nullptr;
+    m_shared_id   = -1;
+    m_has_pmap    = false;
+}
+
+void
+DistributionMapping::Ref::reset (long n)
+{
+    unshare();
+    m_compressed = false;
+    m_has_pmap   = false;
+    m_size       = 0;
+    Vector<int>().swap(m_run_start);
+    Vector<int>().swap(m_run_proc);
+    m_pmap.resize(n);
+}
+
+void
+DistributionMapping::ShareOnNode ()
+{
+    if (!NodeShared::Enabled() || m_ref->m_compressed || m_ref->m_shared_pmap) return;
+
+    Ref& r = *m_ref;
+    const long N = r.m_pmap.size();
+
+    char* p = NodeShared::Share(N*sizeof(int),
+                                [&r] (char* dst) {
+                                    std::copy(r.m_pmap.begin(), r.m_pmap.end(),
+                                              reinterpret_cast<int*>(dst));
+                                },
+                                [&r] () { r.unshare(false); },
+                                r.m_shared_id);
+
+    r.m_shared_pmap = reinterpret_cast<const int*>(p);
+    r.m_size        = N;
+    r.m_has_pmap    = false;
+    Vector<int>().swap(r.m_pmap);
+}
+
+void
+DistributionMapping::Ref::compress ()
+{
+    const long N = m_pmap.size();
+
+    long nruns = 0;
+    for (long i = 0; i < N; ++i) {
+        if (i == 0 || m_pmap[i] != m_pmap[i-1]) ++nruns;
+    }
+
+    if (m_compressed || 4*nruns >= N) return;
+
+    m_run_start.clear();
+    m_run_proc.clear();
+    m_run_start.reserve(nruns);
+    m_run_proc.reserve(nruns);
+    for (long i = 0; i < N; ++i) {
+        if (i == 0 || m_pmap[i] != m_pmap[i-1]) {
+            m_run_start.push_back(i);
+            m_run_proc.push_back(m_pmap[i]);
+        }
+    }
+
+    m_size = N;
+    Vector<int>().swap(m_pmap);
+    m_has_pmap = false;
+    m_compressed = true;
 }
 
 DistributionMapping::Strategy
@@ -92,7 +234,24 @@ DistributionMapping::SFC_Threshold ()
 bool
 DistributionMapping::operator== (const DistributionMapping& rhs) const
 {
-    return m_ref == rhs.m_ref || m_ref->m_pmap == rhs.m_ref->m_pmap;
+    if (m_ref == rhs.m_ref) return true;
+
+    const Ref& a = *m_ref;
+    const Ref& b = *rhs.m_ref;
+    if (a.m_compressed && b.m_compressed) {
+        return a.m_size == b.m_size && a.m_run_start == b.m_run_start && a.m_run_proc == b.m_run_proc;
+    } else if (a.m_shared_pmap && a.m_shared_pmap == b.m_shared_pmap) {
+        return true;
+    } else if (!a.m_compressed && !b.m_compressed && !a.m_shared_pmap && !b.m_shared_pmap) {
+        return a.m_pmap == b.m_pmap;
+    } else {
+        const long N = size();
+        if (N != rhs.size()) return false;
+        for (long i = 0; i < N; ++i) {
+            if ((*this)[i] != rhs[i]) return false;
+        }
+        return true;
+    }
 }
 
 bool
@@ -101,6 +260,44 @@ DistributionMapping::operator!= (const DistributionMapping& rhs) const
     return !operator==(rhs);
 }
 
+//
+// The ranks of CommunicatorAll() on each node, with the nodes in order of
+// their lowest rank.  Empty if this cannot be determined.  This is a
+// collective operation.
+//
+static
+Vector<Vector<int> >
+WorldNodeLayout ()
+{
+    Vector<Vector<int> > nodes;
+
+#if defined(BL_USE_MPI) && defined(MPI_VERSION) && (MPI_VERSION >= 3)
+    MPI_Comm comm = ParallelContext::CommunicatorAll();
+    const int myproc = ParallelContext::MyProcAll();
+    const int nprocs = ParallelContext::NProcsAll();
+
+    // Each node is identified by the lowest rank on it.
+    int leader = myproc;
+    BL_MPI_REQUIRE( MPI_Bcast(&leader, 1, MPI_INT, 0, ParallelDescriptor::NodeCommunicator()) );
+
+    Vector<int> leaders(nprocs);
+    BL_MPI_REQUIRE( MPI_Allgather(&leader, 1, MPI_INT, leaders.data(), 1, MPI_INT, comm) );
+
+    std::map<int,int> node_of_leader;
+    for (int r = 0; r < nprocs; ++r)
+    {
+        auto it = node_of_leader.find(leaders[r]);
+        if (it == node_of_leader.end()) {
+            it = node_of_leader.insert(std::make_pair(leaders[r], int(nodes.size()))).first;
+            nodes.push_back(Vector<int>());
+        }
+        nodes[it->second].push_back(r);
+    }
+#endif
+
+    return nodes;
+}
+
 void
 DistributionMapping::Initialize ()
 {
@@ -112,6 +309,10 @@ DistributionMapping::Initialize ()
     sfc_threshold    = 0;
     max_efficiency   = 0.9;
     node_size        = 0;
+    compress_min_boxes   = 4096;
+    rebalance_efficiency = 0.9;
+    rebalance_max_move   = 1.0;
+    sfc_by_node          = false;
 
     ParmParse pp("DistributionMapping");
 
@@ -120,6 +321,10 @@ DistributionMapping::Initialize ()
     pp.query("efficiency",       max_efficiency);
     pp.query("sfc_threshold",    sfc_threshold);
     pp.query("node_size",        node_size);
+    pp.query("rebalance_efficiency", rebalance_efficiency);
+    pp.query("rebalance_max_move",   rebalance_max_move);
+    pp.query("sfc_by_node",          sfc_by_node);
+    pp.query("compress_min_boxes",   compress_min_boxes);
 
     std::string theStrategy;
 
@@ -153,6 +358,14 @@ DistributionMapping::Initialize ()
         strategy(m_Strategy);  // default
     }
 
+    //
+    // Made here, where all processes take part, so that building maps
+    // needs no communication.
+    //
+    if (sfc_by_node) {
+        world_nodes = WorldNodeLayout();
+    }
+
     amrex::ExecOnFinalize(DistributionMapping::Finalize);
 
     initialized = true;
@@ -166,6 +379,8 @@ DistributionMapping::Finalize ()
     m_Strategy = SFC;
 
     DistributionMapping::m_BuildMap = 0;
+
+    world_nodes.clear();
 }
 
 void
@@ -360,8 +575,9 @@ DistributionMapping::DistributionMapping (const DistributionMapping& d1,
     :
     m_ref(std::make_shared<Ref>())
 {
-    m_ref->m_pmap = d1.ProcessorMap();
+    const auto& p1 = d1.ProcessorMap();
     const auto& p2 = d2.ProcessorMap();
+    m_ref->m_pmap.assign(p1.begin(), p1.end());
     m_ref->m_pmap.insert(m_ref->m_pmap.end(), p2.begin(), p2.end());
 }
 
@@ -369,22 +585,28 @@ void
 DistributionMapping::define (const BoxArray& boxes,
 			     int nprocs)
 {
-    m_ref->m_pmap.resize(boxes.size());
+    m_ref->reset(boxes.size());
 
     BL_ASSERT(m_BuildMap != 0);
 	
     (this->*m_BuildMap)(boxes,nprocs);
+
+    if (compress_min_boxes >= 0 && size() >= compress_min_boxes) {
+        m_ref->compress();
+    }
 }
 
 void
 DistributionMapping::define (const Vector<int>& pmap)
 {
+    m_ref->reset(0);
     m_ref->m_pmap = pmap;
 }
 
 void
 DistributionMapping::define (Vector<int>&& pmap) noexcept
 {
+    m_ref->reset(0);
     m_ref->m_pmap = std::move(pmap);
 }
 
@@ -451,7 +673,7 @@ void
 DistributionMapping::RoundRobinProcessorMap (int nboxes, int nprocs)
 {
     BL_ASSERT(nboxes > 0);
-    m_ref->m_pmap.resize(nboxes);
+    m_ref->reset(nboxes);
 
     RoundRobinDoIt(nboxes, nprocs);
 }
@@ -460,7 +682,7 @@ void
 DistributionMapping::RoundRobinProcessorMap (const BoxArray& boxes, int nprocs)
 {
     BL_ASSERT(boxes.size() > 0);
-    BL_ASSERT(m_ref->m_pmap.size() == boxes.size());
+    m_ref->reset(boxes.size());
     //
     // Create ordering of boxes from largest to smallest.
     // When we round-robin the boxes we want to go from largest
@@ -494,7 +716,7 @@ DistributionMapping::RoundRobinProcessorMap (const std::vector<long>& wgts,
 {
     BL_ASSERT(wgts.size() > 0);
 
-    m_ref->m_pmap.resize(wgts.size());
+    m_ref->reset(wgts.size());
 
     //
     // Create ordering of boxes from "heaviest" to "lightest".
@@ -830,7 +1052,7 @@ DistributionMapping::KnapSackProcessorMap (const std::vector<long>& wgts,
 {
     BL_ASSERT(wgts.size() > 0);
 
-    m_ref->m_pmap.resize(wgts.size());
+    m_ref->reset(wgts.size());
 
     if (static_cast<int>(wgts.size()) <= nprocs || nprocs < 2)
     {
@@ -851,7 +1073,7 @@ DistributionMapping::KnapSackProcessorMap (const BoxArray& boxes,
 					   int             nprocs)
 {
     BL_ASSERT(boxes.size() > 0);
-    BL_ASSERT(m_ref->m_pmap.size() == boxes.size());
+    m_ref->reset(boxes.size());
 
     if (boxes.size() <= nprocs || nprocs < 2)
     {
@@ -968,6 +1190,132 @@ Distribute (const std::vector<SFCToken>&     tokens,
 #endif
 }
 
+//
+// Split tokens[kbegin:kend) into contiguous pieces, where piece i gets
+// about share[i] of the volume.  v[i] gets the box ids of piece i.
+//
+static
+void
+DistributeByShare (const std::vector<SFCToken>&     tokens,
+                   int                              kbegin,
+                   int                              kend,
+                   const std::vector<Real>&         share,
+                   std::vector< std::vector<int> >& v)
+{
+    const int nbins = share.size();
+    v.assign(nbins, std::vector<int>());
+
+    Real totalvol = 0;
+    for (int K = kbegin; K < kend; ++K) {
+        totalvol += tokens[K].m_vol;
+    }
+
+    int  i   = 0;
+    Real cum = 0;           // volume of the tokens before K
+    Real target = share[0]*totalvol;  // volume up to the end of bin i
+    for (int K = kbegin; K < kend; ++K)
+    {
+        // A token goes to the bin its midpoint falls in.
+        const Real mid = cum + 0.5*tokens[K].m_vol;
+        while (i < nbins-1 && mid > target) {
+            target += share[++i]*totalvol;
+        }
+        v[i].push_back(tokens[K].m_box);
+        cum += tokens[K].m_vol;
+    }
+}
+
+//
+// The local ranks on each node, with the nodes in order of their lowest
+// rank.  Taken from world_nodes, so no communication is needed.  Empty if
+// this cannot be determined.
+//
+static
+Vector<Vector<int> >
+NodeLayout ()
+{
+    Vector<Vector<int> > nodes;
+
+#ifdef BL_USE_MPI
+    for (const Vector<int>& wnode : world_nodes)
+    {
+        Vector<int> node;
+        for (int grank : wnode)
+        {
+            const int lrank = ParallelContext::global_to_local_rank(grank);
+            if (lrank != MPI_UNDEFINED) {
+                node.push_back(lrank);
+            }
+        }
+        if (!node.empty())
+        {
+            std::sort(node.begin(), node.end());
+            nodes.push_back(node);
+        }
+    }
+    std::sort(nodes.begin(), nodes.end(),
+              [] (const Vector<int>& a, const Vector<int>& b) { return a[0] < b[0]; });
+#endif
+
+    return nodes;
+}
+
+//
+// Two levels: the curve is first split among the nodes in proportion to
+// their number of processes, and then each piece among the processes on
+// the node.  Neighboring boxes thus tend to stay on the same node.
+//
+static
+void
+SFCByNodeDoIt (const std::vector<SFCToken>& tokens,
+               const std::vector<long>&     wgts,
+               const Vector<Vector<int> >&  nodes,
+               Vector<int>&                 pmap)
+{
+    BL_PROFILE("DistributionMapping::SFCByNodeDoIt()");
+
+    const int nprocs = ParallelContext::NProcsSub();
+    const int nnodes = nodes.size();
+
+    std::vector<Real> share(nnodes);
+    for (int n = 0; n < nnodes; ++n) {
+        share[n] = Real(nodes[n].size())/nprocs;
+    }
+
+    std::vector< std::vector<int> > vnode;
+    DistributeByShare(tokens, 0, tokens.size(), share, vnode);
+
+    std::vector< std::vector<int> > vproc;
+    long max_wgt = 0, sum_wgt = 0;
+    int K = 0;
+    for (int n = 0; n < nnodes; ++n)
+    {
+        const int nr = nodes[n].size();
+        const int kend = K + vnode[n].size();
+        share.assign(nr, Real(1.0)/nr);
+        DistributeByShare(tokens, K, kend, share, vproc);
+        K = kend;
+
+        for (int r = 0; r < nr; ++r)
+        {
+            const int grank = ParallelContext::local_to_global_rank(nodes[n][r]);
+            long wgt = 0;
+            for (int ibox : vproc[r]) {
+                pmap[ibox] = grank;
+                wgt += wgts[ibox];
+            }
+            max_wgt = std::max(max_wgt, wgt);
+            sum_wgt += wgt;
+        }
+    }
+
+    if (verbose)
+    {
+        amrex::Print() << "SFC by node efficiency: " << (Real(sum_wgt)/(Real(nprocs)*max_wgt))
+                       << " (" << nnodes << " nodes)\n";
+    }
+}
+
 void
 DistributionMapping::SFCProcessorMapDoIt (const BoxArray&          boxes,
                                           const std::vector<long>& wgts,
@@ -1024,6 +1372,17 @@ DistributionMapping::SFCProcessorMapDoIt (const BoxArray&          boxes,
     // Put'm in Morton space filling curve order.
     //
     std::sort(tokens.begin(), tokens.end(), SFCToken::Compare());
+
+    if (sfc_by_node && nteams == nprocs)
+    {
+        const Vector<Vector<int> >& nodes = NodeLayout();
+        const int nnodes = nodes.size();
+        if (nnodes > 1 && nnodes < nprocs)
+        {
+            SFCByNodeDoIt(tokens, wgts, nodes, m_ref->m_pmap);
+            return;
+        }
+    }
     //
     // Split'm up as equitably as possible per team.
     //
@@ -1151,7 +1510,7 @@ DistributionMapping::SFCProcessorMap (const BoxArray& boxes,
 {
     BL_ASSERT(boxes.size() > 0);
 
-    m_ref->m_pmap.resize(boxes.size());
+    m_ref->reset(boxes.size());
 
     if (boxes.size() < sfc_threshold*nprocs)
     {
@@ -1180,7 +1539,7 @@ DistributionMapping::SFCProcessorMap (const BoxArray&          boxes,
     BL_ASSERT(boxes.size() > 0);
     BL_ASSERT(boxes.size() == static_cast<int>(wgts.size()));
 
-    m_ref->m_pmap.resize(wgts.size());
+    m_ref->reset(wgts.size());
 
     if (boxes.size() < sfc_threshold*nprocs)
     {
@@ -1250,7 +1609,7 @@ DistributionMapping::RRSFCProcessorMap (const BoxArray&          boxes,
 {
     BL_ASSERT(boxes.size() > 0);
  
-    m_ref->m_pmap.resize(boxes.size());
+    m_ref->reset(boxes.size());
 
     RRSFCDoIt(boxes,nprocs);
 }
@@ -1389,6 +1748,239 @@ DistributionMapping::makeSFC (const MultiFab& weight,
 }
 
 
+static
+Real
+LoadEfficiency (const Vector<Real>& cost, const Vector<int>& pmap, int nprocs,
+                Vector<Real>* load = nullptr)
+{
+    Vector<Real> ld(nprocs, 0.0);
+    for (int i = 0, N = cost.size(); i < N; ++i) {
+        ld[ParallelContext::global_to_local_rank(pmap[i])] += cost[i];
+    }
+    const Real mx  = *std::max_element(ld.begin(), ld.end());
+    const Real tot = std::accumulate(ld.begin(), ld.end(), Real(0.0));
+    if (load) load->swap(ld);
+    return (mx > 0) ? tot/(nprocs*mx) : Real(1.0);
+}
+
+static
+long
+MovedCells (const BoxArray& ba, const Vector<int>& oldmap, const Vector<int>& newmap)
+{
+    long moved = 0;
+    for (int i = 0, N = ba.size(); i < N; ++i) {
+        if (oldmap[i] != newmap[i]) moved += ba[i].numPts();
+    }
+    return moved;
+}
+
+//
+// Relabel the bins of newmap so that they stay on the process that
+// already holds most of their cells.
+//
+static
+void
+MatchOwners (const BoxArray& ba, const Vector<int>& oldmap, Vector<int>& newmap)
+{
+    std::map<std::pair<int,int>,long> overlap;  // (new, old) -> # of cells
+    for (int i = 0, N = ba.size(); i < N; ++i) {
+        overlap[std::make_pair(newmap[i],oldmap[i])] += ba[i].numPts();
+    }
+
+    std::vector<std::pair<long,std::pair<int,int> > > pairs;
+    for (auto const& kv : overlap) {
+        pairs.push_back(std::make_pair(kv.second, kv.first));
+    }
+    // Ties are broken by the ranks so that all processes agree.
+    std::sort(pairs.begin(), pairs.end(),
+              [] (const std::pair<long,std::pair<int,int> >& a,
+                  const std::pair<long,std::pair<int,int> >& b)
+              { return a.first > b.first || (a.first == b.first && a.second < b.second); });
+
+    std::map<int,int> relabel;
+    std::set<int> taken;
+    for (auto const& p : pairs)
+    {
+        const int nw = p.second.first;
+        const int od = p.second.second;
+        if (relabel.count(nw) == 0 && taken.count(od) == 0) {
+            relabel[nw] = od;
+            taken.insert(od);
+        }
+    }
+
+    // The bins that are left get the processes that are left.
+    int next = 0;
+    for (int& r : newmap)
+    {
+        if (relabel.count(r) == 0)
+        {
+            int g = ParallelContext::local_to_global_rank(next);
+            while (taken.count(g)) {
+                g = ParallelContext::local_to_global_rank(++next);
+            }
+            BL_ASSERT(next < ParallelContext::NProcsSub());
+            relabel[r] = g;
+            taken.insert(g);
+        }
+        r = relabel[r];
+    }
+}
+
+//
+// Starting from pmap, move boxes from the most to the least loaded process
+// as long as that helps and at most max_cells cells have moved.
+//
+static
+void
+MoveGreedily (const BoxArray& ba, const Vector<Real>& cost, Vector<int>& pmap,
+              int nprocs, long max_cells)
+{
+    const int N = ba.size();
+    Vector<int> owner(N);
+    ParallelContext::global_to_local_rank(owner.data(), pmap.data(), N);
+    const Vector<int> orig_owner = owner;
+
+    Vector<Real> load(nprocs, 0.0);
+    for (int i = 0; i < N; ++i) load[owner[i]] += cost[i];
+
+    typedef std::set<std::pair<Real,int> > Heap;
+    Heap byload;                      // (load, rank)
+    Vector<Heap> boxes(nprocs);       // (cost, box) of the boxes on each rank
+    for (int p = 0; p < nprocs; ++p) byload.insert(std::make_pair(load[p], p));
+    for (int i = 0; i < N; ++i) {
+        if (cost[i] > 0) boxes[owner[i]].insert(std::make_pair(cost[i], i));
+    }
+
+    long moved = 0;
+    while (true)
+    {
+        const int pmin = byload.begin()->second;
+        const int pmax = byload.rbegin()->second;
+        const Real diff = load[pmax] - load[pmin];
+        if (diff <= 0) break;
+
+        // The best box to move brings the two loads closest together.  The
+        // new maximum is smallest for a cost of diff/2, so it is the first
+        // box that may move on either side of that.
+        int  ibest = -1;
+        Real best  = load[pmax];
+        auto consider = [&] (int i) -> bool
+        {
+            const long extra = (owner[i] == orig_owner[i]) ? ba[i].numPts() : 0;
+            if (moved + extra > max_cells) return false;
+            const Real newmax = std::max(load[pmax]-cost[i], load[pmin]+cost[i]);
+            if (newmax < best) {
+                best  = newmax;
+                ibest = i;
+            }
+            return true;
+        };
+        const Heap& bx = boxes[pmax];
+        const Heap::const_iterator mid = bx.lower_bound(std::make_pair(0.5*diff, -1));
+        for (auto it = mid; it != bx.end() && it->first < diff; ++it) {
+            if (consider(it->second)) break;
+        }
+        for (auto it = mid; it != bx.begin(); ) {
+            if (consider((--it)->second)) break;
+        }
+
+        if (ibest < 0) break;
+
+        byload.erase(std::make_pair(load[pmax], pmax));
+        byload.erase(std::make_pair(load[pmin], pmin));
+        boxes[pmax].erase(std::make_pair(cost[ibest], ibest));
+        boxes[pmin].insert(std::make_pair(cost[ibest], ibest));
+
+        if (owner[ibest] == orig_owner[ibest]) moved += ba[ibest].numPts();
+        load[pmax]   -= cost[ibest];
+        load[pmin]   += cost[ibest];
+        owner[ibest]  = pmin;
+        if (owner[ibest] == orig_owner[ibest]) moved -= ba[ibest].numPts();
+
+        byload.insert(std::make_pair(load[pmax], pmax));
+        byload.insert(std::make_pair(load[pmin], pmin));
+    }
+
+    ParallelContext::local_to_global_rank(pmap.data(), owner.data(), N);
+}
+
+DistributionMapping
+DistributionMapping::makeRebalanced (const LayoutData<Real>& cost,
+                                     Real* old_efficiency, Real* new_efficiency)
+{
+    BL_PROFILE("DistributionMapping::makeRebalanced()");
+
+    const BoxArray&            ba = cost.boxArray();
+    const DistributionMapping& dm = cost.DistributionMap();
+    const Vector<int>&     oldmap = dm.ProcessorMap();
+    const int N      = ba.size();
+    const int nprocs = ParallelContext::NProcsSub();
+
+    Vector<Real> rcost(N, 0.0);
+    for (MFIter mfi(cost); mfi.isValid(); ++mfi) {
+        rcost[mfi.index()] = cost[mfi];
+    }
+    ParallelAllReduce::Sum(rcost.data(), N, ParallelContext::CommunicatorSub());
+
+    const Real old_eff = LoadEfficiency(rcost, oldmap, nprocs);
+    if (old_efficiency) *old_efficiency = old_eff;
+    if (new_efficiency) *new_efficiency = old_eff;
+
+    if (nprocs < 2 || N < 2 || old_eff >= rebalance_efficiency) {
+        return dm;
+    }
+
+    long total_cells = 0;
+    for (int i = 0; i < N; ++i) total_cells += ba[i].numPts();
+    const long max_cells = static_cast<long>(rebalance_max_move*total_cells);
+
+    Real wmax = *std::max_element(rcost.begin(), rcost.end());
+    Real scale = (wmax > 0) ? 1.e9/wmax : 1.0;
+    std::vector<long> wgts(N);
+    for (int i = 0; i < N; ++i) {
+        wgts[i] = long(rcost[i]*scale) + 1L;
+    }
+
+    DistributionMapping r;
+    if (m_Strategy == KNAPSACK) {
+        r.KnapSackProcessorMap(wgts, nprocs);
+    } else {
+        r.SFCProcessorMap(ba, wgts, nprocs);
+    }
+
+    Vector<int> newmap = r.ProcessorMap();
+    MatchOwners(ba, oldmap, newmap);
+
+    Vector<int> greedymap = oldmap;
+    MoveGreedily(ba, rcost, greedymap, nprocs, max_cells);
+
+    Real new_eff = LoadEfficiency(rcost, newmap, nprocs);
+    const Real greedy_eff = LoadEfficiency(rcost, greedymap, nprocs);
+
+    if (MovedCells(ba, oldmap, newmap) > max_cells || greedy_eff > new_eff)
+    {
+        newmap.swap(greedymap);
+        new_eff = greedy_eff;
+    }
+
+    if (verbose)
+    {
+        amrex::Print() << "DistributionMapping::makeRebalanced: efficiency "
+                       << old_eff << " -> " << new_eff << ", "
+                       << MovedCells(ba, oldmap, newmap) << " of "
+                       << total_cells << " cells moved\n";
+    }
+
+    if (new_eff <= old_eff) {
+        return dm;
+    }
+
+    if (new_efficiency) *new_efficiency = new_eff;
+
+    return DistributionMapping(std::move(newmap));
+}
+
 std::vector<std::vector<int> >
 DistributionMapping::makeSFC (const BoxArray& ba)
 {
@@ -18,6 +18,7 @@
 #include <AMReX.H>
 #include <AMReX_Utility.H>
 #include <AMReX_MemPool.H>
+#include <AMReX_AoSoAFab.H>
 
 namespace amrex {
 
@@ -542,6 +543,11 @@ FArrayBox::Initialize ()
     pp.query("initval",    initval);
     pp.query("do_initval", do_initval);
     pp.query("init_snan", init_snan);
+    pp.query("cxx_kernels", BaseFab_cxx_kernels);
+    pp.query("aosoa_block_size", AoSoAFab::default_block_size);
+    if (AoSoAFab::default_block_size < 1) {
+        amrex::Abort("fab.aosoa_block_size must be positive");
+    }
 
     amrex::ExecOnFinalize(FArrayBox::Finalize);
 }
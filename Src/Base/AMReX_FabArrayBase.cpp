@@ -1,9 +1,13 @@
 
+#include <cstdint>
+
 #include <AMReX_FabArrayBase.H>
 #include <AMReX_ParmParse.H>
 #include <AMReX_Utility.H>
 #include <AMReX_Geometry.H>
 #include <AMReX_FArrayBox.H>
+#include <AMReX_MFIter.H>
+#include <AMReX_Compression.H>
 
 #ifdef BL_MEM_PROFILING
 #include <AMReX_MemProfiler.H>
@@ -13,12 +17,24 @@
 #include <AMReX_EBFabFactory.H>
 #endif
 
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
 namespace amrex {
 
 //
 // Set default values in Initialize()!!!
 //
 bool    FabArrayBase::do_async_sends;
+bool    FabArrayBase::do_persistent_comm;
+bool    FabArrayBase::numa_first_touch;
+bool    FabArrayBase::node_shmem;
+bool    FabArrayBase::mfiter_work_stealing;
+FabArrayBase::CommCompression FabArrayBase::comm_compression;
+long    FabArrayBase::comm_cache_max_bytes;
+long    FabArrayBase::m_cache_clock = 0;
 int     FabArrayBase::MaxComp;
 #if AMREX_SPACEDIM == 1
 IntVect FabArrayBase::mfiter_tile_size(1024000);
@@ -49,6 +65,70 @@ FabArrayBase::FabArrayStats        FabArrayBase::m_FA_stats;
 namespace
 {
     bool initialized = false;
+
+    //
+    // The processes on this node that share memory windows.
+    //
+    int         node_size = 1;
+    Vector<int> node_rank_of;  // node rank of each process, or -1
+#ifdef BL_USE_MPI
+    MPI_Comm    node_comm = MPI_COMM_NULL;
+#endif
+
+#if defined(BL_USE_MPI) && (MPI_VERSION >= 3)
+    struct NodeWindow
+    {
+        MPI_Win       win;
+        std::size_t   nbytes;    // of this process
+        Vector<char*> base;
+        bool          released;
+    };
+    //
+    // Ordered by id, which is the same on all the processes of the node
+    // since the windows are made collectively.
+    //
+    std::map<int,NodeWindow> node_windows;
+    int node_window_next_id = 0;
+#endif
+
+    //
+    // Bytes given to and produced by CompressMessages.
+    //
+    long compress_bytes_in  = 0;
+    long compress_bytes_out = 0;
+
+    //
+    // Move the messages to and from the other processes on this node out
+    // of the send and recv tags.  The receives are appended to NodeTags.
+    //
+    void
+    SplitNodeTags (FabArrayBase::MapOfCopyComTagContainers& SndTags,
+                   FabArrayBase::MapOfCopyComTagContainers& SndVols,
+                   FabArrayBase::MapOfCopyComTagContainers& RcvTags,
+                   FabArrayBase::MapOfCopyComTagContainers& RcvVols,
+                   FabArrayBase::CopyComTagsContainer&      NodeTags)
+    {
+        for (auto it = SndTags.begin(); it != SndTags.end(); )
+        {
+            if (FabArrayBase::NodeRank(it->first) >= 0) {
+                SndVols.erase(it->first);
+                it = SndTags.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        for (auto it = RcvTags.begin(); it != RcvTags.end(); )
+        {
+            if (FabArrayBase::NodeRank(it->first) >= 0) {
+                NodeTags.insert(NodeTags.end(), it->second.begin(), it->second.end());
+                RcvVols.erase(it->first);
+                it = RcvTags.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
 }
 
 
@@ -64,6 +144,135 @@ FabArrayBase::SetInitialized (bool binit)
   initialized = binit;
 }
 
+int
+FabArrayBase::NodeSize ()
+{
+    return node_size;
+}
+
+int
+FabArrayBase::NodeRank (int rank)
+{
+    return node_rank_of.empty() ? -1 : node_rank_of[rank];
+}
+
+#ifdef BL_USE_MPI
+MPI_Comm
+FabArrayBase::NodeComm ()
+{
+    return node_comm;
+}
+#endif
+
+int
+FabArrayBase::NodeWinAllocate (std::size_t nbytes, Vector<char*>& base)
+{
+#if defined(BL_USE_MPI) && (MPI_VERSION >= 3)
+    BL_ASSERT(node_comm != MPI_COMM_NULL);
+
+    int id = -1;
+
+    if (!node_windows.empty())
+    {
+        //
+        // 0: still in use somewhere, 1: released everywhere, 2: released
+        // everywhere and the right size for this request everywhere.
+        //
+        Vector<int> state;
+        for (const auto& kv : node_windows)
+        {
+            const NodeWindow& w = kv.second;
+            if (!w.released) {
+                state.push_back(0);
+            } else if (w.nbytes >= nbytes && w.nbytes <= 2*nbytes) {
+                state.push_back(2);
+            } else {
+                state.push_back(1);
+            }
+        }
+        BL_MPI_REQUIRE( MPI_Allreduce(MPI_IN_PLACE, state.dataPtr(), state.size(),
+                                      MPI_INT, MPI_MIN, node_comm) );
+
+        int k = 0;
+        for (auto it = node_windows.begin(); it != node_windows.end(); ++k)
+        {
+            if (state[k] == 2 && id < 0) {
+                id = it->first;
+                it->second.released = false;
+                ++it;
+            } else if (state[k] > 0) {
+                MPI_Win_free(&it->second.win);
+                it = node_windows.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    if (id < 0)
+    {
+        static MPI_Info info = MPI_INFO_NULL;
+        if (info == MPI_INFO_NULL) {
+            MPI_Info_create(&info);
+            MPI_Info_set(info, "alloc_shared_noncontig", "true");
+        }
+
+        NodeWindow w;
+        char* p;
+        BL_MPI_REQUIRE( MPI_Win_allocate_shared(nbytes, 1, info, node_comm, &p, &w.win) );
+
+        w.nbytes   = nbytes;
+        w.released = false;
+        w.base.resize(node_size, nullptr);
+        for (int r = 0; r < node_size; ++r)
+        {
+            MPI_Aint sz;
+            int disp;
+            BL_MPI_REQUIRE( MPI_Win_shared_query(w.win, r, &sz, &disp, &w.base[r]) );
+        }
+
+        id = node_window_next_id++;
+        node_windows[id] = w;
+    }
+
+    base = node_windows[id].base;
+    return id;
+#else
+    amrex::ignore_unused(nbytes);
+    amrex::ignore_unused(base);
+    amrex::Abort("FabArrayBase::NodeWinAllocate: MPI-3 is required");
+    return -1;
+#endif
+}
+
+void
+FabArrayBase::NodeWinRelease (int id)
+{
+#if defined(BL_USE_MPI) && (MPI_VERSION >= 3)
+    auto it = node_windows.find(id);
+    if (it != node_windows.end()) {
+        it->second.released = true;
+    }
+#else
+    amrex::ignore_unused(id);
+#endif
+}
+
+#ifdef BL_USE_MPI
+MPI_Win
+FabArrayBase::NodeWin (int id)
+{
+#if (MPI_VERSION >= 3)
+    auto it = node_windows.find(id);
+    BL_ASSERT(it != node_windows.end());
+    return it->second.win;
+#else
+    amrex::ignore_unused(id);
+    return MPI_WIN_NULL;
+#endif
+}
+#endif
+
 void
 FabArrayBase::Initialize ()
 {
@@ -74,6 +283,12 @@ FabArrayBase::Initialize ()
     // Set default values here!!!
     //
     FabArrayBase::do_async_sends    = true;
+    FabArrayBase::do_persistent_comm = true;
+    FabArrayBase::comm_cache_max_bytes = -1;
+    FabArrayBase::numa_first_touch = false;
+    FabArrayBase::node_shmem        = false;
+    FabArrayBase::mfiter_work_stealing = false;
+    FabArrayBase::comm_compression  = CommCompression();
     FabArrayBase::MaxComp           = 25;
 
     ParmParse pp("fabarray");
@@ -97,10 +312,71 @@ FabArrayBase::Initialize ()
 
     pp.query("maxcomp",             FabArrayBase::MaxComp);
     pp.query("do_async_sends",      FabArrayBase::do_async_sends);
+    pp.query("do_persistent_comm",  FabArrayBase::do_persistent_comm);
+    pp.query("numa_first_touch",    FabArrayBase::numa_first_touch);
+    pp.query("node_shmem",          FabArrayBase::node_shmem);
+    pp.query("mfiter_work_stealing", FabArrayBase::mfiter_work_stealing);
+
+    int compression = 0;
+    pp.query("comm_compression", compression);
+    if (compression < CommCompression::None || compression > CommCompression::Lossy) {
+        amrex::Abort("fabarray.comm_compression must be 0, 1 or 2");
+    }
+    comm_compression.mode = static_cast<CommCompression::Mode>(compression);
+    pp.query("comm_compression_tol", comm_compression.tol);
+
+    long max_mb = -1;
+    if (pp.query("comm_cache_max_mb", max_mb) && max_mb >= 0) {
+        FabArrayBase::comm_cache_max_bytes = max_mb * (1024L*1024L);
+    }
 
     if (MaxComp < 1)
         MaxComp = 1;
 
+#if defined(BL_USE_MPI) && (MPI_VERSION >= 3)
+    //
+    // Teams already share the memory of their fabs.
+    //
+    if (node_shmem && ParallelDescriptor::TeamSize() == 1 && !ParallelDescriptor::MPIOneSided())
+    {
+        MPI_Comm comm = ParallelDescriptor::Communicator();
+
+        node_comm = ParallelDescriptor::NodeCommunicator();
+        MPI_Comm_size(node_comm, &node_size);
+
+        if (node_size > 1)
+        {
+            const int nprocs = ParallelDescriptor::NProcs();
+            Vector<int> ranks(nprocs);
+            for (int i = 0; i < nprocs; ++i) {
+                ranks[i] = i;
+            }
+            node_rank_of.resize(nprocs);
+
+            MPI_Group group, node_group;
+            MPI_Comm_group(comm, &group);
+            MPI_Comm_group(node_comm, &node_group);
+            MPI_Group_translate_ranks(group, nprocs, ranks.dataPtr(),
+                                      node_group, node_rank_of.dataPtr());
+            MPI_Group_free(&group);
+            MPI_Group_free(&node_group);
+
+            for (auto& r : node_rank_of) {
+                if (r == MPI_UNDEFINED) r = -1;
+            }
+        }
+        else
+        {
+            node_comm = MPI_COMM_NULL;
+            node_size = 1;
+        }
+    }
+#endif
+
+    if (node_size == 1) {
+        node_shmem = false;
+    }
+
     amrex::ExecOnFinalize(FabArrayBase::Finalize);
 
 #ifdef BL_MEM_PROFILING
@@ -116,6 +392,38 @@ FabArrayBase::Initialize ()
 		     ([] () -> MemProfiler::MemInfo {
 			 return {m_CPC_stats.bytes, m_CPC_stats.bytes_hwm};
 		     }));
+    MemProfiler::add(m_FBC_stats.name+" Entries", std::function<MemProfiler::NBuildsInfo()>
+		     ([] () -> MemProfiler::NBuildsInfo {
+			 return {m_FBC_stats.size, m_FBC_stats.maxsize};
+		     }));
+    MemProfiler::add(m_FBC_stats.name+" Hits", std::function<MemProfiler::NBuildsInfo()>
+		     ([] () -> MemProfiler::NBuildsInfo {
+			 return {int(m_FBC_stats.nhit()), int(m_FBC_stats.nuse)};
+		     }));
+    MemProfiler::add(m_FBC_stats.name+" Misses", std::function<MemProfiler::NBuildsInfo()>
+		     ([] () -> MemProfiler::NBuildsInfo {
+			 return {int(m_FBC_stats.nmiss()), int(m_FBC_stats.nuse)};
+		     }));
+    MemProfiler::add(m_FBC_stats.name+" Evicts", std::function<MemProfiler::NBuildsInfo()>
+		     ([] () -> MemProfiler::NBuildsInfo {
+			 return {int(m_FBC_stats.nevict), int(m_FBC_stats.nerase)};
+		     }));
+    MemProfiler::add(m_CPC_stats.name+" Entries", std::function<MemProfiler::NBuildsInfo()>
+		     ([] () -> MemProfiler::NBuildsInfo {
+			 return {m_CPC_stats.size, m_CPC_stats.maxsize};
+		     }));
+    MemProfiler::add(m_CPC_stats.name+" Hits", std::function<MemProfiler::NBuildsInfo()>
+		     ([] () -> MemProfiler::NBuildsInfo {
+			 return {int(m_CPC_stats.nhit()), int(m_CPC_stats.nuse)};
+		     }));
+    MemProfiler::add(m_CPC_stats.name+" Misses", std::function<MemProfiler::NBuildsInfo()>
+		     ([] () -> MemProfiler::NBuildsInfo {
+			 return {int(m_CPC_stats.nmiss()), int(m_CPC_stats.nuse)};
+		     }));
+    MemProfiler::add(m_CPC_stats.name+" Evicts", std::function<MemProfiler::NBuildsInfo()>
+		     ([] () -> MemProfiler::NBuildsInfo {
+			 return {int(m_CPC_stats.nevict), int(m_CPC_stats.nerase)};
+		     }));
     MemProfiler::add(m_FPinfo_stats.name, std::function<MemProfiler::MemInfo()>
 		     ([] () -> MemProfiler::MemInfo {
 			 return {m_FPinfo_stats.bytes, m_FPinfo_stats.bytes_hwm};
@@ -157,7 +465,7 @@ FabArrayBase::define (const BoxArray&            bxs,
     
     boxarray = bxs;
     
-    BL_ASSERT(dm.ProcessorMap().size() == bxs.size());
+    BL_ASSERT(dm.size() == bxs.size());
     distributionMap = dm;
     
     int myProc = ParallelDescriptor::MyProc();
@@ -218,6 +526,12 @@ FabArrayBase::CPC::bytes () const
     if (m_RcvVols)
 	cnt += FabArrayBase::bytesOfMapOfCopyComTagContainers(*m_RcvVols);
 
+    if (m_NodeTags)
+	cnt += amrex::bytesOf(*m_NodeTags);
+
+    for (auto const& p : m_plans)
+        cnt += p->bytes();
+
     return cnt;
 }
 
@@ -241,9 +555,176 @@ FabArrayBase::FB::bytes () const
     if (m_RcvVols)
 	cnt += FabArrayBase::bytesOfMapOfCopyComTagContainers(*m_RcvVols);
 
+    if (m_NodeTags)
+	cnt += amrex::bytesOf(*m_NodeTags);
+
+    for (auto const& p : m_plans)
+        cnt += p->bytes();
+
     return cnt;
 }
 
+FabArrayBase::CommPlan::CommPlan (const MapOfCopyComTagContainers& SndVols,
+                                  const MapOfCopyComTagContainers& RcvVols,
+                                  int cellbytes, MPI_Comm comm, int tag)
+    : m_cellbytes(cellbytes), m_comm(comm), m_tag(tag), m_busy(false),
+      m_the_send_data(nullptr), m_the_recv_data(nullptr)
+{
+    BL_PROFILE("FabArrayBase::CommPlan::CommPlan()");
+
+    std::size_t tot_send = 0;
+    for (auto const& kv : SndVols)
+    {
+        std::size_t nbytes = 0;
+        for (auto const& cct : kv.second) {
+            nbytes += cct.sbox.numPts() * cellbytes;
+        }
+        BL_ASSERT(nbytes < std::numeric_limits<int>::max());
+        m_send_size.push_back(static_cast<int>(nbytes));
+        m_send_rank.push_back(kv.first);
+        tot_send += nbytes;
+    }
+
+    std::size_t tot_recv = 0;
+    for (auto const& kv : RcvVols)
+    {
+        std::size_t nbytes = 0;
+        for (auto const& cct : kv.second) {
+            nbytes += cct.dbox.numPts() * cellbytes;
+        }
+        BL_ASSERT(nbytes < std::numeric_limits<int>::max());
+        m_recv_size.push_back(static_cast<int>(nbytes));
+        m_recv_from.push_back(kv.first);
+        tot_recv += nbytes;
+    }
+
+    const int nsnds = m_send_size.size();
+    const int nrcvs = m_recv_size.size();
+
+    if (tot_send > 0) {
+        m_the_send_data = static_cast<char*>(amrex::The_Arena()->alloc(tot_send));
+    }
+    if (tot_recv > 0) {
+        m_the_recv_data = static_cast<char*>(amrex::The_Arena()->alloc(tot_recv));
+    }
+
+    //
+    // The layout is the same as in FabArray::FillBoundary and ParallelCopy:
+    // one entry per sender/receiver, with nullptr for empty messages.
+    //
+    m_send_data.resize(nsnds, nullptr);
+    m_send_reqs.resize(nsnds, MPI_REQUEST_NULL);
+    m_recv_data.resize(nrcvs, nullptr);
+    m_recv_reqs.resize(nrcvs, MPI_REQUEST_NULL);
+
+    char* dptr = m_the_send_data;
+    for (int j = 0; j < nsnds; ++j) {
+        if (m_send_size[j] > 0) m_send_data[j] = dptr;
+        dptr += m_send_size[j];
+    }
+    dptr = m_the_recv_data;
+    for (int k = 0; k < nrcvs; ++k) {
+        if (m_recv_size[k] > 0) m_recv_data[k] = dptr;
+        dptr += m_recv_size[k];
+    }
+
+#ifdef BL_USE_MPI
+    for (int k = 0; k < nrcvs; ++k) {
+        if (m_recv_size[k] == 0) continue;
+        BL_MPI_REQUIRE( MPI_Recv_init(m_recv_data[k], m_recv_size[k], MPI_CHAR,
+                                      ParallelContext::global_to_local_rank(m_recv_from[k]),
+                                      tag, comm, &m_recv_reqs[k]) );
+    }
+    for (int j = 0; j < nsnds; ++j) {
+        if (m_send_size[j] == 0) continue;
+        BL_MPI_REQUIRE( MPI_Send_init(m_send_data[j], m_send_size[j], MPI_CHAR,
+                                      ParallelContext::global_to_local_rank(m_send_rank[j]),
+                                      tag, comm, &m_send_reqs[j]) );
+    }
+#endif
+}
+
+FabArrayBase::CommPlan::~CommPlan ()
+{
+    BL_ASSERT(!m_busy);
+#ifdef BL_USE_MPI
+    for (auto& r : m_send_reqs) {
+        if (r != MPI_REQUEST_NULL) MPI_Request_free(&r);
+    }
+    for (auto& r : m_recv_reqs) {
+        if (r != MPI_REQUEST_NULL) MPI_Request_free(&r);
+    }
+#endif
+    amrex::The_Arena()->free(m_the_send_data);
+    amrex::The_Arena()->free(m_the_recv_data);
+}
+
+long
+FabArrayBase::CommPlan::bytes () const
+{
+    long cnt = sizeof(FabArrayBase::CommPlan);
+    for (auto n : m_send_size) cnt += n;
+    for (auto n : m_recv_size) cnt += n;
+    cnt += amrex::bytesOf(m_send_data) + amrex::bytesOf(m_send_size)
+        +  amrex::bytesOf(m_send_rank) + amrex::bytesOf(m_send_reqs)
+        +  amrex::bytesOf(m_recv_data) + amrex::bytesOf(m_recv_size)
+        +  amrex::bytesOf(m_recv_from) + amrex::bytesOf(m_recv_reqs);
+    return cnt;
+}
+
+void
+FabArrayBase::CommPlan::startRecvs ()
+{
+#ifdef BL_USE_MPI
+    for (auto& r : m_recv_reqs) {
+        if (r != MPI_REQUEST_NULL) BL_MPI_REQUIRE( MPI_Start(&r) );
+    }
+#endif
+}
+
+void
+FabArrayBase::CommPlan::startSends ()
+{
+#ifdef BL_USE_MPI
+    for (auto& r : m_send_reqs) {
+        if (r != MPI_REQUEST_NULL) BL_MPI_REQUIRE( MPI_Start(&r) );
+    }
+#endif
+}
+
+FabArrayBase::CommPlan*
+FabArrayBase::getCommPlan (CommPlans& plans,
+                           const MapOfCopyComTagContainers& SndVols,
+                           const MapOfCopyComTagContainers& RcvVols,
+                           int cellbytes, CacheStats* stats)
+{
+    if (!do_persistent_comm) return nullptr;
+
+    // All processes must make the same decision here.
+    MPI_Comm comm = ParallelContext::CommunicatorSub();
+    for (auto const& p : plans)
+    {
+        if (p->m_cellbytes == cellbytes && p->m_comm == comm) {
+            return (p->m_busy) ? nullptr : p.get();
+        }
+    }
+
+    //
+    // All plans use the same tag, which is reserved for them.  Because
+    // plans are started in the same order on all processes, the messages
+    // still match, even if an entry has been evicted from the cache and
+    // rebuilt on some processes only.
+    //
+    const int tag = ParallelDescriptor::PersistentCommTag();
+
+    plans.emplace_back(new CommPlan(SndVols, RcvVols, cellbytes, comm, tag));
+    if (stats) {
+        stats->recordBytes(plans.back()->bytes());
+        trimCommCaches();
+    }
+    return plans.back().get();
+}
+
 long
 FabArrayBase::TileArray::bytes () const
 {
@@ -261,7 +742,7 @@ FabArrayBase::TileArray::bytes () const
 
 FabArrayBase::CPC::CPC (const FabArrayBase& dstfa, const IntVect& dstng,
 			const FabArrayBase& srcfa, const IntVect& srcng,
-			const Periodicity& period)
+			const Periodicity& period, bool node)
     : m_srcbdk(srcfa.getBDKey()), 
       m_dstbdk(dstfa.getBDKey()), 
       m_srcng(srcng), 
@@ -270,10 +751,16 @@ FabArrayBase::CPC::CPC (const FabArrayBase& dstfa, const IntVect& dstng,
       m_srcba(srcfa.boxArray()), 
       m_dstba(dstfa.boxArray()),
       m_threadsafe_loc(false), m_threadsafe_rcv(false),
-      m_LocTags(0), m_SndTags(0), m_RcvTags(0), m_SndVols(0), m_RcvVols(0), m_nuse(0)
+      m_LocTags(0), m_SndTags(0), m_RcvTags(0), m_SndVols(0), m_RcvVols(0),
+      m_node(node), m_NodeTags(0), m_nuse(0)
 {
     this->define(m_dstba, dstfa.DistributionMap(), dstfa.IndexArray(), 
 		 m_srcba, srcfa.DistributionMap(), srcfa.IndexArray());
+
+    if (m_node) {
+        m_NodeTags = new CopyComTag::CopyComTagsContainer;
+        SplitNodeTags(*m_SndTags, *m_SndVols, *m_RcvTags, *m_RcvVols, *m_NodeTags);
+    }
 }
 
 FabArrayBase::CPC::CPC (const BoxArray& dstba, const DistributionMapping& dstdm, 
@@ -289,7 +776,8 @@ FabArrayBase::CPC::CPC (const BoxArray& dstba, const DistributionMapping& dstdm,
       m_srcba(srcba), 
       m_dstba(dstba),
       m_threadsafe_loc(false), m_threadsafe_rcv(false),
-      m_LocTags(0), m_SndTags(0), m_RcvTags(0), m_SndVols(0), m_RcvVols(0), m_nuse(0)
+      m_LocTags(0), m_SndTags(0), m_RcvTags(0), m_SndVols(0), m_RcvVols(0),
+      m_node(false), m_NodeTags(0), m_nuse(0)
 {
     this->define(dstba, dstdm, dstidx, srcba, srcdm, srcidx, myproc);
 }
@@ -301,6 +789,7 @@ FabArrayBase::CPC::~CPC ()
     delete m_RcvTags;
     delete m_SndVols;
     delete m_RcvVols;
+    delete m_NodeTags;
 }
 
 void
@@ -333,15 +822,30 @@ FabArrayBase::CPC::define (const BoxArray& ba_dst, const DistributionMapping& dm
 	const std::vector<IntVect>& pshifts = m_period.shiftIntVect();
 
 	auto& send_tags = *m_SndVols;
+
+	//
+	// The intersections are found in one batch, which is threaded.
+	//
+	Vector<Box> qbx;
+	Vector<std::vector< std::pair<int,Box> > > qisects;
+	int q = 0;
+
+	qbx.reserve(nlocal_src*pshifts.size());
+	for (int i = 0; i < nlocal_src; ++i) {
+	    const Box& bx_src = amrex::grow(ba_src[imap_src[i]], ng_src);
+	    for (const auto& iv : pshifts) {
+		qbx.push_back(bx_src+iv);
+	    }
+	}
+	ba_dst.intersections(qbx, qisects, false, ng_dst);
 	
 	for (int i = 0; i < nlocal_src; ++i)
 	{
 	    const int   k_src = imap_src[i];
-	    const Box& bx_src = amrex::grow(ba_src[k_src], ng_src);
 
 	    for (std::vector<IntVect>::const_iterator pit=pshifts.begin(); pit!=pshifts.end(); ++pit)
 	    {
-		ba_dst.intersections(bx_src+(*pit), isects, false, ng_dst);
+		isects.swap(qisects[q++]);
 	    
 		for (int j = 0, M = isects.size(); j < M; ++j)
 		{
@@ -372,6 +876,17 @@ FabArrayBase::CPC::define (const BoxArray& ba_dst, const DistributionMapping& dm
 	if (ParallelDescriptor::TeamSize() > 1) {
 	    check_local = true;
 	}
+
+	qbx.clear();
+	qbx.reserve(nlocal_dst*pshifts.size());
+	for (int i = 0; i < nlocal_dst; ++i) {
+	    const Box& bx_dst = amrex::grow(ba_dst[imap_dst[i]], ng_dst);
+	    for (const auto& iv : pshifts) {
+		qbx.push_back(bx_dst+iv);
+	    }
+	}
+	ba_src.intersections(qbx, qisects, false, ng_src);
+	q = 0;
 	
 	for (int i = 0; i < nlocal_dst; ++i)
 	{
@@ -390,7 +905,7 @@ FabArrayBase::CPC::define (const BoxArray& ba_dst, const DistributionMapping& dm
 	    
 	    for (std::vector<IntVect>::const_iterator pit=pshifts.begin(); pit!=pshifts.end(); ++pit)
 	    {
-		ba_src.intersections(bx_dst+(*pit), isects, false, ng_src);
+		isects.swap(qisects[q++]);
 	    
 		for (int j = 0, M = isects.size(); j < M; ++j)
 		{
@@ -474,7 +989,8 @@ FabArrayBase::CPC::CPC (const BoxArray& ba, const IntVect& ng,
       m_srcba(ba), 
       m_dstba(ba),
       m_threadsafe_loc(true), m_threadsafe_rcv(true),
-      m_LocTags(0), m_SndTags(0), m_RcvTags(0), m_SndVols(0), m_RcvVols(0), m_nuse(0)
+      m_LocTags(0), m_SndTags(0), m_RcvTags(0), m_SndVols(0), m_RcvVols(0),
+      m_node(false), m_NodeTags(0), m_nuse(0)
 {
     BL_ASSERT(ba.size() > 0);
 
@@ -545,9 +1061,7 @@ FabArrayBase::flushCPC (bool no_assertion) const
 	    }
 	}
 
-#ifdef BL_MEM_PROFILING
 	m_CPC_stats.bytes -= it->second->bytes();
-#endif
 	m_CPC_stats.recordErase(it->second->m_nuse);
 	delete it->second;
     }
@@ -572,13 +1086,12 @@ FabArrayBase::flushCPCache ()
 	}
     }
     m_TheCPCache.clear();
-#ifdef BL_MEM_PROFILING
     m_CPC_stats.bytes = 0L;
-#endif
 }
 
 const FabArrayBase::CPC&
-FabArrayBase::getCPC (const IntVect& dstng, const FabArrayBase& src, const IntVect& srcng, const Periodicity& period) const
+FabArrayBase::getCPC (const IntVect& dstng, const FabArrayBase& src, const IntVect& srcng,
+                      const Periodicity& period, bool node) const
 {
     BL_PROFILE("FabArrayBase::getCPC()");
 
@@ -598,24 +1111,24 @@ FabArrayBase::getCPC (const IntVect& dstng, const FabArrayBase& src, const IntVe
 	    it->second->m_srcbdk == srckey &&
 	    it->second->m_dstbdk == dstkey &&
 	    it->second->m_period == period &&
+	    it->second->m_node   == node   &&
 	    it->second->m_srcba  == src.boxArray() &&
 	    it->second->m_dstba  == boxArray())
 	{
 	    ++(it->second->m_nuse);
+	    it->second->m_lastuse = ++m_cache_clock;
 	    m_CPC_stats.recordUse();
 	    return *(it->second);
 	}
     }
     
     // Have to build a new one
-    CPC* new_cpc = new CPC(*this, dstng, src, srcng, period);
+    CPC* new_cpc = new CPC(*this, dstng, src, srcng, period, node);
 
-#ifdef BL_MEM_PROFILING
-    m_CPC_stats.bytes += new_cpc->bytes();
-    m_CPC_stats.bytes_hwm = std::max(m_CPC_stats.bytes_hwm, m_CPC_stats.bytes);
-#endif    
+    m_CPC_stats.recordBytes(new_cpc->bytes());
 
     new_cpc->m_nuse = 1;
+    new_cpc->m_lastuse = ++m_cache_clock;
     m_CPC_stats.recordBuild();
     m_CPC_stats.recordUse();
 
@@ -623,6 +1136,8 @@ FabArrayBase::getCPC (const IntVect& dstng, const FabArrayBase& src, const IntVe
     if (srckey != dstkey)
 	m_TheCPCache.insert(          CPCache::value_type(srckey,new_cpc));
 
+    trimCommCaches();
+
     return *new_cpc;
 }
 
@@ -632,7 +1147,7 @@ FabArrayBase::getCPC (const IntVect& dstng, const FabArrayBase& src, const IntVe
 
 FabArrayBase::FB::FB (const FabArrayBase& fa, const IntVect& nghost,
                       bool cross, const Periodicity& period, 
-                      bool enforce_periodicity_only)
+                      bool enforce_periodicity_only, bool node)
     : m_typ(fa.boxArray().ixType()), m_crse_ratio(fa.boxArray().crseRatio()),
       m_ngrow(nghost), m_cross(cross),
       m_epo(enforce_periodicity_only), m_period(period),
@@ -642,6 +1157,7 @@ FabArrayBase::FB::FB (const FabArrayBase& fa, const IntVect& nghost,
       m_RcvTags(new CopyComTag::MapOfCopyComTagContainers),
       m_SndVols(new CopyComTag::MapOfCopyComTagContainers),
       m_RcvVols(new CopyComTag::MapOfCopyComTagContainers),
+      m_node(node), m_NodeTags(nullptr),
       m_nuse(0)
 {
     BL_PROFILE("FabArrayBase::FB::FB()");
@@ -654,6 +1170,11 @@ FabArrayBase::FB::FB (const FabArrayBase& fa, const IntVect& nghost,
 	    define_fb(fa);
 	}
     }
+
+    if (m_node) {
+        m_NodeTags = new CopyComTag::CopyComTagsContainer;
+        SplitNodeTags(*m_SndTags, *m_SndVols, *m_RcvTags, *m_RcvVols, *m_NodeTags);
+    }
 }
 
 void
@@ -674,15 +1195,29 @@ FabArrayBase::FB::define_fb(const FabArrayBase& fa)
     const std::vector<IntVect>& pshifts = m_period.shiftIntVect();
     
     auto& send_tags = *m_SndVols;
+
+    //
+    // The intersections are found in one batch, which is threaded.
+    //
+    Vector<Box> qbx;
+    Vector<std::vector< std::pair<int,Box> > > qisects;
+    int q = 0;
+
+    qbx.reserve(nlocal*pshifts.size());
+    for (int i = 0; i < nlocal; ++i) {
+	for (const auto& iv : pshifts) {
+	    qbx.push_back(ba[imap[i]]+iv);
+	}
+    }
+    ba.intersections(qbx, qisects, false, ng);
     
     for (int i = 0; i < nlocal; ++i)
     {
 	const int ksnd = imap[i];
-	const Box& vbx = ba[ksnd];
 	
 	for (auto pit=pshifts.cbegin(); pit!=pshifts.cend(); ++pit)
 	{
-	    ba.intersections(vbx+(*pit), isects, false, ng);
+	    isects.swap(qisects[q++]);
 
 	    for (int j = 0, M = isects.size(); j < M; ++j)
 	    {
@@ -716,6 +1251,16 @@ FabArrayBase::FB::define_fb(const FabArrayBase& fa)
 	check_local = true;
     }
 
+    qbx.clear();
+    for (int i = 0; i < nlocal; ++i) {
+	const Box& bxrcv = amrex::grow(ba[imap[i]], ng);
+	for (const auto& iv : pshifts) {
+	    qbx.push_back(bxrcv+iv);
+	}
+    }
+    ba.intersections(qbx, qisects);
+    q = 0;
+
     for (int i = 0; i < nlocal; ++i)
     {
 	const int   krcv = imap[i];
@@ -734,7 +1279,7 @@ FabArrayBase::FB::define_fb(const FabArrayBase& fa)
 	
 	for (auto pit=pshifts.cbegin(); pit!=pshifts.cend(); ++pit)
 	{
-	    ba.intersections(bxrcv+(*pit), isects);
+	    isects.swap(qisects[q++]);
 
 	    for (int j = 0, M = isects.size(); j < M; ++j)
 	    {
@@ -1052,6 +1597,7 @@ FabArrayBase::FB::~FB ()
     delete m_RcvTags;
     delete m_SndVols;
     delete m_RcvVols;
+    delete m_NodeTags;
 }
 
 void
@@ -1061,9 +1607,7 @@ FabArrayBase::flushFB (bool no_assertion) const
     std::pair<FBCacheIter,FBCacheIter> er_it = m_TheFBCache.equal_range(m_bdkey);
     for (FBCacheIter it = er_it.first; it != er_it.second; ++it)
     {
-#ifdef BL_MEM_PROFILING
 	m_FBC_stats.bytes -= it->second->bytes();
-#endif
 	m_FBC_stats.recordErase(it->second->m_nuse);
 	delete it->second;
     }
@@ -1079,14 +1623,107 @@ FabArrayBase::flushFBCache ()
 	delete it->second;
     }
     m_TheFBCache.clear();
-#ifdef BL_MEM_PROFILING
     m_FBC_stats.bytes = 0L;
+}
+
+void
+FabArrayBase::FBRecvLocalIndices (const CopyComTagsContainer& tags, Vector<int>& lidx) const
+{
+    lidx.clear();
+    for (auto const& tag : tags) {
+        lidx.push_back(localindex(tag.dstIndex));
+    }
+    std::sort(lidx.begin(), lidx.end());
+    lidx.erase(std::unique(lidx.begin(), lidx.end()), lidx.end());
+}
+
+//
+// The NUMA functions use the system calls directly so that we do not
+// depend on libnuma.
+//
+#if defined(__linux__) && defined(SYS_move_pages) && defined(SYS_getcpu)
+#define AMREX_NUMA_SYSCALLS 1
+#endif
+
+namespace {
+    const int numa_mf_move = 1 << 1;   // MPOL_MF_MOVE
+    const long numa_batch  = 4096;     // # of pages per system call
+}
+
+int
+FabArrayBase::NUMANode ()
+{
+#ifdef AMREX_NUMA_SYSCALLS
+    unsigned cpu, node;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+        return node;
+    }
+#endif
+    return -1;
+}
+
+void
+FabArrayBase::NUMAPagesIn (const char* begin, const char* end, Vector<char*>& pages)
+{
+#ifdef AMREX_NUMA_SYSCALLS
+    static const std::uintptr_t pagesize = sysconf(_SC_PAGESIZE);
+    std::uintptr_t p = reinterpret_cast<std::uintptr_t>(begin);
+    p = (p + pagesize - 1) / pagesize * pagesize;
+    for ( ; p < reinterpret_cast<std::uintptr_t>(end); p += pagesize) {
+        pages.push_back(reinterpret_cast<char*>(p));
+    }
+#endif
+}
+
+void
+FabArrayBase::NUMAPlacePages (Vector<char*>& pages, int node)
+{
+#ifdef AMREX_NUMA_SYSCALLS
+    //
+    // Write to each page so that untouched pages are faulted in by this
+    // thread.  The first byte of a page belongs to one tile only, so no
+    // other thread is touching it.
+    //
+    for (char* p : pages) {
+        volatile char* vp = p;
+        *vp = *vp;
+    }
+
+    if (node < 0) return;
+
+    Vector<int> nodes, status;
+    for (long i = 0, N = pages.size(); i < N; i += numa_batch)
+    {
+        const long n = std::min(numa_batch, N-i);
+        nodes.assign(n, node);
+        status.resize(n);
+        // Errors are harmless here; the pages just stay where they are.
+        syscall(SYS_move_pages, 0, n, reinterpret_cast<void**>(pages.data()+i),
+                nodes.data(), status.data(), numa_mf_move);
+    }
+#endif
+}
+
+void
+FabArrayBase::NUMAQueryPages (Vector<char*>& pages, Vector<int>& nodes)
+{
+    nodes.assign(pages.size(), -1);
+#ifdef AMREX_NUMA_SYSCALLS
+    for (long i = 0, N = pages.size(); i < N; i += numa_batch)
+    {
+        const long n = std::min(numa_batch, N-i);
+        if (syscall(SYS_move_pages, 0, n, reinterpret_cast<void**>(pages.data()+i),
+                    nullptr, nodes.data()+i, 0) != 0)
+        {
+            std::fill(nodes.begin()+i, nodes.begin()+i+n, -1);
+        }
+    }
 #endif
 }
 
 const FabArrayBase::FB&
 FabArrayBase::getFB (const IntVect& nghost, const Periodicity& period,
-                     bool cross, bool enforce_periodicity_only) const
+                     bool cross, bool enforce_periodicity_only, bool node) const
 {
     BL_PROFILE("FabArrayBase::getFB()");
 
@@ -1099,31 +1736,102 @@ FabArrayBase::getFB (const IntVect& nghost, const Periodicity& period,
 	    it->second->m_ngrow      == nghost                   &&
 	    it->second->m_cross      == cross                    &&
 	    it->second->m_epo        == enforce_periodicity_only &&
-	    it->second->m_period     == period              )
+	    it->second->m_period     == period                   &&
+	    it->second->m_node       == node                )
 	{
 	    ++(it->second->m_nuse);
+	    it->second->m_lastuse = ++m_cache_clock;
 	    m_FBC_stats.recordUse();
 	    return *(it->second);
 	}
     }
 
     // Have to build a new one
-    FB* new_fb = new FB(*this, nghost, cross, period, enforce_periodicity_only);
+    FB* new_fb = new FB(*this, nghost, cross, period, enforce_periodicity_only, node);
 
-#ifdef BL_PROFILE
-    m_FBC_stats.bytes += new_fb->bytes();
-    m_FBC_stats.bytes_hwm = std::max(m_FBC_stats.bytes_hwm, m_FBC_stats.bytes);
-#endif
+    m_FBC_stats.recordBytes(new_fb->bytes());
 
     new_fb->m_nuse = 1;
+    new_fb->m_lastuse = ++m_cache_clock;
     m_FBC_stats.recordBuild();
     m_FBC_stats.recordUse();
 
     m_TheFBCache.insert(er_it.second, FBCache::value_type(m_bdkey,new_fb));
 
+    trimCommCaches();
+
     return *new_fb;
 }
 
+void
+FabArrayBase::trimCommCaches ()
+{
+    if (comm_cache_max_bytes < 0) return;
+
+    //
+    // The entry used last is never evicted because the caller is using it.
+    //
+    while (m_FBC_stats.bytes + m_CPC_stats.bytes > comm_cache_max_bytes)
+    {
+        FBCacheIter fb_lru = m_TheFBCache.end();
+        for (FBCacheIter it = m_TheFBCache.begin(); it != m_TheFBCache.end(); ++it)
+        {
+            const FB* fb = it->second;
+            if (fb->m_nactive == 0 && fb->m_npinned == 0 && fb->m_lastuse < m_cache_clock &&
+                (fb_lru == m_TheFBCache.end() || fb->m_lastuse < fb_lru->second->m_lastuse))
+            {
+                fb_lru = it;
+            }
+        }
+
+        CPCacheIter cpc_lru = m_TheCPCache.end();
+        for (CPCacheIter it = m_TheCPCache.begin(); it != m_TheCPCache.end(); ++it)
+        {
+            const CPC* cpc = it->second;
+            if (cpc->m_nactive == 0 && cpc->m_npinned == 0 && cpc->m_lastuse < m_cache_clock &&
+                (cpc_lru == m_TheCPCache.end() || cpc->m_lastuse < cpc_lru->second->m_lastuse))
+            {
+                cpc_lru = it;
+            }
+        }
+
+        const bool has_fb  = fb_lru  != m_TheFBCache.end();
+        const bool has_cpc = cpc_lru != m_TheCPCache.end();
+
+        if (!has_fb && !has_cpc) break;  // Nothing can be evicted.
+
+        if (has_fb && (!has_cpc || fb_lru->second->m_lastuse < cpc_lru->second->m_lastuse))
+        {
+            FB* fb = fb_lru->second;
+            m_FBC_stats.bytes -= fb->bytes();
+            m_FBC_stats.recordEvict(fb->m_nuse);
+            delete fb;
+            m_TheFBCache.erase(fb_lru);
+        }
+        else
+        {
+            //
+            // A CPC is stored under both the source and destination keys.
+            //
+            CPC* cpc = cpc_lru->second;
+            for (const BDKey& key : {cpc->m_srcbdk, cpc->m_dstbdk})
+            {
+                std::pair<CPCacheIter,CPCacheIter> er_it = m_TheCPCache.equal_range(key);
+                for (CPCacheIter it = er_it.first; it != er_it.second; ++it)
+                {
+                    if (it->second == cpc) {
+                        m_TheCPCache.erase(it);
+                        break;
+                    }
+                }
+            }
+            m_CPC_stats.bytes -= cpc->bytes();
+            m_CPC_stats.recordEvict(cpc->m_nuse);
+            delete cpc;
+        }
+    }
+}
+
 FabArrayBase::FPinfo::FPinfo (const FabArrayBase& srcfa,
 			      const FabArrayBase& dstfa,
 			      const Box&          dstdomain,
@@ -1441,8 +2149,20 @@ FabArrayBase::Finalize ()
 	m_CPC_stats.print();
 	m_FPinfo_stats.print();
 	m_CFinfo_stats.print();
+        if (compress_bytes_in > 0) {
+            amrex::Print(Print::AllProcs) << "### CommCompression ###\n"
+                                          << "    tot # of bytes in : " << compress_bytes_in  << "\n"
+                                          << "    tot # of bytes out: " << compress_bytes_out << "\n";
+        }
+        MFIter::PrintWorkStealingStats();
     }
 
+    MFIter::ResetWorkStealingStats();
+    MFIter::FinalizeScratch();
+
+    compress_bytes_in  = 0;
+    compress_bytes_out = 0;
+
     m_TAC_stats = CacheStats("TileArrayCache");
     m_FBC_stats = CacheStats("FBCache");
     m_CPC_stats = CacheStats("CopyCache");
@@ -1453,6 +2173,18 @@ FabArrayBase::Finalize ()
     
     m_FA_stats = FabArrayStats();
 
+#if defined(BL_USE_MPI) && (MPI_VERSION >= 3)
+    for (auto& kv : node_windows) {
+        MPI_Win_free(&kv.second.win);
+    }
+    node_windows.clear();
+#endif
+#ifdef BL_USE_MPI
+    node_comm = MPI_COMM_NULL;
+#endif
+    node_size = 1;
+    node_rank_of.clear();
+
     initialized = false;
 }
 
@@ -1773,4 +2505,53 @@ operator<< (std::ostream& os, const FabArrayBase::BDKey& id)
     return os;
 }
 
+
+std::size_t
+FabArrayBase::CompressedCapacity (std::size_t nbytes)
+{
+    return Compression::Capacity(nbytes);
+}
+
+void
+FabArrayBase::CompressMessages (Vector<char*>& data, Vector<int>& size,
+                                const CommCompression& cc, int wordsize, bool fp)
+{
+    BL_PROFILE("FabArrayBase::CompressMessages()");
+
+    const bool lossy = cc.mode == CommCompression::Lossy && fp && (wordsize == 8 || wordsize == 4);
+    const std::uint64_t mask = (lossy) ? Compression::LossyMask(cc.tol, wordsize) : ~std::uint64_t(0);
+
+    long bytes_in = 0, bytes_out = 0;
+    const int N = data.size();
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:bytes_in,bytes_out)
+#endif
+    for (int i = 0; i < N; ++i)
+    {
+        if (data[i] == nullptr) continue;
+
+        char* p = static_cast<char*>(amrex::The_Arena()->alloc(CompressedCapacity(size[i])));
+        const std::size_t n = Compression::Compress(data[i], size[i], p, mask);
+        amrex::The_Arena()->free(data[i]);
+
+        bytes_in  += size[i];
+        bytes_out += n;
+
+        data[i] = p;
+        size[i] = static_cast<int>(n);
+    }
+
+    compress_bytes_in  += bytes_in;
+    compress_bytes_out += bytes_out;
+}
+
+void
+FabArrayBase::DecompressMessage (char*& data, int count, int nbytes)
+{
+    char* p = static_cast<char*>(amrex::The_Arena()->alloc(nbytes));
+    Compression::Decompress(data, count, p, nbytes);
+    amrex::The_Arena()->free(data);
+    data = p;
+}
+
 }
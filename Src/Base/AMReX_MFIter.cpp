@@ -2,11 +2,214 @@
 #include <AMReX_MFIter.H>
 #include <AMReX_FabArray.H>
 #include <AMReX_FArrayBox.H>
+#include <AMReX_LayoutData.H>
+#include <AMReX_Print.H>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
 
 namespace amrex {
 
 int MFIter::nextDynamicIndex = std::numeric_limits<int>::min();
 
+//
+// Each thread owns a range [lo,hi) of positions in order, packed in one
+// word so that the owner popping from the front and the thieves taking
+// from the back only need a compare-and-swap.
+//
+struct MFIter::StealQueues
+{
+    struct alignas(64) Queue
+    {
+        std::atomic<std::uint64_t> range;
+    };
+
+    explicit StealQueues (int a_nthreads)
+        : nthreads(a_nthreads), q(a_nthreads),
+          finish(a_nthreads, 0.0), ntiles(a_nthreads, 0), nsteals(a_nthreads, 0),
+          nfinished(0) {}
+
+    static std::uint64_t pack (int lo, int hi) {
+        return (static_cast<std::uint64_t>(hi) << 32) | static_cast<std::uint32_t>(lo);
+    }
+    static int lo (std::uint64_t r) { return static_cast<int>(r & 0xffffffffu); }
+    static int hi (std::uint64_t r) { return static_cast<int>(r >> 32); }
+
+    int               nthreads;
+    Vector<int>       order;
+    std::vector<Queue> q;
+    Vector<double>    finish;
+    Vector<long>      ntiles;
+    Vector<long>      nsteals;
+    std::atomic<int>  nfinished;
+};
+
+std::shared_ptr<MFIter::StealQueues> MFIter::s_steal;
+
+namespace
+{
+    //
+    // The scratch arena of a thread.  Memory is handed out from the
+    // current chunk by bumping an offset, and given back by resetting the
+    // (chunk,offset) position to where it was.  A new chunk is at least
+    // twice as large as the last one.  When the arena becomes empty, the
+    // chunks are merged into one, so that after the first few tiles all
+    // the scratch fabs come from a single chunk.
+    //
+    struct ScratchArena
+    {
+        struct Chunk
+        {
+            char*       p;
+            std::size_t size;
+        };
+
+        static constexpr std::size_t align     = 64;
+        static constexpr std::size_t min_chunk = 1024*1024;
+
+        static std::size_t aligned (std::size_t n) { return (n + align - 1) / align * align; }
+
+        ~ScratchArena () {
+            for (auto& c : chunks) std::free(c.p);
+        }
+
+        void* alloc (std::size_t nbytes)
+        {
+            nbytes = aligned(nbytes);
+            const int nchunks = chunks.size();
+            while (cur < nchunks && off + nbytes > chunks[cur].size) {
+                ++cur;
+                off = 0;
+            }
+            if (cur == nchunks) {
+                const std::size_t sz = std::max(nbytes, chunks.empty() ? min_chunk
+                                                                       : 2*chunks.back().size);
+                chunks.push_back({newChunk(sz), sz});
+            }
+            void* p = chunks[cur].p + off;
+            off += nbytes;
+            return p;
+        }
+
+        void reset (int a_cur, std::size_t a_off)
+        {
+            cur = a_cur;
+            off = a_off;
+            if (cur == 0 && off == 0 && chunks.size() > 1)
+            {
+                std::size_t sz = 0;
+                for (auto& c : chunks) {
+                    sz += c.size;
+                    std::free(c.p);
+                }
+                chunks.clear();
+                chunks.push_back({newChunk(sz), sz});
+            }
+        }
+
+        static char* newChunk (std::size_t sz)
+        {
+            void* p = nullptr;
+            if (posix_memalign(&p, align, sz) != 0) {
+                amrex::Abort("MFIter::scratchFab: out of memory");
+            }
+            return static_cast<char*>(p);
+        }
+
+        Vector<Chunk> chunks;
+        int           cur = 0;
+        std::size_t   off = 0;
+        const void*   top = nullptr; // the innermost live ScratchScope
+    };
+
+    //
+    // The arenas are made by the threads that need them and freed by
+    // MFIter::FinalizeScratch, which also makes the thread_local pointers
+    // stale by bumping the generation.
+    //
+    struct TLScratch
+    {
+        long          gen;
+        ScratchArena* arena;
+    };
+    thread_local TLScratch tl_scratch = {0, nullptr};
+
+    std::mutex             scratch_mutex;
+    Vector<ScratchArena*>  scratch_arenas;
+    long                   scratch_generation = 1;
+
+    ScratchArena*
+    MyScratchArena ()
+    {
+        if (tl_scratch.gen != scratch_generation)
+        {
+            ScratchArena* a = new ScratchArena;
+            {
+                std::lock_guard<std::mutex> lock(scratch_mutex);
+                scratch_arenas.push_back(a);
+            }
+            tl_scratch.gen   = scratch_generation;
+            tl_scratch.arena = a;
+        }
+        return tl_scratch.arena;
+    }
+}
+
+struct MFIter::ScratchScope
+{
+    explicit ScratchScope (ScratchArena* a)
+        : arena(a), cur(a->cur), off(a->off), prev_top(a->top)
+    {
+        arena->top = this;
+    }
+
+    ~ScratchScope () {
+        release();
+        arena->top = prev_top;
+    }
+
+    void release ()
+    {
+        //
+        // The loops using scratch fabs on a thread must be nested.
+        //
+        BL_ASSERT(arena->top == this);
+        for (FArrayBox* fab : fabs) {
+            fab->~FArrayBox();
+        }
+        fabs.clear();
+        arena->reset(cur, off);
+    }
+
+    ScratchArena*      arena;
+    int                cur;
+    std::size_t        off;
+    const void*        prev_top;
+    Vector<FArrayBox*> fabs;
+};
+
+namespace
+{
+    MFIter::WorkStealingStats ws_stats;
+
+    std::uint64_t
+    MortonKey (const IntVect& iv)
+    {
+        std::uint64_t key = 0;
+        const int nbits = std::min(64/AMREX_SPACEDIM, 31);
+        for (int b = 0; b < nbits; ++b) {
+            for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+                key |= static_cast<std::uint64_t>((iv[d] >> b) & 1) << (b*AMREX_SPACEDIM + d);
+            }
+        }
+        return key;
+    }
+}
+
 MFIter::MFIter (const FabArrayBase& fabarray_, 
 		unsigned char       flags_)
     :
@@ -125,6 +328,19 @@ MFIter::MFIter (const FabArrayBase& fabarray_, const MFItInfo& info)
     local_tile_index_map(nullptr),
     num_local_tiles(nullptr)
 {
+    overlap = info.overlap && fabarray_.fb_inflight != nullptr && !fabarray_.fb_pending.empty();
+    bool steal = info.work_stealing || (info.dynamic && FabArrayBase::mfiter_work_stealing);
+#ifdef BL_USE_TEAM
+    if (ParallelDescriptor::TeamSize() > 1) overlap = steal = false;
+#endif
+#ifdef _OPENMP
+    if (omp_get_num_threads() == 1) steal = false;
+#else
+    steal = false;
+#endif
+    if (overlap) dynamic = steal = false;
+    if (steal) dynamic = false;
+
     if (dynamic) {
 #ifdef _OPENMP
 #pragma omp barrier
@@ -137,9 +353,21 @@ MFIter::MFIter (const FabArrayBase& fabarray_, const MFItInfo& info)
     }
 
     Initialize();
+
+    if (info.cost)
+    {
+        BL_ASSERT(info.cost->DistributionMap() == fabarray_.DistributionMap());
+        m_cost    = info.cost;
+    }
+
+    if (steal) InitWorkStealing();
+
+    if (m_cost) m_cost_t0 = ParallelDescriptor::second();
 }
 
 
+MFIter::MFIter (MFIter&& rhs) = default;
+
 MFIter::~MFIter ()
 {
 #if BL_USE_TEAM
@@ -148,6 +376,225 @@ MFIter::~MFIter ()
 #endif
 }
 
+void
+MFIter::RecordCost ()
+{
+    const double t = ParallelDescriptor::second();
+    if (isValid())
+    {
+        Real& c = (*m_cost)[*this];
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+        c += t - m_cost_t0;
+    }
+    m_cost_t0 = t;
+}
+
+void
+MFIter::InitWorkStealing ()
+{
+#ifdef _OPENMP
+    const int ntot = index_map->size();
+
+#pragma omp barrier
+#pragma omp single
+    {
+        const int nthreads = omp_get_num_threads();
+        s_steal = std::make_shared<StealQueues>(nthreads);
+        StealQueues& sq = *s_steal;
+
+        //
+        // Space-filling-curve order of the tiles.
+        //
+        IntVect lo = IntVect::TheZeroVector();
+        if (ntot > 0) lo = (*tile_array)[0].smallEnd();
+        for (int i = 1; i < ntot; ++i) {
+            lo.min((*tile_array)[i].smallEnd());
+        }
+        Vector<std::pair<std::uint64_t,int> > keys(ntot);
+        for (int i = 0; i < ntot; ++i) {
+            keys[i] = std::make_pair(MortonKey((*tile_array)[i].smallEnd() - lo), i);
+        }
+        std::sort(keys.begin(), keys.end());
+        sq.order.resize(ntot);
+        for (int i = 0; i < ntot; ++i) {
+            sq.order[i] = keys[i].second;
+        }
+
+        //
+        // Contiguous chunks of about the same weight.
+        //
+        Vector<double> w(ntot);
+        bool use_cost = m_cost != nullptr;
+        for (int i = 0; i < ntot && use_cost; ++i) {
+            use_cost = (*m_cost)[(*index_map)[i]] > 0.0;
+        }
+        double wtot = 0.0;
+        for (int i = 0; i < ntot; ++i)
+        {
+            const int t = sq.order[i];
+            w[i] = (*tile_array)[t].numPts();
+            if (use_cost) {
+                const int bi = (*index_map)[t];
+                w[i] *= (*m_cost)[bi] / fabArray.box(bi).numPts();
+            }
+            wtot += w[i];
+        }
+        double wsum = 0.0;
+        int it = 0;
+        for (int tid = 0; tid < nthreads; ++tid)
+        {
+            const int ibegin = it;
+            const double wend = wtot * (tid+1) / nthreads;
+            while (it < ntot && (tid == nthreads-1 || wsum + 0.5*w[it] < wend)) {
+                wsum += w[it++];
+            }
+            sq.q[tid].range.store(StealQueues::pack(ibegin, it), std::memory_order_relaxed);
+        }
+    }
+
+    m_steal     = s_steal;
+    m_steal_tid = omp_get_thread_num();
+    endIndex    = ntot;
+    currentIndex = StealNext();
+#endif
+}
+
+int
+MFIter::StealNext ()
+{
+    StealQueues& sq = *m_steal;
+    const int tid = m_steal_tid;
+    const int n   = sq.nthreads;
+
+    int pos = -1;
+
+    std::uint64_t r = sq.q[tid].range.load(std::memory_order_acquire);
+    while (StealQueues::lo(r) < StealQueues::hi(r))
+    {
+        const int lo = StealQueues::lo(r);
+        if (sq.q[tid].range.compare_exchange_weak(r, StealQueues::pack(lo+1, StealQueues::hi(r)),
+                                                  std::memory_order_acq_rel))
+        {
+            pos = lo;
+            break;
+        }
+    }
+
+    //
+    // Steal half of what is left from the nearest thread that has some,
+    // trying tid+1, tid-1, tid+2, tid-2, ...
+    //
+    for (int d = 1; d < n && pos < 0; ++d)
+    {
+        const int v = ((d%2 == 1 ? tid + (d+1)/2 : tid - d/2) % n + n) % n;
+        r = sq.q[v].range.load(std::memory_order_acquire);
+        while (StealQueues::lo(r) < StealQueues::hi(r))
+        {
+            const int lo = StealQueues::lo(r);
+            const int hi = StealQueues::hi(r);
+            const int k  = (hi - lo + 1) / 2;
+            if (sq.q[v].range.compare_exchange_weak(r, StealQueues::pack(lo, hi-k),
+                                                    std::memory_order_acq_rel))
+            {
+                sq.q[tid].range.store(StealQueues::pack(hi-k+1, hi), std::memory_order_release);
+                ++sq.nsteals[tid];
+                pos = hi-k;
+                break;
+            }
+        }
+    }
+
+    if (pos >= 0)
+    {
+        ++sq.ntiles[tid];
+        return sq.order[pos];
+    }
+
+    //
+    // Out of work.  The last thread to finish charges each thread the
+    // time it waited.
+    //
+    sq.finish[tid] = ParallelDescriptor::second();
+    if (sq.nfinished.fetch_add(1, std::memory_order_acq_rel) == n-1)
+    {
+        const double tlast = *std::max_element(sq.finish.begin(), sq.finish.end());
+        if (ws_stats.idle.size() < n) {
+            ws_stats.ntiles.resize(n, 0);
+            ws_stats.nsteals.resize(n, 0);
+            ws_stats.idle.resize(n, 0.0);
+        }
+        ++ws_stats.nloops;
+        for (int i = 0; i < n; ++i) {
+            ws_stats.ntiles[i]  += sq.ntiles[i];
+            ws_stats.nsteals[i] += sq.nsteals[i];
+            ws_stats.idle[i]    += tlast - sq.finish[i];
+        }
+    }
+
+    return endIndex;
+}
+
+const MFIter::WorkStealingStats&
+MFIter::GetWorkStealingStats ()
+{
+    return ws_stats;
+}
+
+void
+MFIter::ResetWorkStealingStats ()
+{
+    ws_stats = WorkStealingStats();
+}
+
+void
+MFIter::PrintWorkStealingStats ()
+{
+    if (ws_stats.nloops == 0) return;
+
+    amrex::Print() << "### MFIter work stealing ###\n"
+                   << "    tot # of loops: " << ws_stats.nloops << "\n";
+    for (int i = 0; i < ws_stats.idle.size(); ++i) {
+        amrex::Print() << "    thread " << i
+                       << ": tiles " << ws_stats.ntiles[i]
+                       << ", steals " << ws_stats.nsteals[i]
+                       << ", idle " << ws_stats.idle[i] << " s\n";
+    }
+}
+
+FArrayBox&
+MFIter::scratchFab (const Box& bx, int ncomp)
+{
+    if (!m_scratch) {
+        m_scratch.reset(new ScratchScope(MyScratchArena()));
+    }
+
+    const std::size_t hdr = ScratchArena::aligned(sizeof(FArrayBox));
+    char* p = static_cast<char*>(m_scratch->arena->alloc(hdr + bx.numPts()*ncomp*sizeof(Real)));
+
+    FArrayBox* fab = new (p) FArrayBox(bx, ncomp, reinterpret_cast<Real*>(p+hdr));
+    m_scratch->fabs.push_back(fab);
+    return *fab;
+}
+
+void
+MFIter::ResetScratch ()
+{
+    m_scratch->release();
+}
+
+void
+MFIter::FinalizeScratch ()
+{
+    std::lock_guard<std::mutex> lock(scratch_mutex);
+    for (ScratchArena* a : scratch_arenas) {
+        delete a;
+    }
+    scratch_arenas.clear();
+    ++scratch_generation;
+}
+
 void 
 MFIter::Initialize ()
 {
@@ -237,7 +684,112 @@ MFIter::Initialize ()
 	currentIndex = beginIndex;
 
 	typ = fabArray.boxArray().ixType();
+
+        if (overlap) InitOverlap();
+    }
+}
+
+void
+MFIter::InitOverlap ()
+{
+#ifdef _OPENMP
+    overlap_master = (omp_get_thread_num() == 0);
+#endif
+
+    const FabArrayBase::FB& TheFB = *fabArray.fb_inflight;
+
+    Vector<Vector<Box> > rcvboxes(fabArray.local_size());
+    for (auto const& kv : *TheFB.m_RcvTags) {
+        for (auto const& tag : kv.second) {
+            rcvboxes[fabArray.localindex(tag.dstIndex)].push_back(tag.dbox);
+        }
+    }
+
+    ota.reset(new FabArrayBase::TileArray);
+
+    auto add_tile = [&] (int i) {
+        ota->indexMap.push_back((*index_map)[i]);
+        ota->localIndexMap.push_back((*local_index_map)[i]);
+        ota->localTileIndexMap.push_back((*local_tile_index_map)[i]);
+        ota->numLocalTiles.push_back((*num_local_tiles)[i]);
+        ota->tileArray.push_back((*tile_array)[i]);
+    };
+
+    //
+    // Tiles whose stencil does not reach remote ghost cells go first.
+    //
+    Vector<int> bndry;
+    for (int i = beginIndex; i < endIndex; ++i)
+    {
+        Box bx = (*tile_array)[i];
+        bx.convert(typ);
+        bx.grow(TheFB.m_ngrow);
+        bool interior = true;
+        for (auto const& b : rcvboxes[(*local_index_map)[i]]) {
+            if (b.intersects(bx)) {
+                interior = false;
+                break;
+            }
+        }
+        if (interior) {
+            add_tile(i);
+        } else {
+            bndry.push_back(i);
+        }
+    }
+    boundaryIndex = ota->indexMap.size();
+    for (int i : bndry) {
+        add_tile(i);
     }
+
+    index_map            = &(ota->indexMap);
+    local_index_map      = &(ota->localIndexMap);
+    tile_array           = &(ota->tileArray);
+    local_tile_index_map = &(ota->localTileIndexMap);
+    num_local_tiles      = &(ota->numLocalTiles);
+
+    beginIndex   = 0;
+    endIndex     = index_map->size();
+    currentIndex = 0;
+
+    OverlapSync();
+}
+
+void
+MFIter::OverlapSync ()
+{
+    // Only the master thread makes MPI calls.
+    FabArrayBase& fa = const_cast<FabArrayBase&>(fabArray);
+
+    if (currentIndex < boundaryIndex)
+    {
+        if (overlap_master) fa.FBRecvProgress(false);
+    }
+    else if (currentIndex < endIndex)
+    {
+        const int li = LocalIndex();
+        while (true)
+        {
+            int npending;
+#ifdef _OPENMP
+#pragma omp atomic read
+#endif
+            npending = fa.fb_pending[li];
+            if (npending == 0) break;
+            if (overlap_master && fa.FBRecvProgress(true)) break;
+        }
+#ifdef _OPENMP
+#pragma omp flush
+#endif
+    }
+    else if (overlap_master)
+    {
+        // Other threads may still be waiting for their ghost cells.
+        while (!fa.FBRecvProgress(true)) {;}
+    }
+
+    // Time spent waiting for ghost cells is not charged to the tile.
+    if (m_cost) m_cost_t0 = ParallelDescriptor::second();
 }
 
 Box 
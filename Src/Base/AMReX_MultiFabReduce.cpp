@@ -0,0 +1,266 @@
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <AMReX.H>
+#include <AMReX_MultiFabReduce.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_BLProfiler.H>
+
+namespace amrex {
+
+namespace
+{
+    bool isSum (MultiFabReduce::Op op)
+    {
+        return op == MultiFabReduce::Norm1 || op == MultiFabReduce::Norm2
+            || op == MultiFabReduce::Sum   || op == MultiFabReduce::Dot;
+    }
+
+#ifdef BL_USE_MPI
+    //
+    // The reductions are done on whole records of nops Reals, the sums
+    // followed by the maxima, so the op always sees complete records.
+    // The number of sums is an attribute of the record type.
+    //
+    int nsum_keyval = MPI_KEYVAL_INVALID;
+
+    void
+    reduce_records (void* invec, void* inoutvec, int* len, MPI_Datatype* dtype)
+    {
+        int nbytes;
+        MPI_Type_size(*dtype, &nbytes);
+        const int nops = nbytes / sizeof(Real);
+
+        void* attr;
+        int flag;
+        MPI_Type_get_attr(*dtype, nsum_keyval, &attr, &flag);
+        BL_ASSERT(flag);
+        const int nsum = static_cast<int>(reinterpret_cast<std::intptr_t>(attr));
+
+        const Real* in    = static_cast<const Real*>(invec);
+        Real*       inout = static_cast<Real*>(inoutvec);
+        for (int k = 0; k < *len; ++k, in += nops, inout += nops)
+        {
+            for (int i = 0; i < nsum; ++i) {
+                inout[i] += in[i];
+            }
+            for (int i = nsum; i < nops; ++i) {
+                inout[i] = std::max(inout[i], in[i]);
+            }
+        }
+    }
+#endif
+}
+
+int
+MultiFabReduce::add (const ReduceOp& rop)
+{
+    if (!m_ops.empty())
+    {
+        const MultiFab& mf0 = *m_ops[0].x;
+        amrex::ignore_unused(mf0);
+        BL_ASSERT(rop.x->boxArray() == mf0.boxArray());
+        BL_ASSERT(rop.x->DistributionMap() == mf0.DistributionMap());
+    }
+    BL_ASSERT(rop.nghost >= 0 && rop.nghost <= rop.x->nGrow());
+    BL_ASSERT(rop.xcomp >= 0 && rop.xcomp+rop.ncomp <= rop.x->nComp());
+
+    m_ops.push_back(rop);
+    return m_ops.size()-1;
+}
+
+int
+MultiFabReduce::norm0 (const MultiFab& mf, int comp, int nghost)
+{
+    return add({Norm0, &mf, comp, nullptr, 0, 1, nghost});
+}
+
+int
+MultiFabReduce::norm1 (const MultiFab& mf, int comp, int nghost)
+{
+    return add({Norm1, &mf, comp, nullptr, 0, 1, nghost});
+}
+
+int
+MultiFabReduce::norm2 (const MultiFab& mf, int comp)
+{
+    BL_ASSERT(mf.ixType().cellCentered());
+    return add({Norm2, &mf, comp, nullptr, 0, 1, 0});
+}
+
+int
+MultiFabReduce::sum (const MultiFab& mf, int comp)
+{
+    return add({Sum, &mf, comp, nullptr, 0, 1, 0});
+}
+
+int
+MultiFabReduce::min (const MultiFab& mf, int comp, int nghost)
+{
+    return add({Min, &mf, comp, nullptr, 0, 1, nghost});
+}
+
+int
+MultiFabReduce::max (const MultiFab& mf, int comp, int nghost)
+{
+    return add({Max, &mf, comp, nullptr, 0, 1, nghost});
+}
+
+int
+MultiFabReduce::dot (const MultiFab& x, int xcomp, const MultiFab& y, int ycomp,
+                     int numcomp, int nghost)
+{
+    BL_ASSERT(x.boxArray() == y.boxArray());
+    BL_ASSERT(x.DistributionMap() == y.DistributionMap());
+    BL_ASSERT(y.nGrow() >= nghost);
+    return add({Dot, &x, xcomp, &y, ycomp, numcomp, nghost});
+}
+
+void
+MultiFabReduce::clear ()
+{
+    m_ops.clear();
+    m_result.clear();
+}
+
+void
+MultiFabReduce::eval (bool local)
+{
+    BL_PROFILE("MultiFabReduce::eval()");
+
+    const int nops = m_ops.size();
+
+    m_result.assign(nops, 0.0);
+
+    if (nops == 0) return;
+
+    //
+    // buf holds the sums followed by the maxima.  Minima are stored negated
+    // so that they are reduced together with the maxima.
+    //
+    Vector<int> slot(nops);
+    int nsum = 0;
+    for (int i = 0; i < nops; ++i) {
+        if (isSum(m_ops[i].op)) slot[i] = nsum++;
+    }
+    for (int i = 0, k = nsum; i < nops; ++i) {
+        if (!isSum(m_ops[i].op)) slot[i] = k++;
+    }
+
+    Vector<Real> buf(nops, std::numeric_limits<Real>::lowest());
+    for (int i = 0; i < nsum; ++i) {
+        buf[i] = 0.0;
+    }
+
+#ifdef _OPENMP
+    const int nthreads = omp_get_max_threads();
+#else
+    const int nthreads = 1;
+#endif
+    Vector<Vector<Real> > priv(nthreads, buf);
+
+    const MultiFab& mf0 = *m_ops[0].x;
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+#ifdef _OPENMP
+        Vector<Real>& v = priv[omp_get_thread_num()];
+#else
+        Vector<Real>& v = priv[0];
+#endif
+        for (MFIter mfi(mf0,true); mfi.isValid(); ++mfi)
+        {
+            for (int i = 0; i < nops; ++i)
+            {
+                const ReduceOp& rop = m_ops[i];
+                const FArrayBox& xfab = (*rop.x)[mfi];
+                const Box& bx = mfi.growntilebox(rop.nghost);
+                Real& r = v[slot[i]];
+
+                switch (rop.op)
+                {
+                case Norm0:
+                    r = std::max(r, xfab.norm(bx, 0, rop.xcomp, 1));
+                    break;
+                case Norm1:
+                    r += xfab.norm(bx, 1, rop.xcomp, 1);
+                    break;
+                case Norm2:
+                    r += xfab.dot(bx, rop.xcomp, xfab, bx, rop.xcomp, 1);
+                    break;
+                case Sum:
+                    r += xfab.sum(bx, rop.xcomp, 1);
+                    break;
+                case Min:
+                    r = std::max(r, -xfab.min(bx, rop.xcomp));
+                    break;
+                case Max:
+                    r = std::max(r, xfab.max(bx, rop.xcomp));
+                    break;
+                case Dot:
+                    r += xfab.dot(bx, rop.xcomp, (*rop.y)[mfi], bx, rop.ycomp, rop.ncomp);
+                    break;
+                }
+            }
+        }
+    }
+
+    for (int it = 1; it < nthreads; ++it)
+    {
+        for (int i = 0; i < nsum; ++i) {
+            priv[0][i] += priv[it][i];
+        }
+        for (int i = nsum; i < nops; ++i) {
+            priv[0][i] = std::max(priv[0][i], priv[it][i]);
+        }
+    }
+    buf = priv[0];
+
+#ifdef BL_USE_MPI
+    if (!local)
+    {
+        if (nsum_keyval == MPI_KEYVAL_INVALID) {
+            BL_MPI_REQUIRE( MPI_Type_create_keyval(MPI_TYPE_NULL_COPY_FN, MPI_TYPE_NULL_DELETE_FN,
+                                                   &nsum_keyval, nullptr) );
+        }
+
+        MPI_Datatype record;
+        BL_MPI_REQUIRE( MPI_Type_contiguous(nops, ParallelDescriptor::Mpi_typemap<Real>::type(),
+                                            &record) );
+        BL_MPI_REQUIRE( MPI_Type_commit(&record) );
+        BL_MPI_REQUIRE( MPI_Type_set_attr(record, nsum_keyval,
+                                          reinterpret_cast<void*>(static_cast<std::intptr_t>(nsum))) );
+        MPI_Op op;
+        BL_MPI_REQUIRE( MPI_Op_create(reduce_records, 1, &op) );
+
+        BL_MPI_REQUIRE( MPI_Allreduce(MPI_IN_PLACE, buf.dataPtr(), 1, record, op,
+                                      ParallelDescriptor::Communicator()) );
+
+        BL_MPI_REQUIRE( MPI_Op_free(&op) );
+        BL_MPI_REQUIRE( MPI_Type_free(&record) );
+    }
+#endif
+
+    for (int i = 0; i < nops; ++i)
+    {
+        Real r = buf[slot[i]];
+        if (m_ops[i].op == Norm2) {
+            r = std::sqrt(r);
+        } else if (m_ops[i].op == Min) {
+            r = -r;
+        }
+        m_result[i] = r;
+    }
+}
+
+}
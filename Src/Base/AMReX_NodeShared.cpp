@@ -0,0 +1,164 @@
+
+#include <map>
+
+#include <AMReX.H>
+#include <AMReX_NodeShared.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_Vector.H>
+
+namespace amrex {
+namespace NodeShared {
+
+namespace
+{
+    int node_size = 1;
+    int node_rank = 0;
+    int next_id   = 0;
+
+#if defined(BL_USE_MPI) && (MPI_VERSION >= 3)
+    MPI_Comm node_comm = MPI_COMM_NULL;
+
+    struct Window
+    {
+        MPI_Win               win;
+        bool                  released;
+        std::function<void()> unshare;
+    };
+
+    //
+    // Ordered by id, which is the same on all the processes of the node
+    // since the windows are made collectively.
+    //
+    std::map<int,Window> windows;
+#endif
+}
+
+void
+Initialize (bool on)
+{
+    node_size = 1;
+    node_rank = 0;
+    next_id   = 0;
+
+#if defined(BL_USE_MPI) && (MPI_VERSION >= 3)
+    if (on)
+    {
+        node_comm = ParallelDescriptor::NodeCommunicator();
+        MPI_Comm_size(node_comm, &node_size);
+        MPI_Comm_rank(node_comm, &node_rank);
+        if (node_size == 1) {
+            node_comm = MPI_COMM_NULL;
+            node_rank = 0;
+        }
+    }
+#endif
+}
+
+void
+Finalize ()
+{
+#if defined(BL_USE_MPI) && (MPI_VERSION >= 3)
+    for (auto& kv : windows) {
+        if (!kv.second.released && kv.second.unshare) {
+            kv.second.unshare();
+        }
+    }
+    for (auto& kv : windows) {
+        MPI_Win_free(&kv.second.win);
+    }
+    windows.clear();
+
+    node_comm = MPI_COMM_NULL;
+#endif
+    node_size = 1;
+    node_rank = 0;
+}
+
+bool
+Enabled ()
+{
+    return node_size > 1;
+}
+
+int
+Rank ()
+{
+    return node_rank;
+}
+
+char*
+Share (std::size_t nbytes,
+       const std::function<void(char*)>& fill,
+       const std::function<void()>& unshare,
+       int& id)
+{
+#if defined(BL_USE_MPI) && (MPI_VERSION >= 3)
+    BL_ASSERT(Enabled());
+
+    Collect();
+
+    char* p;
+    MPI_Win win;
+    const MPI_Aint bytes = (node_rank == 0) ? nbytes : 0;
+    BL_MPI_REQUIRE( MPI_Win_allocate_shared(bytes, 1, MPI_INFO_NULL, node_comm, &p, &win) );
+
+    MPI_Aint sz;
+    int disp;
+    BL_MPI_REQUIRE( MPI_Win_shared_query(win, 0, &sz, &disp, &p) );
+
+    BL_MPI_REQUIRE( MPI_Win_fence(0, win) );
+    if (node_rank == 0) {
+        fill(p);
+    }
+    BL_MPI_REQUIRE( MPI_Win_fence(0, win) );
+
+    id = next_id++;
+    windows[id] = Window{win, false, unshare};
+
+    return p;
+#else
+    amrex::Abort("NodeShared::Share: MPI-3 is required");
+    return nullptr;
+#endif
+}
+
+void
+Release (int id)
+{
+#if defined(BL_USE_MPI) && (MPI_VERSION >= 3)
+    auto it = windows.find(id);
+    if (it != windows.end()) {
+        it->second.released = true;
+        it->second.unshare = nullptr;
+    }
+#endif
+}
+
+void
+Collect ()
+{
+#if defined(BL_USE_MPI) && (MPI_VERSION >= 3)
+    if (node_comm == MPI_COMM_NULL || windows.empty()) return;
+
+    Vector<int> released;
+    for (const auto& kv : windows) {
+        released.push_back(kv.second.released);
+    }
+    BL_MPI_REQUIRE( MPI_Allreduce(MPI_IN_PLACE, released.dataPtr(), released.size(),
+                                  MPI_INT, MPI_MIN, node_comm) );
+
+    int k = 0;
+    for (auto it = windows.begin(); it != windows.end(); ++k)
+    {
+        if (released[k]) {
+            MPI_Win_free(&it->second.win);
+            it = windows.erase(it);
+        } else {
+            ++it;
+        }
+    }
+#endif
+}
+
+}
+}
@@ -0,0 +1,335 @@
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include <AMReX_PArena.H>
+#include <AMReX_BLassert.H>
+
+namespace amrex {
+
+namespace
+{
+    std::atomic<long> parena_counter(0);
+
+    //
+    // A small direct-mapped cache from arena id to the calling thread's
+    // ThreadCache.  It is trivially destructible so that it can still be
+    // used while static objects are being destroyed.
+    //
+    struct TLEntry
+    {
+        long  id;
+        void* cache;
+    };
+    constexpr int tl_nentries = 8;
+    thread_local TLEntry tl_caches[tl_nentries] = {};
+    thread_local bool tl_exited = false;
+
+    //
+    // The live arenas by id.  It is never destroyed, because threads may
+    // exit after static objects have been destroyed.
+    //
+    std::mutex& registry_mutex ()
+    {
+        static std::mutex* m = new std::mutex;
+        return *m;
+    }
+    std::map<long,PArena*>& registry ()
+    {
+        static std::map<long,PArena*>* r = new std::map<long,PArena*>;
+        return *r;
+    }
+}
+
+//
+// Hands the calling thread's caches back to their arenas when the thread
+// exits, so that the next thread can reuse the memory in them.
+//
+struct PArena::ThreadExit
+{
+    ~ThreadExit ()
+    {
+        tl_exited = true;
+        for (auto& e : tl_caches) {
+            e.id = 0;
+        }
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        for (const auto& kv : caches)
+        {
+            auto it = registry().find(kv.first);
+            if (it != registry().end()) {
+                it->second->releaseCache(kv.second);
+            }
+        }
+    }
+    std::vector<std::pair<long,ThreadCache*> > caches;
+};
+
+PArena::PArena (std::size_t chunk_size)
+{
+    static_assert(sizeof(Header) % Arena::align_size == 0,
+                  "PArena: Header must not break the alignment");
+
+    m_chunk = Arena::align(chunk_size == 0 ? DefaultChunkSize : chunk_size);
+    m_chunk = std::max<std::size_t>(m_chunk, MaxClassSize);
+    m_used  = 0;
+    m_id    = ++parena_counter;
+    //
+    // Four size classes per power of two, 64, 80, 96, 112, 128, 160, ...
+    //
+    m_class_size.push_back(64);
+    for (std::size_t base = 64; base < MaxClassSize; base *= 2) {
+        for (std::size_t k = 5; k <= 8; ++k) {
+            m_class_size.push_back(base*k/4);
+        }
+    }
+
+    BL_ASSERT(m_class_size.back() == MaxClassSize);
+
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    registry()[m_id] = this;
+}
+
+PArena::~PArena ()
+{
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+        registry().erase(m_id);
+    }
+
+    std::vector<ThreadCache*> all = m_idle;
+    for (auto& kv : m_caches) {
+        all.push_back(kv.second);
+    }
+    for (ThreadCache* tc : all)
+    {
+        for (void* p : tc->chunks) {
+            std::free(p);
+        }
+        delete tc;
+    }
+}
+
+void*
+PArena::sysAlloc (std::size_t nbytes, bool huge)
+{
+    void* p = nullptr;
+    const std::size_t alignment = huge ? std::size_t(HugePageSize) : std::size_t(Arena::align_size);
+    if (posix_memalign(&p, alignment, nbytes) != 0) {
+        throw std::bad_alloc();
+    }
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (huge) {
+        madvise(p, nbytes, MADV_HUGEPAGE);
+    }
+#endif
+    return p;
+}
+
+PArena::ThreadCache*
+PArena::myCache ()
+{
+    TLEntry& e = tl_caches[m_id % tl_nentries];
+
+    if (e.id == m_id) {
+        return static_cast<ThreadCache*>(e.cache);
+    }
+
+    ThreadCache* tc;
+    bool is_new = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ThreadCache*& p = m_caches[std::this_thread::get_id()];
+        if (p == nullptr)
+        {
+            //
+            // Adopt the cache of a thread that has exited if there is one.
+            // Blocks still out from it keep pointing to it as their owner.
+            //
+            if (m_idle.empty()) {
+                p = new ThreadCache(m_class_size.size());
+            } else {
+                p = m_idle.back();
+                m_idle.pop_back();
+            }
+            is_new = true;
+        }
+        tc = p;
+    }
+
+    if (is_new && !tl_exited)
+    {
+        static thread_local ThreadExit tl_exit;
+        tl_exit.caches.emplace_back(m_id, tc);
+    }
+
+    e.id    = m_id;
+    e.cache = tc;
+
+    return tc;
+}
+
+int
+PArena::sizeClass (std::size_t nbytes) const
+{
+    return std::lower_bound(m_class_size.begin(), m_class_size.end(), nbytes)
+        - m_class_size.begin();
+}
+
+void
+PArena::drainRemote (ThreadCache& tc)
+{
+    Block* b = tc.remote.exchange(nullptr, std::memory_order_acquire);
+    while (b)
+    {
+        Block* next = b->next;
+        const int cls = reinterpret_cast<Header*>(b)->cls;
+        b->next = tc.freelist[cls];
+        tc.freelist[cls] = b;
+        b = next;
+    }
+}
+
+void
+PArena::refill (ThreadCache& tc, int cls)
+{
+    const std::size_t sz = m_class_size[cls];
+
+    if (tc.bump + sz > tc.bump_end)
+    {
+        //
+        // Hand the rest of the current chunk out to the smaller classes.
+        //
+        for (int c = cls-1; c >= 0; --c)
+        {
+            while (tc.bump + m_class_size[c] <= tc.bump_end)
+            {
+                Block* b = reinterpret_cast<Block*>(tc.bump);
+                reinterpret_cast<Header*>(b)->cls = c;
+                b->next = tc.freelist[c];
+                tc.freelist[c] = b;
+                tc.bump += m_class_size[c];
+            }
+        }
+
+        char* p = static_cast<char*>(sysAlloc(m_chunk, true));
+        tc.chunks.push_back(p);
+        tc.bump     = p;
+        tc.bump_end = p + m_chunk;
+        m_used += m_chunk;
+    }
+
+    Block* b = reinterpret_cast<Block*>(tc.bump);
+    b->next = nullptr;
+    tc.freelist[cls] = b;
+    tc.bump += sz;
+}
+
+void*
+PArena::alloc (std::size_t nbytes)
+{
+    const std::size_t tot = Arena::align(nbytes == 0 ? 1 : nbytes) + sizeof(Header);
+
+    if (tot > MaxClassSize)
+    {
+        Header* h = static_cast<Header*>(sysAlloc(tot, tot >= HugePageSize));
+        h->owner = nullptr;
+        h->cls   = tot;
+        m_used += tot;
+        return h + 1;
+    }
+
+    ThreadCache& tc = *myCache();
+    const int cls = sizeClass(tot);
+
+    if (tc.freelist[cls] == nullptr) {
+        drainRemote(tc);
+    }
+    if (tc.freelist[cls] == nullptr) {
+        refill(tc, cls);
+    }
+
+    Block* b = tc.freelist[cls];
+    tc.freelist[cls] = b->next;
+
+    Header* h = reinterpret_cast<Header*>(b);
+    h->owner = &tc;
+    h->cls   = cls;
+
+    return h + 1;
+}
+
+void
+PArena::free (void* vp)
+{
+    if (vp == 0)
+        //
+        // Allow calls with NULL as allowed by C++ delete.
+        //
+        return;
+
+    Header* h = static_cast<Header*>(vp) - 1;
+    ThreadCache* owner = h->owner;
+
+    if (owner == nullptr)
+    {
+        m_used -= h->cls;
+        std::free(h);
+        return;
+    }
+
+    BL_ASSERT(h->cls < m_class_size.size());
+
+    Block* b = reinterpret_cast<Block*>(h);
+
+    //
+    // Do not go through myCache here: a thread that only frees should not
+    // take a cache.  Pushing onto our own remote list is fine too.
+    //
+    const TLEntry& e = tl_caches[m_id % tl_nentries];
+
+    if (e.id == m_id && e.cache == owner)
+    {
+        b->next = owner->freelist[h->cls];
+        owner->freelist[h->cls] = b;
+    }
+    else
+    {
+        //
+        // Lock-free push onto the owner's remote list.  Only the owner pops,
+        // and it takes the whole list at once, so there is no ABA problem.
+        //
+        Block* head = owner->remote.load(std::memory_order_relaxed);
+        do {
+            b->next = head;
+        } while (!owner->remote.compare_exchange_weak(head, b,
+                                                      std::memory_order_release,
+                                                      std::memory_order_relaxed));
+    }
+}
+
+void
+PArena::releaseCache (ThreadCache* tc)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_caches.find(std::this_thread::get_id());
+    if (it != m_caches.end() && it->second == tc)
+    {
+        m_caches.erase(it);
+        m_idle.push_back(tc);
+    }
+}
+
+std::size_t
+PArena::heap_space_used () const
+{
+    return m_used;
+}
+
+}
@@ -47,8 +47,14 @@ namespace ParallelDescriptor
     ProcessTeam m_Team;
 
     MPI_Comm m_comm = MPI_COMM_NULL;    // communicator for all ranks, probably MPI_COMM_WORLD
+    MPI_Comm m_node_comm = MPI_COMM_NULL;  // the ranks of m_comm that share memory with this one
 
-    int m_MinTag = 1000, m_MaxTag = -1;
+    //
+    // SeqNum() cycles through [m_MinTag, m_MaxTag].  The tag just below that
+    // range is reserved for the persistent communication plans of FabArrayBase.
+    //
+    int m_MinTag = 1001, m_MaxTag = -1;
+    const int m_PersistentCommTag = 1000;
 
     const int ioProcessor = 0;
 
@@ -323,6 +329,11 @@ ParallelDescriptor::StartParallel (int*    argc,
     if (mpi_version < 3) amrex::Abort("MPI 3 is needed because USE_MPI3=TRUE");
 #endif
 
+#if defined(MPI_VERSION) && (MPI_VERSION >= 3)
+    BL_MPI_REQUIRE( MPI_Comm_split_type(m_comm, MPI_COMM_TYPE_SHARED, 0,
+                                        MPI_INFO_NULL, &m_node_comm) );
+#endif
+
     ParallelContext::push(m_comm);
 
     // Wait until all other processes are properly started.
@@ -334,6 +345,10 @@ ParallelDescriptor::EndParallel ()
 {
     ParallelContext::pop();
 
+    if (m_node_comm != MPI_COMM_NULL) {
+        BL_MPI_REQUIRE( MPI_Comm_free(&m_node_comm) );
+    }
+
     if (call_mpi_finalize) {
         BL_MPI_REQUIRE( MPI_Finalize() );
     } else {
@@ -1670,6 +1685,23 @@ ParallelDescriptor::Waitsome (Vector<MPI_Request>& reqs,
     BL_COMM_PROFILE_WAITSOME(BLProfiler::Waitsome, reqs, indx.size(), status, false);
 }
 
+void
+ParallelDescriptor::Testsome (Vector<MPI_Request>& reqs,
+                              int&                completed,
+                              Vector<int>&         indx,
+                              Vector<MPI_Status>&  status)
+{
+    BL_ASSERT(status.size() >= reqs.size());
+    BL_ASSERT(indx.size() >= reqs.size());
+
+    BL_PROFILE_S("ParallelDescriptor::Testsome()");
+    BL_MPI_REQUIRE( MPI_Testsome(reqs.size(),
+                                 reqs.dataPtr(),
+                                 &completed,
+                                 indx.dataPtr(),
+                                 status.dataPtr()));
+}
+
 void
 ParallelDescriptor::Bcast(void *buf,
                           int count,
@@ -1875,6 +1907,15 @@ ParallelDescriptor::Waitsome (Vector<MPI_Request>& reqs,
                               Vector<MPI_Status>&  status)
 {}
 
+void
+ParallelDescriptor::Testsome (Vector<MPI_Request>& reqs,
+                              int&                completed,
+                              Vector<int>&         indx,
+                              Vector<MPI_Status>&  status)
+{
+    completed = 0;
+}
+
 #endif
 
 BL_FORT_PROC_DECL(BL_PD_BARRIER,bl_pd_barrier)()
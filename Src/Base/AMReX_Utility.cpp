@@ -503,7 +503,7 @@ int amrex::HashDistributionMap(const DistributionMapping &dm, int hashSize)
 {
   BL_ASSERT(hashSize > 0);
 
-  const Vector<int> &dmArrayMap = dm.ProcessorMap();
+  const auto& dmArrayMap = dm.ProcessorMap();
   Vector<long> hash(hashSize, 0);
 
   // Create hash by summing processer map over
@@ -5,19 +5,40 @@
 #include <sstream>
 #include <vector>
 #include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BL_VISMF_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BL_VISMF_POSIX
+#include <unistd.h>
+#endif
 
 #include <AMReX_ccse-mpi.H>
 #include <AMReX_Utility.H>
 #include <AMReX_VisMF.H>
+#include <AMReX_AoSoAFab.H>
 #include <AMReX_ParmParse.H>
 #include <AMReX_NFiles.H>
 #include <AMReX_FPC.H>
+#include <AMReX_AsyncOut.H>
+#include <AMReX_Compression.H>
 
 namespace amrex {
 
 static const char *TheMultiFabHdrFileSuffix = "_H";
 static const char *FabFileSuffix = "_D_";
+static const char *FoldedFabFileSuffix = "_DF_";
 static const char *TheFabOnDiskPrefix = "FabOnDisk:";
 
 std::map<std::string, VisMF::PersistentIFStream> VisMF::persistentIFStreams;
@@ -31,8 +52,13 @@ bool VisMF::useSingleWrite(false);
 bool VisMF::checkFilePositions(false);
 bool VisMF::usePersistentIFStreams(false);
 bool VisMF::useSynchronousReads(false);
+bool VisMF::useMMap(false);
 bool VisMF::useDynamicSetSelection(true);
 bool VisMF::allowSparseWrites(true);
+Real VisMF::compressionTol(0.0);
+long VisMF::compressionBlockSize(256*1024);
+std::string VisMF::deltaDir;
+std::string VisMF::deltaBaseDir;
 
 long VisMF::ioBufferSize(VisMF::IO_Buffer_Size);
 
@@ -46,6 +72,502 @@ int VisMF::nMFFileInStreams(4);
 namespace
 {
     bool initialized = false;
+
+    //
+    // Set the ghost cells of each fab to one-half the average of the min
+    // and max over its valid region.
+    //
+    template <class FAB>
+    void
+    SetGhostToMidRange (const FabArray<FAB>& mf)
+    {
+        typedef typename FAB::value_type value_type;
+
+        FabArray<FAB>* the_mf = const_cast<FabArray<FAB>*>(&mf);
+
+        for(MFIter mfi(*the_mf); mfi.isValid(); ++mfi) {
+            const int idx(mfi.index());
+
+            for(int j(0); j < mf.nComp(); ++j) {
+                const value_type valMin(mf[mfi].min(mf.box(idx), j));
+                const value_type valMax(mf[mfi].max(mf.box(idx), j));
+                const value_type val((valMin + valMax) / 2);
+
+                the_mf->get(mfi).setComplement(val, mf.box(idx), j, 1);
+            }
+        }
+    }
+
+    //
+    // A data file mapped into memory.  It is unmapped when the last fab
+    // pointing into it goes away.
+    //
+    struct MappedFile
+    {
+        char        *base   = nullptr;
+        std::size_t  length = 0;
+#ifdef BL_VISMF_MMAP
+        dev_t        dev;
+        ino_t        ino;
+        time_t       mtime;
+#endif
+        ~MappedFile ()
+        {
+#ifdef BL_VISMF_MMAP
+            if(base != nullptr) {
+                munmap(base, length);
+            }
+#endif
+        }
+    };
+
+    //
+    // The mappings made, guarded by mappedFilesMutex since readFAB may be
+    // called from threads.
+    //
+    std::map<std::string, std::weak_ptr<MappedFile> > mappedFiles;
+    std::mutex mappedFilesMutex;
+
+    //
+    // Map fileName, or share the mapping of it made earlier if the file is
+    // the same.  Returns null if the file cannot be mapped.
+    //
+    std::shared_ptr<MappedFile>
+    MapFile (const std::string &fileName)
+    {
+        std::shared_ptr<MappedFile> mfile;
+#ifdef BL_VISMF_MMAP
+        struct stat st;
+        if(stat(fileName.c_str(), &st) != 0 || st.st_size <= 0) {
+          return mfile;
+        }
+
+        std::lock_guard<std::mutex> lock(mappedFilesMutex);
+        mfile = mappedFiles[fileName].lock();
+        if(mfile && mfile->dev == st.st_dev && mfile->ino == st.st_ino &&
+           mfile->mtime == st.st_mtime && mfile->length == std::size_t(st.st_size))
+        {
+          return mfile;
+        }
+        mfile.reset();
+
+        const int fd = open(fileName.c_str(), O_RDONLY);
+        if(fd < 0) {
+          return mfile;
+        }
+        if(fstat(fd, &st) == 0 && st.st_size > 0) {
+          void *p = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+          if(p != MAP_FAILED) {
+            // ---- do not read ahead of what is touched
+            madvise(p, st.st_size, MADV_RANDOM);
+            mfile = std::make_shared<MappedFile>();
+            mfile->base   = static_cast<char *>(p);
+            mfile->length = st.st_size;
+            mfile->dev    = st.st_dev;
+            mfile->ino    = st.st_ino;
+            mfile->mtime  = st.st_mtime;
+            mappedFiles[fileName] = mfile;
+          }
+        }
+        close(fd);
+#else
+        amrex::ignore_unused(fileName);
+#endif
+        return mfile;
+    }
+
+    //
+    // An FArrayBox whose data live in a mapped file.
+    //
+    class MappedFab
+        :
+        public FArrayBox
+    {
+    public:
+        MappedFab (const Box &b, int ncomp, Real *p, std::shared_ptr<MappedFile> mfile)
+            :
+            FArrayBox(b, ncomp, p),
+            m_file(std::move(mfile))
+        {}
+    private:
+        std::shared_ptr<MappedFile> m_file;
+    };
+
+    //
+    // The number of blocks a component of npts values is split into in
+    // the Compressed_v1 format.
+    //
+    inline long
+    NCompressedBlocks (long npts, long cblock)
+    {
+        return std::max(1L, (npts + cblock - 1) / cblock);
+    }
+
+    //
+    // Where AsyncWrite puts the data of each process.  The processes are
+    // grouped into files as NFilesIter::FileNumber does, and those of a
+    // file follow each other in the order of their ranks.  nBytes holds
+    // the bytes of every process.  offset is where the data of a process
+    // start in its file, and fileSize the size of each file.
+    //
+    void
+    AsyncFileLayout (const Vector<long> &nBytes, int nOutFiles, bool groupSets,
+                     Vector<int> &fileNumber, Vector<long> &offset,
+                     Vector<long> &fileSize)
+    {
+      const int nProcs(nBytes.size());
+      fileNumber.resize(nProcs);
+      offset.resize(nProcs);
+      fileSize.assign(NFilesIter::ActualNFiles(nOutFiles), 0L);
+      for(int rank(0); rank < nProcs; ++rank) {
+        fileNumber[rank] = NFilesIter::FileNumber(nOutFiles, rank, groupSets);
+        offset[rank] = fileSize[fileNumber[rank]];
+        fileSize[fileNumber[rank]] += nBytes[rank];
+      }
+    }
+
+    //
+    // Let the I/O thread write nBytes of stage at offset in fileName.
+    // Other processes write the rest of the file at the same time, so it
+    // is neither truncated nor appended to when it is opened.  Whoever
+    // writes the end of the file cuts it to fileSize afterwards, in case
+    // an older file was longer.
+    //
+    void
+    SubmitAsyncWrite (const std::shared_ptr<char> &stage, long nBytes, long reserved,
+                      const std::string &fileName, long offset, long fileSize)
+    {
+      const bool isLast(offset + nBytes == fileSize);
+      AsyncOut::Submit([stage, nBytes, fileName, offset, fileSize, isLast] ()
+      {
+        {
+          std::ofstream ofs(fileName.c_str(), std::ios::out | std::ios::app | std::ios::binary);
+          if( ! ofs.good()) {
+            throw std::runtime_error("couldn't open file: " + fileName);
+          }
+        }
+        std::fstream fs(fileName.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+        fs.seekp(offset, std::ios::beg);
+        fs.write(stage.get(), nBytes);
+        fs.close();
+        if(fs.fail()) {
+          throw std::runtime_error("write failed: " + fileName);
+        }
+#ifdef BL_VISMF_POSIX
+        if(isLast && ::truncate(fileName.c_str(), fileSize) != 0) {
+          throw std::runtime_error("couldn't truncate file: " + fileName);
+        }
+#else
+        amrex::ignore_unused(fileSize, isLast);
+#endif
+      }, reserved);
+    }
+
+    //
+    // Read components [scomp, scomp+ncomp) of fab idx of a Compressed_v1
+    // FabArray into components [0, ncomp) of fab.  is is at the start of
+    // the fab.  Only the blocks of those components are read, and they
+    // are decompressed in parallel.
+    //
+    void
+    ReadCompressed (std::istream        &is,
+                    const VisMF::Header &hdr,
+                    int                  idx,
+                    int                  scomp,
+                    int                  ncomp,
+                    FArrayBox           &fab)
+    {
+        const long npts(fab.box().numPts());
+        const long cblock(hdr.m_cblock);
+        const long nBlocks(NCompressedBlocks(npts, cblock));
+        const Vector<long> &csize = hdr.m_csize[idx];
+        BL_ASSERT(csize.size() == nBlocks * hdr.m_ncomp);
+
+        const long first(scomp * nBlocks), last((scomp + ncomp) * nBlocks);
+        long skip(0);
+        for(long i(0); i < first; ++i) {
+          skip += csize[i];
+        }
+        Vector<long> offset(last - first + 1, 0L);
+        for(long i(first); i < last; ++i) {
+          offset[i-first+1] = offset[i-first] + csize[i];
+        }
+
+        Vector<char> data(offset.back());
+        is.seekg(skip, std::ios::cur);
+        is.read(data.dataPtr(), data.size());
+        if(is.fail()) {
+          amrex::Error("VisMF: read of compressed fab failed");
+        }
+
+        const RealDescriptor &rd = hdr.m_writtenRD;
+        const bool doConvert(rd != FPC::NativeRealDescriptor());
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+          Vector<char> converted;
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+          for(long i = first; i < last; ++i) {
+            const int  n(i / nBlocks);
+            const long b(i % nBlocks);
+            const long nValues(std::min(cblock, npts - b*cblock));
+            Real *dst = fab.dataPtr(n - scomp) + b*cblock;
+            const char *src = data.dataPtr() + offset[i-first];
+            if(doConvert) {
+              converted.resize(nValues * rd.numBytes());
+              Compression::Decompress(src, csize[i], converted.dataPtr(), converted.size());
+              RealDescriptor::convertToNativeFormat(dst, nValues, converted.dataPtr(), rd);
+            } else {
+              Compression::Decompress(src, csize[i], reinterpret_cast<char *>(dst),
+                                      nValues * sizeof(Real));
+            }
+          }
+        }
+    }
+
+    //
+    // Parse a fab header of the "new" binary format, which is one line,
+    // for its RealDescriptor.  Returns false for any other format.
+    //
+    bool
+    ParseFabHeader (const std::string &line,
+                    const Box         &fabBox,
+                    int                nComp,
+                    RealDescriptor    &rd)
+    {
+        std::istringstream hss(line);
+        char f, a, b, c;
+        hss >> f >> a >> b >> c;
+        if(hss.fail() || f != 'F' || a != 'A' || b != 'B' || c == ':') {
+          return false;
+        }
+        hss.putback(c);
+        Box bx;
+        int nvar(-1);
+        hss >> rd >> bx >> nvar;
+        return ! hss.fail() && bx == fabBox && nvar == nComp;
+    }
+
+    //
+    // Read components comps of fab idx on disk, restricted to fab.box(),
+    // into fab.
+    //
+    void
+    ReadFabRegion (std::istream        &is,
+                   const VisMF::Header &hdr,
+                   int                  idx,
+                   const Vector<int>   &comps,
+                   FArrayBox           &fab)
+    {
+        const Box fabBox(amrex::grow(hdr.m_ba[idx], hdr.m_ngrow));
+        const Box &sub = fab.box();
+        const long npts(fabBox.numPts());
+        const long nx(sub.length(0));
+        long head(hdr.m_fod[idx].m_head);
+        RealDescriptor rd(hdr.m_writtenRD);
+
+        if(hdr.m_vers == VisMF::Header::Version_v1) {
+          std::string line;
+          is.seekg(head, std::ios::beg);
+          std::getline(is, line);
+          if( ! ParseFabHeader(line, fabBox, hdr.m_ncomp, rd)) {
+            // ---- the old fab header:  read the whole fab
+            FArrayBox tmp;
+            is.seekg(head, std::ios::beg);
+            tmp.readFrom(is);
+            for(int n(0); n < comps.size(); ++n) {
+              fab.copy(tmp, sub, comps[n], sub, n, 1);
+            }
+            return;
+          }
+          head += line.size() + 1;
+        }
+
+        //
+        // Each row of sub along the first direction is contiguous on disk.
+        //
+        Box rows(sub);
+        rows.setBig(0, sub.smallEnd(0));
+
+        if(hdr.m_vers == VisMF::Header::Compressed_v1) {
+          //
+          // Read and decompress the blocks spanning sub in each component.
+          //
+          const long cblock(hdr.m_cblock);
+          const long nBlocks(NCompressedBlocks(npts, cblock));
+          const Vector<long> &csize = hdr.m_csize[idx];
+          const bool doConvert(rd != FPC::NativeRealDescriptor());
+          Vector<char> data, converted;
+          Vector<Real> values;
+          for(int n(0); n < comps.size(); ++n) {
+            const long b0(fabBox.index(sub.smallEnd()) / cblock);
+            const long b1(fabBox.index(sub.bigEnd())   / cblock);
+            long skip(0), nBytes(0);
+            for(long b(0); b < comps[n]*nBlocks + b0; ++b) {
+              skip += csize[b];
+            }
+            for(long b(b0); b <= b1; ++b) {
+              nBytes += csize[comps[n]*nBlocks + b];
+            }
+            data.resize(nBytes);
+            is.seekg(head + skip, std::ios::beg);
+            is.read(data.dataPtr(), nBytes);
+
+            const long first(b0 * cblock);
+            values.resize(std::min((b1 + 1) * cblock, npts) - first);
+            const char *src = data.dataPtr();
+            for(long b(b0); b <= b1; ++b) {
+              const long nValues(std::min(cblock, npts - b*cblock));
+              Real *dst = values.dataPtr() + (b - b0) * cblock;
+              const long count(csize[comps[n]*nBlocks + b]);
+              if(doConvert) {
+                converted.resize(nValues * rd.numBytes());
+                Compression::Decompress(src, count, converted.dataPtr(), converted.size());
+                RealDescriptor::convertToNativeFormat(dst, nValues, converted.dataPtr(), rd);
+              } else {
+                Compression::Decompress(src, count, reinterpret_cast<char *>(dst),
+                                        nValues * sizeof(Real));
+              }
+              src += count;
+            }
+
+            for(IntVect iv(rows.smallEnd()); iv <= rows.bigEnd(); rows.next(iv)) {
+              std::memcpy(fab.dataPtr(n) + sub.index(iv),
+                          values.dataPtr() + fabBox.index(iv) - first, nx * sizeof(Real));
+            }
+          }
+        } else {
+          //
+          // Merge the rows that are contiguous both on disk and in fab.
+          //
+          struct Run
+          {
+              long  first;
+              long  nValues;
+              Real *dst;
+          };
+          Vector<Run> runs;
+          for(int n(0); n < comps.size(); ++n) {
+            for(IntVect iv(rows.smallEnd()); iv <= rows.bigEnd(); rows.next(iv)) {
+              const long first(comps[n] * npts + fabBox.index(iv));
+              Real *dst = fab.dataPtr(n) + sub.index(iv);
+              if( ! runs.empty() && runs.back().first + runs.back().nValues == first
+                                 && runs.back().dst   + runs.back().nValues == dst)
+              {
+                runs.back().nValues += nx;
+              } else {
+                runs.push_back(Run{first, nx, dst});
+              }
+            }
+          }
+
+          const bool doConvert(rd != FPC::NativeRealDescriptor());
+          for(int i(0); i < runs.size(); ++i) {
+            is.seekg(head + runs[i].first * rd.numBytes(), std::ios::beg);
+            if(doConvert) {
+              RealDescriptor::convertToNativeFormat(runs[i].dst, runs[i].nValues, is, rd);
+            } else {
+              is.read(reinterpret_cast<char *>(runs[i].dst), runs[i].nValues * sizeof(Real));
+            }
+          }
+        }
+
+        if(is.fail()) {
+          amrex::Error("VisMF::ReadRegion:  read failed");
+        }
+    }
+
+    //
+    // A 64-bit hash of the nbytes bytes at p, for telling which fabs of
+    // a delta write changed.  It is fast, not cryptographic.
+    //
+    std::uint64_t
+    HashBytes (const char *p, std::size_t nbytes, std::uint64_t seed)
+    {
+        const std::uint64_t m(0x9E3779B97F4A7C15ULL);
+        std::uint64_t h(seed ^ (nbytes * m));
+        std::size_t i(0);
+        for( ; i + 8 <= nbytes; i += 8) {
+          std::uint64_t w;
+          std::memcpy(&w, p + i, 8);
+          w *= m;
+          w ^= w >> 29;
+          h = (h ^ w) * 0xBF58476D1CE4E5B9ULL;
+          h ^= h >> 31;
+        }
+        if(i < nbytes) {
+          std::uint64_t w(0);
+          std::memcpy(&w, p + i, nbytes - i);
+          h = (h ^ (w * m)) * 0xBF58476D1CE4E5B9ULL;
+        }
+        h ^= h >> 30;
+        h *= 0x94D049BB133111EBULL;
+        h ^= h >> 31;
+        return h;
+    }
+
+    //
+    // The directories of path, with "." and ".." resolved where possible.
+    // A relative path is taken from the current directory if that is known.
+    //
+    std::vector<std::string>
+    PathComponents (const std::string &path)
+    {
+        std::string full(path);
+#ifdef BL_VISMF_POSIX
+        if( ! full.empty() && full[0] != '/') {
+          std::vector<char> cwd(4096);
+          if(getcwd(cwd.data(), cwd.size()) != nullptr) {
+            full = std::string(cwd.data()) + '/' + full;
+          }
+        }
+#endif
+        std::vector<std::string> comps;
+        std::string::size_type pos(0);
+        while(pos <= full.size()) {
+          std::string::size_type next(full.find('/', pos));
+          if(next == std::string::npos) {
+            next = full.size();
+          }
+          const std::string comp(full.substr(pos, next - pos));
+          if(comp == ".." && ! comps.empty() && comps.back() != "..") {
+            comps.pop_back();
+          } else if( ! comp.empty() && comp != ".") {
+            comps.push_back(comp);
+          }
+          pos = next + 1;
+        }
+        return comps;
+    }
+
+    //
+    // The path of the file to from the directory from.
+    //
+    std::string
+    RelativePath (const std::string &from, const std::string &to)
+    {
+        const std::vector<std::string> f(PathComponents(from));
+        const std::vector<std::string> t(PathComponents(to));
+        std::size_t n(0);
+        while(n < f.size() && n + 1 < t.size() && f[n] == t[n] && f[n] != "..") {
+          ++n;
+        }
+        std::string rel;
+        for(std::size_t i(n); i < f.size(); ++i) {
+          rel += "../";
+        }
+        for(std::size_t i(n); i < t.size(); ++i) {
+          rel += t[i];
+          if(i + 1 < t.size()) {
+            rel += '/';
+          }
+        }
+        return rel;
+    }
 }
 
 void
@@ -79,10 +601,18 @@ VisMF::Initialize ()
     pp.query("checkfilepositions", checkFilePositions);
     pp.query("usepersistentifstreams", usePersistentIFStreams);
     pp.query("usesynchronousreads", useSynchronousReads);
+    pp.query("usemmap", useMMap);
     pp.query("usedynamicsetselection", useDynamicSetSelection);
     pp.query("iobuffersize", ioBufferSize);
     pp.query("allowsparsewrites", allowSparseWrites);
 
+    Real ctol(compressionTol);
+    pp.query("compression_tol", ctol);
+    VisMF::SetCompressionTol(ctol);
+    long cbs(compressionBlockSize);
+    pp.query("compression_block_size", cbs);
+    VisMF::SetCompressionBlockSize(cbs);
+
     initialized = true;
 }
 
@@ -281,8 +811,9 @@ operator<< (std::ostream        &os,
 
     os << hd.m_fod      << '\n';
 
-    if(hd.m_vers == VisMF::Header::Version_v1 ||
-       hd.m_vers == VisMF::Header::NoFabHeaderMinMax_v1)
+    if(hd.m_vers == VisMF::Header::Version_v1           ||
+       hd.m_vers == VisMF::Header::NoFabHeaderMinMax_v1 ||
+       hd.m_vers == VisMF::Header::Compressed_v1)
     {
       os << hd.m_min      << '\n';
       os << hd.m_max      << '\n';
@@ -305,7 +836,9 @@ operator<< (std::ostream        &os,
        hd.m_vers == VisMF::Header::NoFabHeaderMinMax_v1 ||
        hd.m_vers == VisMF::Header::NoFabHeaderFAMinMax_v1)
     {
-      if(FArrayBox::getFormat() == FABio::FAB_NATIVE) {
+      if( ! hd.m_writtenRD.formatarray().empty()) {
+        os << hd.m_writtenRD << '\n';
+      } else if(FArrayBox::getFormat() == FABio::FAB_NATIVE) {
         os << FPC::NativeRealDescriptor() << '\n';
       } else if(FArrayBox::getFormat() == FABio::FAB_NATIVE_32) {
         os << FPC::Native32RealDescriptor() << '\n';
@@ -314,6 +847,27 @@ operator<< (std::ostream        &os,
       }
     }
 
+    if(hd.m_vers == VisMF::Header::Compressed_v1) {
+      BL_ASSERT(hd.m_csize.size() == hd.m_ba.size());
+      os << hd.m_writtenRD << '\n';
+      os << hd.m_cblock    << '\n';
+      for(int i(0); i < hd.m_csize.size(); ++i) {
+        os << hd.m_csize[i].size();
+        for(int j(0); j < hd.m_csize[i].size(); ++j) {
+          os << ' ' << hd.m_csize[i][j];
+        }
+        os << '\n';
+      }
+    }
+
+    if( ! hd.m_hash.empty()) {
+      BL_ASSERT(hd.m_hash.size() == hd.m_ba.size());
+      os << "Hash: " << hd.m_hash.size() << '\n';
+      for(int i(0); i < hd.m_hash.size(); ++i) {
+        os << hd.m_hash[i] << '\n';
+      }
+    }
+
     os.flags(oflags);
     os.precision(oldPrec);
 
@@ -362,8 +916,9 @@ operator>> (std::istream  &is,
     is >> hd.m_fod;
     BL_ASSERT(hd.m_ba.size() == hd.m_fod.size());
 
-    if(hd.m_vers == VisMF::Header::Version_v1 ||
-       hd.m_vers == VisMF::Header::NoFabHeaderMinMax_v1)
+    if(hd.m_vers == VisMF::Header::Version_v1           ||
+       hd.m_vers == VisMF::Header::NoFabHeaderMinMax_v1 ||
+       hd.m_vers == VisMF::Header::Compressed_v1)
     {
       is >> hd.m_min;
       is >> hd.m_max;
@@ -395,8 +950,37 @@ operator>> (std::istream  &is,
       is >> hd.m_writtenRD;
     }
 
+    if(hd.m_vers == VisMF::Header::Compressed_v1) {
+      is >> hd.m_writtenRD;
+      is >> hd.m_cblock;
+      BL_ASSERT(hd.m_cblock > 0);
+      hd.m_csize.resize(hd.m_ba.size());
+      for(int i(0); i < hd.m_csize.size(); ++i) {
+        long nBlocks;
+        is >> nBlocks;
+        hd.m_csize[i].resize(nBlocks);
+        for(long j(0); j < nBlocks; ++j) {
+          is >> hd.m_csize[i][j];
+        }
+      }
+    }
+
+    hd.m_hash.clear();
+    is >> std::ws;
+    if( ! is.eof() && is.peek() == 'H') {
+      std::string str;
+      long nHash;
+      is >> str >> nHash;
+      if(str != "Hash:" || nHash != hd.m_ba.size()) {
+        amrex::Error("Bad hashes in VisMF::Header");
+      }
+      hd.m_hash.resize(nHash);
+      for(long i(0); i < nHash; ++i) {
+        is >> hd.m_hash[i];
+      }
+    }
 
-    if( ! is.good()) {
+    if(is.fail()) {
         amrex::Error("Read of VisMF::Header failed");
     }
 
@@ -634,7 +1218,8 @@ VisMF::Write (const FArrayBox&   fab,
 
 VisMF::Header::Header ()
     :
-    m_vers(VisMF::Header::Undefined_v1)
+    m_vers(VisMF::Header::Undefined_v1),
+    m_cblock(0)
 {}
 
 //
@@ -651,7 +1236,8 @@ VisMF::Header::Header (const FabArray<FArrayBox>& mf,
     m_ncomp(mf.nComp()),
     m_ngrow(mf.nGrow()),
     m_ba(mf.boxArray()),
-    m_fod(m_ba.size())
+    m_fod(m_ba.size()),
+    m_cblock(0)
 {
     BL_PROFILE("VisMF::Header");
 
@@ -719,7 +1305,7 @@ VisMF::Header::CalculateMinMax (const FabArray<FArrayBox>& mf,
     Vector<int> nmtags(ParallelDescriptor::NProcs(), 0);
     Vector<int> offset(ParallelDescriptor::NProcs(), 0);
 
-    const Vector<int> &pmap = mf.DistributionMap().ProcessorMap();
+    const auto& pmap = mf.DistributionMap().ProcessorMap();
 
     for(int i(0), N = mf.size(); i < N; ++i) {
         ++nmtags[pmap[i]];
@@ -910,6 +1496,16 @@ VisMF::Write (const FabArray<FArrayBox>&    mf,
     BL_ASSERT(mf_name[mf_name.length() - 1] != '/');
     BL_ASSERT(currentVersion != VisMF::Header::Undefined_v1);
 
+    if( ! deltaDir.empty() && mf_name.compare(0, deltaDir.size(), deltaDir) == 0) {
+      const std::string base_name(deltaBaseDir.empty() ? deltaBaseDir
+                                  : deltaBaseDir + mf_name.substr(deltaDir.size()));
+      return VisMF::WriteDelta(mf, mf_name, base_name, how, set_ghost);
+    }
+
+    if(currentVersion == VisMF::Header::Compressed_v1) {
+      return VisMF::WriteCompressed(mf, mf_name, set_ghost, false);
+    }
+
     // ---- add stream retry
     // ---- add stream buffer (to nfiles)
     RealDescriptor *whichRD;
@@ -923,24 +1519,12 @@ VisMF::Write (const FabArray<FArrayBox>&    mf,
     bool doConvert(*whichRD != FPC::NativeRealDescriptor());
 
     if(set_ghost) {
-        FabArray<FArrayBox>* the_mf = const_cast<FabArray<FArrayBox>*>(&mf);
-
-        for(MFIter mfi(*the_mf); mfi.isValid(); ++mfi) {
-            const int idx(mfi.index());
-
-            for(int j(0); j < mf.nComp(); ++j) {
-                const Real valMin(mf[mfi].min(mf.box(idx), j));
-                const Real valMax(mf[mfi].max(mf.box(idx), j));
-                const Real val((valMin + valMax) / 2.0);
-
-                the_mf->get(mfi).setComplement(val, mf.box(idx), j, 1);
-            }
-        }
+        SetGhostToMidRange(mf);
     }
 
     // ---- check if mf has sparse data
     bool useSparseFPP(false);
-    const Vector<int> &pmap = mf.DistributionMap().ProcessorMap();
+    const auto& pmap = mf.DistributionMap().ProcessorMap();
     std::set<int> procsWithData;
     Vector<int> procsWithDataVector;
     for(int i(0); i < pmap.size(); ++i) {
@@ -1073,73 +1657,740 @@ VisMF::Write (const FabArray<FArrayBox>&    mf,
 }
 
 
-void
-VisMF::FindOffsets (const FabArray<FArrayBox> &mf,
-		    const std::string &filePrefix,
-                    VisMF::Header &hdr,
-		    bool groupSets,
-		    VisMF::Header::Version whichVersion,
-		    NFilesIter &nfi)
+long
+VisMF::AsyncWrite (const FabArray<FArrayBox>& mf,
+                   const std::string&         mf_name,
+                   bool                       set_ghost)
 {
-    BL_PROFILE("VisMF::FindOffsets");
+    BL_PROFILE("VisMF::AsyncWrite(FabArray)");
+    BL_ASSERT(mf_name[mf_name.length() - 1] != '/');
+    BL_ASSERT(currentVersion != VisMF::Header::Undefined_v1);
 
-    const int myProc(ParallelDescriptor::MyProc());
-    const int nProcs(ParallelDescriptor::NProcs());
-    int coordinatorProc(ParallelDescriptor::IOProcessorNumber());
-    if(nfi.GetDynamic()) {
-      coordinatorProc = nfi.CoordinatorProc();
+    if( ! deltaDir.empty() && mf_name.compare(0, deltaDir.size(), deltaDir) == 0) {
+      const std::string base_name(deltaBaseDir.empty() ? deltaBaseDir
+                                  : deltaBaseDir + mf_name.substr(deltaDir.size()));
+      return VisMF::WriteDelta(mf, mf_name, base_name, NFiles, set_ghost);
     }
 
-    if(FArrayBox::getFormat() == FABio::FAB_ASCII ||
-       FArrayBox::getFormat() == FABio::FAB_8BIT)
-    {
-
-#ifdef BL_USE_MPI
-    Vector<int> nmtags(nProcs,0);
-    Vector<int> offset(nProcs,0);
+    if(currentVersion == VisMF::Header::Compressed_v1) {
+      return VisMF::WriteCompressed(mf, mf_name, set_ghost, true);
+    }
 
-    const Vector<int> &pmap = mf.DistributionMap().ProcessorMap();
+    std::unique_ptr<RealDescriptor> whichRD;
+    if(FArrayBox::getFormat() == FABio::FAB_NATIVE) {
+      whichRD.reset(FPC::NativeRealDescriptor().clone());
+    } else if(FArrayBox::getFormat() == FABio::FAB_NATIVE_32) {
+      whichRD.reset(FPC::Native32RealDescriptor().clone());
+    } else if(FArrayBox::getFormat() == FABio::FAB_IEEE_32) {
+      whichRD.reset(FPC::Ieee32NormalRealDescriptor().clone());
+    } else {
+      return VisMF::Write(mf, mf_name, NFiles, set_ghost);
+    }
+    const bool doConvert(*whichRD != FPC::NativeRealDescriptor());
+    const bool oldHeader(currentVersion == VisMF::Header::Version_v1);
+    const FABio &fio = FArrayBox::getFABio();
+    const int whichRDBytes(whichRD->numBytes());
+    const int nComps(mf.nComp());
 
-    for(int i(0), N(mf.size()); i < N; ++i) {
-        ++nmtags[pmap[i]];
+    if(set_ghost) {
+        SetGhostToMidRange(mf);
     }
 
-    for(int i(1), N(offset.size()); i < N; ++i) {
-        offset[i] = offset[i-1] + nmtags[i-1];
+    //
+    // Stage the fabs of this process in the order and format of the file.
+    //
+    const Vector<int> &index = mf.IndexArray();
+    const int nFABs(index.size());
+    Vector<std::string> fabHeaders(nFABs);
+    Vector<long> position(nFABs+1, 0L);
+    for(int k(0); k < nFABs; ++k) {
+      const FArrayBox &fab = mf[index[k]];
+      if(oldHeader) {
+        std::stringstream hss;
+        fio.write_header(hss, fab, fab.nComp());
+        fabHeaders[k] = hss.str();
+      }
+      position[k+1] = position[k] + fabHeaders[k].size()
+                    + fab.box().numPts() * nComps * whichRDBytes;
     }
+    const long nBytes(position[nFABs]);
 
-    Vector<long> senddata(nmtags[myProc]);
+    AsyncOut::Reserve(nBytes);
 
-    if(senddata.empty()) {
-      // Can't let senddata be empty as senddata.dataPtr() will fail.
-      senddata.resize(1);
-    }
+    std::shared_ptr<char> stage(new char[std::max(nBytes, 1L)], std::default_delete<char[]>());
+    char *allFabData = stage.get();
 
-    int ioffset(0);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(int k = 0; k < nFABs; ++k) {
+      const FArrayBox &fab = mf[index[k]];
+      const long writeDataItems(fab.box().numPts() * nComps);
+      char *afPtr = allFabData + position[k];
+      const int hLength(fabHeaders[k].size());
+      memcpy(afPtr, fabHeaders[k].data(), hLength);
+      if(doConvert) {
+        RealDescriptor::convertFromNativeFormat(static_cast<void *> (afPtr + hLength),
+                                                writeDataItems,
+                                                fab.dataPtr(), *whichRD);
+      } else {
+        memcpy(afPtr + hLength, fab.dataPtr(), writeDataItems * whichRDBytes);
+      }
+    }
 
-    for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
-      senddata[ioffset++] = hdr.m_fod[mfi.index()].m_head;
+    //
+    // The sizes of the data of all the processes follow from the
+    // BoxArray, so every process knows where to write without waiting.
+    //
+    const std::string filePrefix(mf_name + FabFileSuffix);
+    const int myProc(ParallelDescriptor::MyProc());
+    const int ioProc(ParallelDescriptor::IOProcessorNumber());
+    const DistributionMapping &dm = mf.DistributionMap();
+
+    Vector<long> fabBytes(mf.size()), rankBytes(ParallelDescriptor::NProcs(), 0L);
+    for(int i(0); i < mf.size(); ++i) {
+      long hLength(0);
+      if(oldHeader) {
+        std::stringstream hss;
+        FArrayBox tempFab(mf.fabbox(i), nComps, false);  // ---- no alloc
+        fio.write_header(hss, tempFab, tempFab.nComp());
+        hLength = hss.tellp();
+      }
+      fabBytes[i] = hLength + mf.fabbox(i).numPts() * nComps * whichRDBytes;
+      rankBytes[dm[i]] += fabBytes[i];
     }
+    BL_ASSERT(rankBytes[myProc] == nBytes);
 
-    BL_ASSERT(ioffset == nmtags[myProc]);
+    Vector<int> fileNumber;
+    Vector<long> rankOffset, fileSize;
+    AsyncFileLayout(rankBytes, nOutFiles, groupSets, fileNumber, rankOffset, fileSize);
 
-    Vector<long> recvdata(mf.size());
+    VisMF::Header hdr(mf, NFiles, currentVersion, false);
 
-    BL_COMM_PROFILE(BLProfiler::Gatherv, recvdata.size() * sizeof(long),
-                    myProc, BLProfiler::BeforeCall());
+    if(currentVersion == VisMF::Header::Version_v1 ||
+       currentVersion == VisMF::Header::NoFabHeaderMinMax_v1)
+    {
+      hdr.CalculateMinMax(mf, ioProc);
+    }
 
-    BL_MPI_REQUIRE( MPI_Gatherv(senddata.dataPtr(),
-                                nmtags[myProc],
-                                ParallelDescriptor::Mpi_typemap<long>::type(),
-                                recvdata.dataPtr(),
-                                nmtags.dataPtr(),
-                                offset.dataPtr(),
-                                ParallelDescriptor::Mpi_typemap<long>::type(),
-                                coordinatorProc,
-                                ParallelDescriptor::Communicator()) );
+    if(myProc == ioProc) {
+      Vector<long> currentOffset(rankOffset);
+      for(int i(0); i < mf.size(); ++i) {
+        const int rank(dm[i]);
+        hdr.m_fod[i].m_name = VisMF::BaseName(NFilesIter::FileName(fileNumber[rank], filePrefix));
+        hdr.m_fod[i].m_head = currentOffset[rank];
+        currentOffset[rank] += fabBytes[i];
+      }
+    }
 
-    BL_COMM_PROFILE(BLProfiler::Gatherv, recvdata.size() * sizeof(long),
-                    myProc, BLProfiler::AfterCall());
+    long bytesWritten = nBytes + VisMF::WriteHeader(mf_name, hdr, ioProc);
+
+    if(nFABs > 0) {
+      SubmitAsyncWrite(stage, nBytes, nBytes,
+                       NFilesIter::FileName(fileNumber[myProc], filePrefix),
+                       rankOffset[myProc], fileSize[fileNumber[myProc]]);
+    }
+
+    return bytesWritten;
+}
+
+
+long
+VisMF::WriteCompressed (const FabArray<FArrayBox> &mf,
+                        const std::string         &mf_name,
+                        bool                       set_ghost,
+                        bool                       async)
+{
+    BL_PROFILE("VisMF::WriteCompressed");
+
+    //
+    // The ASCII and 8BIT formats are written as NATIVE.
+    //
+    std::unique_ptr<RealDescriptor> whichRD;
+    if(FArrayBox::getFormat() == FABio::FAB_NATIVE_32) {
+      whichRD.reset(FPC::Native32RealDescriptor().clone());
+    } else if(FArrayBox::getFormat() == FABio::FAB_IEEE_32) {
+      whichRD.reset(FPC::Ieee32NormalRealDescriptor().clone());
+    } else {
+      whichRD.reset(FPC::NativeRealDescriptor().clone());
+    }
+    const bool doConvert(*whichRD != FPC::NativeRealDescriptor());
+    const int whichRDBytes(whichRD->numBytes());
+    const int nComps(mf.nComp());
+    const long cblock(std::max(1L, compressionBlockSize / whichRDBytes));
+    const Real tol(compressionTol);
+
+    if(set_ghost) {
+        SetGhostToMidRange(mf);
+    }
+
+    //
+    // The blocks of the fabs of this process, in the order of the file.
+    // Each is compressed into its own slot of the staging buffer.
+    //
+    struct Block
+    {
+        int  fab;
+        int  comp;
+        long first;
+        long nValues;
+        long slot;
+    };
+
+    const Vector<int> &index = mf.IndexArray();
+    const int nFABs(index.size());
+    Vector<Block> blocks;
+    long capacity(0);
+    for(int k(0); k < nFABs; ++k) {
+      const long npts(mf[index[k]].box().numPts());
+      const long nBlocks(NCompressedBlocks(npts, cblock));
+      for(int n(0); n < nComps; ++n) {
+        for(long b(0); b < nBlocks; ++b) {
+          const long nValues(std::min(cblock, npts - b*cblock));
+          blocks.push_back(Block{k, n, b*cblock, nValues, capacity});
+          capacity += Compression::Capacity(nValues * whichRDBytes);
+        }
+      }
+    }
+    const int nBlocksTotal(blocks.size());
+
+    if(async) {
+      AsyncOut::Reserve(capacity);
+    }
+
+    std::shared_ptr<char> stage(new char[std::max(capacity, 1L)], std::default_delete<char[]>());
+    Vector<long> csize(nBlocksTotal);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+      Vector<Real> quantized;
+      Vector<char> converted;
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+      for(int i = 0; i < nBlocksTotal; ++i) {
+        const Block &blk = blocks[i];
+        const Real *src = mf[index[blk.fab]].dataPtr(blk.comp) + blk.first;
+        if(tol > 0.0) {
+          quantized.assign(src, src + blk.nValues);
+          Compression::Quantize(quantized.dataPtr(), blk.nValues, tol);
+          src = quantized.dataPtr();
+        }
+        const char *data = reinterpret_cast<const char *>(src);
+        if(doConvert) {
+          converted.resize(blk.nValues * whichRDBytes);
+          RealDescriptor::convertFromNativeFormat(static_cast<void *> (converted.dataPtr()),
+                                                  blk.nValues, src, *whichRD);
+          data = converted.dataPtr();
+        }
+        csize[i] = Compression::Compress(data, blk.nValues * whichRDBytes,
+                                         stage.get() + blk.slot);
+      }
+    }
+
+    //
+    // Pack the compressed blocks.
+    //
+    long nBytes(0);
+    for(int i(0); i < nBlocksTotal; ++i) {
+      memmove(stage.get() + nBytes, stage.get() + blocks[i].slot, csize[i]);
+      nBytes += csize[i];
+    }
+
+    const std::string filePrefix(mf_name + FabFileSuffix);
+    const int myProc(ParallelDescriptor::MyProc());
+    const int nProcs(ParallelDescriptor::NProcs());
+    int coordinatorProc(ParallelDescriptor::IOProcessorNumber());
+
+    //
+    // Where the data of this process start: [file number, offset].
+    //
+    Vector<long> sendData(2 + nBlocksTotal);
+    sendData[0] = myProc;
+    sendData[1] = 0;
+    std::copy(csize.begin(), csize.end(), sendData.begin() + 2);
+
+    if(async) {
+      //
+      // The compressed sizes are only known now, so the processes tell
+      // each other theirs to find where to write.
+      //
+      Vector<long> rankBytes(nProcs, nBytes);
+#ifdef BL_USE_MPI
+      BL_MPI_REQUIRE( MPI_Allgather(&nBytes, 1, MPI_LONG, rankBytes.dataPtr(), 1, MPI_LONG,
+                                    ParallelDescriptor::Communicator()) );
+#endif
+      Vector<int> fileNumber;
+      Vector<long> rankOffset, fileSize;
+      AsyncFileLayout(rankBytes, nOutFiles, groupSets, fileNumber, rankOffset, fileSize);
+      sendData[0] = fileNumber[myProc];
+      sendData[1] = rankOffset[myProc];
+      if(nFABs > 0) {
+        SubmitAsyncWrite(stage, nBytes, capacity,
+                         NFilesIter::FileName(fileNumber[myProc], filePrefix),
+                         rankOffset[myProc], fileSize[fileNumber[myProc]]);
+      }
+    } else {
+      const auto& pmap = mf.DistributionMap().ProcessorMap();
+      std::set<int> procsWithData(pmap.begin(), pmap.end());
+
+      NFilesIter nfi(nOutFiles, filePrefix, groupSets, setBuf);
+      if(allowSparseWrites && (static_cast<int>(procsWithData.size()) < nOutFiles)) {
+        nfi.SetSparseFPP(Vector<int>(procsWithData.begin(), procsWithData.end()));
+      } else if(useDynamicSetSelection) {
+        nfi.SetDynamic();
+      }
+      for( ; nfi.ReadyToWrite(); ++nfi) {
+        sendData[0] = nfi.FileNumber();
+        sendData[1] = VisMF::FileOffset(nfi.Stream());
+        nfi.Stream().write(stage.get(), nBytes);
+        nfi.Stream().flush();
+      }
+      if(nfi.GetDynamic()) {
+        coordinatorProc = nfi.CoordinatorProc();
+      }
+    }
+
+    VisMF::Header hdr(mf, NFiles, VisMF::Header::Compressed_v1, false);
+    hdr.CalculateMinMax(mf, coordinatorProc);
+    if(tol > 0.0) {
+      //
+      // Quantize keeps the order of the values, so the min and max of
+      // the data written are the quantized min and max.
+      //
+      for(int i(0); i < hdr.m_min.size(); ++i) {
+        Compression::Quantize(hdr.m_min[i].dataPtr(), hdr.m_min[i].size(), tol);
+        Compression::Quantize(hdr.m_max[i].dataPtr(), hdr.m_max[i].size(), tol);
+      }
+    }
+    hdr.m_writtenRD = *whichRD;
+    hdr.m_cblock    = cblock;
+
+    //
+    // Gather the file positions and block sizes.  How many each process
+    // sends follows from the BoxArray.
+    //
+    const DistributionMapping &dm = mf.DistributionMap();
+    Vector<long> nFabBlocks(mf.size());
+    std::vector<long> recvCount(nProcs, 2L), recvDisp(nProcs, 0L);
+    for(int i(0); i < mf.size(); ++i) {
+      nFabBlocks[i] = NCompressedBlocks(mf.fabbox(i).numPts(), cblock) * nComps;
+      recvCount[dm[i]] += nFabBlocks[i];
+    }
+    for(int i(1); i < nProcs; ++i) {
+      recvDisp[i] = recvDisp[i-1] + recvCount[i-1];
+    }
+    BL_ASSERT(recvCount[myProc] == sendData.size());
+
+    Vector<long> recvData;
+    if(myProc == coordinatorProc) {
+      recvData.resize(recvDisp[nProcs-1] + recvCount[nProcs-1]);
+    }
+#ifdef BL_USE_MPI
+    ParallelDescriptor::Gatherv(sendData.dataPtr(), long(sendData.size()),
+                                recvData.dataPtr(), recvCount, recvDisp, coordinatorProc);
+#else
+    recvData = sendData;
+#endif
+
+    if(myProc == coordinatorProc) {
+      Vector<long> pos(recvDisp.begin(), recvDisp.end());
+      Vector<long> currentOffset(nProcs, 0L);
+      for(int rank(0); rank < nProcs; ++rank) {
+        currentOffset[rank] = recvData[pos[rank] + 1];
+        pos[rank] += 2;
+      }
+      hdr.m_csize.resize(mf.size());
+      for(int i(0); i < mf.size(); ++i) {
+        const int rank(dm[i]);
+        const long fileNumber(recvData[recvDisp[rank]]);
+        hdr.m_fod[i].m_name = VisMF::BaseName(NFilesIter::FileName(fileNumber, filePrefix));
+        hdr.m_fod[i].m_head = currentOffset[rank];
+        hdr.m_csize[i].assign(recvData.begin() + pos[rank],
+                              recvData.begin() + pos[rank] + nFabBlocks[i]);
+        for(long b(0); b < nFabBlocks[i]; ++b) {
+          currentOffset[rank] += hdr.m_csize[i][b];
+        }
+        pos[rank] += nFabBlocks[i];
+      }
+    }
+
+    return nBytes + VisMF::WriteHeader(mf_name, hdr, coordinatorProc);
+}
+
+
+void
+VisMF::SetDeltaBase (const std::string &dir,
+                     const std::string &base_dir)
+{
+    deltaDir     = dir;
+    deltaBaseDir = base_dir;
+    if( ! deltaDir.empty() && deltaDir[deltaDir.length() - 1] != '/') {
+      deltaDir += '/';
+    }
+    if( ! deltaBaseDir.empty() && deltaBaseDir[deltaBaseDir.length() - 1] != '/') {
+      deltaBaseDir += '/';
+    }
+}
+
+
+long
+VisMF::WriteDelta (const FabArray<FArrayBox> &mf,
+                   const std::string         &mf_name,
+                   const std::string         &base_name,
+                   VisMF::How                 how,
+                   bool                       set_ghost)
+{
+    BL_PROFILE("VisMF::WriteDelta");
+    BL_ASSERT(mf_name[mf_name.length() - 1] != '/');
+    BL_ASSERT(currentVersion != VisMF::Header::Undefined_v1);
+
+    const int myProc(ParallelDescriptor::MyProc());
+    const int ioProc(ParallelDescriptor::IOProcessorNumber());
+    const int nFabs(mf.size());
+
+    if(set_ghost) {
+        SetGhostToMidRange(mf);
+    }
+
+    //
+    // The hashes are seeded with what decides the bytes on disk, so that
+    // writing in another format counts as a change of every fab.
+    //
+    std::uint64_t key[4] = { std::uint64_t(currentVersion),
+                             std::uint64_t(FArrayBox::getFormat()), 0, 0 };
+    if(currentVersion == VisMF::Header::Compressed_v1) {
+      key[2] = compressionBlockSize;
+      std::memcpy(&key[3], &compressionTol, sizeof(Real));
+    }
+    const std::uint64_t seed(HashBytes(reinterpret_cast<const char *>(key), sizeof(key), 0));
+
+    const Vector<int> &index = mf.IndexArray();
+    const int nLocal(index.size());
+    Vector<long> hash(nFabs, 0L);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for(int k = 0; k < nLocal; ++k) {
+      const FArrayBox &fab = mf[index[k]];
+      hash[index[k]] = static_cast<long>(HashBytes(reinterpret_cast<const char *>(fab.dataPtr()),
+                                                   fab.nBytes(), seed));
+    }
+    ParallelDescriptor::ReduceLongSum(hash.dataPtr(), nFabs);
+
+    VisMF::Header baseHdr;
+    bool haveBase(false);
+    if( ! base_name.empty() && VisMF::Exist(base_name)) {
+      Vector<char> fileCharPtr;
+      ParallelDescriptor::ReadAndBcastFile(base_name + TheMultiFabHdrFileSuffix, fileCharPtr);
+      std::istringstream infs(std::string(fileCharPtr.dataPtr()), std::istringstream::in);
+      infs >> baseHdr;
+      haveBase = baseHdr.m_vers  == currentVersion   &&
+                 baseHdr.m_ncomp == mf.nComp()      &&
+                 baseHdr.m_ngrow == mf.nGrowVect()  &&
+                 baseHdr.m_ba    == mf.boxArray()   &&
+                 baseHdr.m_hash.size() == nFabs;
+    }
+
+    Vector<int> changed;
+    for(int i(0); i < nFabs; ++i) {
+      if( ! haveBase || baseHdr.m_hash[i] != static_cast<std::uint64_t>(hash[i])) {
+        changed.push_back(i);
+      }
+    }
+    const int nChanged(changed.size());
+
+    if(verbose && ParallelDescriptor::IOProcessor()) {
+      amrex::Print() << "VisMF::WriteDelta:  " << mf_name << ":  writing " << nChanged
+                     << " of " << nFabs << " fabs" << '\n';
+    }
+
+    //
+    // Write the changed fabs with the usual Write, aliasing their data.
+    //
+    long bytesWritten(0);
+    if(nChanged > 0) {
+      BoxList bl(mf.boxArray().ixType());
+      Vector<int> pmap(nChanged);
+      Vector<Real *> pval;
+      for(int j(0); j < nChanged; ++j) {
+        bl.push_back(mf.boxArray()[changed[j]]);
+        pmap[j] = mf.DistributionMap()[changed[j]];
+        if(pmap[j] == myProc) {
+          pval.push_back(const_cast<Real *>(mf[changed[j]].dataPtr()));
+        }
+      }
+      const BoxArray ba(std::move(bl));
+      const DistributionMapping dm(std::move(pmap));
+      const FabArray<FArrayBox> sub(ba, dm, mf.nComp(), mf.nGrowVect(), pval);
+
+      const std::string saveDeltaDir(deltaDir);
+      deltaDir.clear();
+      bytesWritten += VisMF::Write(sub, mf_name, how);
+      deltaDir = saveDeltaDir;
+    }
+
+    VisMF::Header hdr(mf, how, currentVersion, false);
+
+    if(currentVersion == VisMF::Header::Version_v1           ||
+       currentVersion == VisMF::Header::NoFabHeaderMinMax_v1 ||
+       currentVersion == VisMF::Header::Compressed_v1)
+    {
+      hdr.CalculateMinMax(mf, ioProc);
+    }
+
+    ParallelDescriptor::Barrier("VisMF::WriteDelta");
+
+    //
+    // Merge the header of the changed fabs with that of the base.  The
+    // names of the files of the base are made relative to this directory.
+    //
+    if(myProc == ioProc) {
+      VisMF::Header subHdr;
+      if(nChanged > 0) {
+        const std::string subHdrName(mf_name + TheMultiFabHdrFileSuffix);
+        std::ifstream ifs(subHdrName.c_str(), std::ios::in);
+        if( ! ifs.good()) {
+          amrex::FileOpenFailed(subHdrName);
+        }
+        ifs >> subHdr;
+      }
+      const VisMF::Header &rdHdr = (nChanged > 0) ? subHdr : baseHdr;
+      hdr.m_writtenRD = rdHdr.m_writtenRD;
+      hdr.m_cblock    = rdHdr.m_cblock;
+      if(currentVersion == VisMF::Header::Compressed_v1) {
+        hdr.m_csize.resize(nFabs);
+      }
+
+      const std::string dirName(VisMF::DirName(mf_name));
+      const std::string baseDirName(VisMF::DirName(base_name));
+      for(int i(0), j(0); i < nFabs; ++i) {
+        if(j < nChanged && changed[j] == i) {
+          hdr.m_fod[i] = subHdr.m_fod[j];
+          if(currentVersion == VisMF::Header::Compressed_v1) {
+            hdr.m_csize[i] = subHdr.m_csize[j];
+          }
+          ++j;
+        } else {
+          hdr.m_fod[i].m_name = RelativePath(dirName, baseDirName + baseHdr.m_fod[i].m_name);
+          hdr.m_fod[i].m_head = baseHdr.m_fod[i].m_head;
+          if(currentVersion == VisMF::Header::Compressed_v1) {
+            hdr.m_csize[i] = baseHdr.m_csize[i];
+          }
+        }
+      }
+
+      hdr.m_hash.resize(nFabs);
+      for(int i(0); i < nFabs; ++i) {
+        hdr.m_hash[i] = static_cast<std::uint64_t>(hash[i]);
+      }
+    }
+
+    return bytesWritten + VisMF::WriteHeader(mf_name, hdr, ioProc);
+}
+
+
+long
+VisMF::Fold (const std::string &mf_name)
+{
+    BL_PROFILE("VisMF::Fold");
+
+    const int myProc(ParallelDescriptor::MyProc());
+    const int nProcs(ParallelDescriptor::NProcs());
+    const int ioProc(ParallelDescriptor::IOProcessorNumber());
+
+    VisMF::Header hdr;
+    {
+      Vector<char> fileCharPtr;
+      ParallelDescriptor::ReadAndBcastFile(mf_name + TheMultiFabHdrFileSuffix, fileCharPtr);
+      std::istringstream infs(std::string(fileCharPtr.dataPtr()), std::istringstream::in);
+      infs >> hdr;
+    }
+
+    //
+    // The fabs in the files of other FabArrays are copied by the
+    // processes in turn, each to a file of its own.  Those files may be
+    // in the same directory, so they are told apart by their names.
+    //
+    const std::string dirName(VisMF::DirName(mf_name));
+    const std::string filePrefix(mf_name + FoldedFabFileSuffix);
+    const std::string ownData(VisMF::BaseName(mf_name) + FabFileSuffix);
+    const std::string ownFolded(VisMF::BaseName(filePrefix));
+    const std::string fileName(NFilesIter::FileName(myProc, filePrefix));
+    const int nFabs(hdr.m_fod.size());
+    Vector<long> newHead(nFabs, -1L);
+    Vector<int> whichProc(nFabs, -1);
+    std::ofstream ofs;
+    std::vector<char> buffer;
+    long bytesCopied(0);
+    int nFolded(0);
+
+    for(int i(0); i < nFabs; ++i) {
+      const std::string &fodName = hdr.m_fod[i].m_name;
+      if(fodName.compare(0, ownData.size(), ownData) == 0 ||
+         fodName.compare(0, ownFolded.size(), ownFolded) == 0)
+      {
+        continue;
+      }
+      whichProc[i] = nFolded++ % nProcs;
+      if(whichProc[i] != myProc) {
+        continue;
+      }
+
+      const std::string srcName(dirName + hdr.m_fod[i].m_name);
+      std::ifstream ifs(srcName.c_str(), std::ios::in | std::ios::binary);
+      if( ! ifs.good()) {
+        amrex::FileOpenFailed(srcName);
+      }
+      ifs.seekg(hdr.m_fod[i].m_head, std::ios::beg);
+
+      const Box fabBox(amrex::grow(hdr.m_ba[i], hdr.m_ngrow));
+      const long nValues(fabBox.numPts() * hdr.m_ncomp);
+      long nBytes(0);
+      if(hdr.m_vers == VisMF::Header::Version_v1) {
+        std::string line;
+        std::getline(ifs, line);
+        RealDescriptor rd;
+        if( ! ParseFabHeader(line, fabBox, hdr.m_ncomp, rd)) {
+          amrex::Abort("VisMF::Fold:  unsupported fab header in " + srcName);
+        }
+        nBytes = line.size() + 1 + nValues * rd.numBytes();
+        ifs.seekg(hdr.m_fod[i].m_head, std::ios::beg);
+      } else if(hdr.m_vers == VisMF::Header::Compressed_v1) {
+        for(int b(0); b < hdr.m_csize[i].size(); ++b) {
+          nBytes += hdr.m_csize[i][b];
+        }
+      } else {
+        nBytes = nValues * hdr.m_writtenRD.numBytes();
+      }
+
+      buffer.resize(nBytes);
+      ifs.read(buffer.data(), nBytes);
+      if( ! ifs.good()) {
+        amrex::Error("VisMF::Fold:  read failed:  " + srcName);
+      }
+
+      if( ! ofs.is_open()) {
+        ofs.open(fileName.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+        if( ! ofs.good()) {
+          amrex::FileOpenFailed(fileName);
+        }
+      }
+      newHead[i] = bytesCopied;
+      ofs.write(buffer.data(), nBytes);
+      bytesCopied += nBytes;
+    }
+
+    if(ofs.is_open()) {
+      ofs.close();
+      if( ! ofs.good()) {
+        amrex::Error("VisMF::Fold:  write failed:  " + fileName);
+      }
+    }
+
+    if(nFolded == 0) {
+      return 0;
+    }
+
+    ParallelDescriptor::ReduceLongMax(newHead.dataPtr(), nFabs, ioProc);
+
+    if(myProc == ioProc) {
+      for(int i(0); i < nFabs; ++i) {
+        if(whichProc[i] >= 0) {
+          hdr.m_fod[i].m_name = VisMF::BaseName(NFilesIter::FileName(whichProc[i], filePrefix));
+          hdr.m_fod[i].m_head = newHead[i];
+        }
+      }
+
+      //
+      // The headers without fab headers record the format in which the
+      // data were written as that of FArrayBox::getFormat().
+      //
+      const FABio::Format thePrevFormat(FArrayBox::getFormat());
+      if(hdr.m_writtenRD == FPC::Native32RealDescriptor()) {
+        FArrayBox::setFormat(FABio::FAB_NATIVE_32);
+      } else if(hdr.m_writtenRD == FPC::Ieee32NormalRealDescriptor()) {
+        FArrayBox::setFormat(FABio::FAB_IEEE_32);
+      } else {
+        FArrayBox::setFormat(FABio::FAB_NATIVE);
+      }
+      VisMF::WriteHeader(mf_name, hdr, ioProc);
+      FArrayBox::setFormat(thePrevFormat);
+    }
+
+    return bytesCopied;
+}
+
+
+void
+VisMF::FindOffsets (const FabArray<FArrayBox> &mf,
+		    const std::string &filePrefix,
+                    VisMF::Header &hdr,
+		    bool groupSets,
+		    VisMF::Header::Version whichVersion,
+		    NFilesIter &nfi)
+{
+    BL_PROFILE("VisMF::FindOffsets");
+
+    const int myProc(ParallelDescriptor::MyProc());
+    const int nProcs(ParallelDescriptor::NProcs());
+    int coordinatorProc(ParallelDescriptor::IOProcessorNumber());
+    if(nfi.GetDynamic()) {
+      coordinatorProc = nfi.CoordinatorProc();
+    }
+
+    if(FArrayBox::getFormat() == FABio::FAB_ASCII ||
+       FArrayBox::getFormat() == FABio::FAB_8BIT)
+    {
+
+#ifdef BL_USE_MPI
+    Vector<int> nmtags(nProcs,0);
+    Vector<int> offset(nProcs,0);
+
+    const auto& pmap = mf.DistributionMap().ProcessorMap();
+
+    for(int i(0), N(mf.size()); i < N; ++i) {
+        ++nmtags[pmap[i]];
+    }
+
+    for(int i(1), N(offset.size()); i < N; ++i) {
+        offset[i] = offset[i-1] + nmtags[i-1];
+    }
+
+    Vector<long> senddata(nmtags[myProc]);
+
+    if(senddata.empty()) {
+      // Can't let senddata be empty as senddata.dataPtr() will fail.
+      senddata.resize(1);
+    }
+
+    int ioffset(0);
+
+    for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+      senddata[ioffset++] = hdr.m_fod[mfi.index()].m_head;
+    }
+
+    BL_ASSERT(ioffset == nmtags[myProc]);
+
+    Vector<long> recvdata(mf.size());
+
+    BL_COMM_PROFILE(BLProfiler::Gatherv, recvdata.size() * sizeof(long),
+                    myProc, BLProfiler::BeforeCall());
+
+    BL_MPI_REQUIRE( MPI_Gatherv(senddata.dataPtr(),
+                                nmtags[myProc],
+                                ParallelDescriptor::Mpi_typemap<long>::type(),
+                                recvdata.dataPtr(),
+                                nmtags.dataPtr(),
+                                offset.dataPtr(),
+                                ParallelDescriptor::Mpi_typemap<long>::type(),
+                                coordinatorProc,
+                                ParallelDescriptor::Communicator()) );
+
+    BL_COMM_PROFILE(BLProfiler::Gatherv, recvdata.size() * sizeof(long),
+                    myProc, BLProfiler::AfterCall());
 
     if(myProc == coordinatorProc) {
         Vector<int> cnt(nProcs,0);
@@ -1268,6 +2519,11 @@ VisMF::RemoveFiles(const std::string &mf_name, bool verbose)
           }
 	}
       }
+      // ---- the files written by Fold, if any
+      for(int ip(0); ip < ParallelDescriptor::NProcs(); ++ip) {
+        std::string fileName(NFilesIter::FileName(ip, mf_name + FoldedFabFileSuffix));
+        std::remove(fileName.c_str());
+      }
     }
 }
 
@@ -1311,6 +2567,14 @@ VisMF::readFAB (int                  idx,
 		int                  whichComp)
 {
     BL_PROFILE("VisMF::readFAB_idx");
+
+    if(useMMap) {
+      FArrayBox *fab = VisMF::mapFAB(idx, mf_name, hdr, whichComp);
+      if(fab != nullptr) {
+        return fab;
+      }
+    }
+
     Box fab_box(hdr.m_ba[idx]);
     if(hdr.m_ngrow.max() > 0) {
         fab_box.grow(hdr.m_ngrow);
@@ -1324,7 +2588,13 @@ VisMF::readFAB (int                  idx,
     std::ifstream *infs = VisMF::OpenStream(FullName);
     infs->seekg(hdr.m_fod[idx].m_head, std::ios::beg);
 
-    if(hdr.m_vers == Header::Version_v1) {
+    if(hdr.m_vers == Header::Compressed_v1) {
+      if(whichComp == -1) {    // ---- read all components
+        ReadCompressed(*infs, hdr, idx, 0, hdr.m_ncomp, *fab);
+      } else {
+        ReadCompressed(*infs, hdr, idx, whichComp, 1, *fab);
+      }
+    } else if(hdr.m_vers == Header::Version_v1) {
       if(whichComp == -1) {    // ---- read all components
         fab->readFrom(*infs);
       } else {
@@ -1359,6 +2629,79 @@ VisMF::readFAB (int                  idx,
 }
 
 
+FArrayBox*
+VisMF::mapFAB (int                  idx,
+               const std::string   &mf_name,
+               const VisMF::Header &hdr,
+               int                  whichComp)
+{
+    BL_PROFILE("VisMF::mapFAB");
+
+    if(hdr.m_vers == Header::Compressed_v1) {
+      return nullptr;
+    }
+    if(hdr.m_vers != Header::Version_v1 &&
+       hdr.m_writtenRD != FPC::NativeRealDescriptor())
+    {
+      return nullptr;
+    }
+
+    Box fab_box(hdr.m_ba[idx]);
+    if(hdr.m_ngrow.max() > 0) {
+        fab_box.grow(hdr.m_ngrow);
+    }
+
+    std::string FullName(VisMF::DirName(mf_name));
+    FullName += hdr.m_fod[idx].m_name;
+
+    std::shared_ptr<MappedFile> mfile = MapFile(FullName);
+    if( ! mfile) {
+      return nullptr;
+    }
+
+    long offset(hdr.m_fod[idx].m_head);
+    if(offset < 0 || offset >= long(mfile->length)) {
+      return nullptr;
+    }
+
+    if(hdr.m_vers == Header::Version_v1) {
+      //
+      // Check the fab header.  Only the "new" binary format in the native
+      // RealDescriptor can be used in place.
+      //
+      const char *fabHeader = mfile->base + offset;
+      const char *eol = static_cast<const char *>(std::memchr(fabHeader, '\n',
+                                                              mfile->length - offset));
+      if(eol == nullptr) {
+        return nullptr;
+      }
+      RealDescriptor rd;
+      if( ! ParseFabHeader(std::string(fabHeader, eol), fab_box, hdr.m_ncomp, rd) ||
+          rd != FPC::NativeRealDescriptor())
+      {
+        return nullptr;
+      }
+      offset += (eol - fabHeader) + 1;
+    }
+
+    const long bytesPerComp(fab_box.numPts() * sizeof(Real));
+    int nComp(hdr.m_ncomp);
+    if(whichComp != -1) {
+      offset += bytesPerComp * whichComp;
+      nComp = 1;
+    }
+
+    char *data = mfile->base + offset;
+    if(offset + bytesPerComp * nComp > long(mfile->length) ||
+       reinterpret_cast<std::uintptr_t>(data) % alignof(Real) != 0)
+    {
+      return nullptr;
+    }
+
+    return new MappedFab(fab_box, nComp, reinterpret_cast<Real *>(data), std::move(mfile));
+}
+
+
 void
 VisMF::readFAB (FabArray<FArrayBox> &mf,
 		int                  idx,
@@ -1374,7 +2717,9 @@ VisMF::readFAB (FabArray<FArrayBox> &mf,
     std::ifstream *infs = VisMF::OpenStream(FullName);
     infs->seekg(hdr.m_fod[idx].m_head, std::ios::beg);
 
-    if(NoFabHeader(hdr)) {
+    if(hdr.m_vers == Header::Compressed_v1) {
+      ReadCompressed(*infs, hdr, idx, 0, fab.nComp(), fab);
+    } else if(NoFabHeader(hdr)) {
       if(hdr.m_writtenRD == FPC::NativeRealDescriptor()) {
         infs->read((char *) fab.dataPtr(), fab.nBytes());
       } else {
@@ -1442,7 +2787,8 @@ VisMF::Read (FabArray<FArrayBox> &mf,
   int nProcs(ParallelDescriptor::NProcs());
   bool noFabHeader(NoFabHeader(hdr));
 
-  if(noFabHeader && useSynchronousReads) {
+  // ---- compressed fabs are read individually
+  if(noFabHeader && useSynchronousReads && hdr.m_vers != VisMF::Header::Compressed_v1) {
 
     // ---- This code is only for reading in file order
     bool doConvert(hdr.m_writtenRD != FPC::NativeRealDescriptor());
@@ -1835,6 +3181,286 @@ VisMF::Read (FabArray<FArrayBox> &mf,
 }
 
 
+void
+VisMF::ReadRegion (FabArray<FArrayBox> &mf,
+                   const std::string   &mf_name,
+                   const Box           &region,
+                   const Vector<int>   &comps,
+                   const char          *faHeader)
+{
+    BL_PROFILE("VisMF::ReadRegion()");
+
+    VisMF::Header hdr;
+    {
+        std::string fileCharPtrString;
+        if(faHeader == nullptr) {
+          Vector<char> fileCharPtr;
+          ParallelDescriptor::ReadAndBcastFile(mf_name + TheMultiFabHdrFileSuffix, fileCharPtr);
+          fileCharPtrString = fileCharPtr.dataPtr();
+        } else {
+          fileCharPtrString = faHeader;
+        }
+        std::istringstream infs(fileCharPtrString, std::istringstream::in);
+        infs >> hdr;
+    }
+
+    for(int n(0); n < comps.size(); ++n) {
+      if(comps[n] < 0 || comps[n] >= hdr.m_ncomp) {
+        amrex::Abort("VisMF::ReadRegion:  bad component");
+      }
+    }
+
+    //
+    // The parts of the on-disk boxes inside region.
+    //
+    BoxList bl(hdr.m_ba.ixType());
+    Vector<int> diskIndex;
+    for(int i(0); i < hdr.m_ba.size(); ++i) {
+      const Box b(hdr.m_ba[i] & region);
+      if(b.ok()) {
+        bl.push_back(b);
+        diskIndex.push_back(i);
+      }
+    }
+
+    mf.clear();
+    if(bl.isEmpty() || comps.empty()) {
+      return;
+    }
+
+    BoxArray ba(bl);
+    DistributionMapping dm(ba);
+    mf.define(ba, dm, comps.size(), 0, MFInfo(), FArrayBoxFactory());
+
+    //
+    // Group the fabs of this process by file, so each file is opened once
+    // and read by one thread.
+    //
+    std::map<std::string, Vector<int> > fabsInFile;  // ---- [filename, mf indices]
+    for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+      fabsInFile[hdr.m_fod[diskIndex[mfi.index()]].m_name].push_back(mfi.index());
+    }
+    Vector<std::pair<std::string, Vector<int> > > files(fabsInFile.begin(), fabsInFile.end());
+    const int nFiles(files.size());
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for(int f = 0; f < nFiles; ++f) {
+      const std::string fullName(VisMF::DirName(mf_name) + files[f].first);
+      std::ifstream ifs(fullName.c_str(), std::ios::in | std::ios::binary);
+      if( ! ifs.good()) {
+        amrex::FileOpenFailed(fullName);
+      }
+      const Vector<int> &index = files[f].second;
+      for(int i(0); i < index.size(); ++i) {
+        ReadFabRegion(ifs, hdr, diskIndex[index[i]], comps, mf[index[i]]);
+      }
+    }
+}
+
+
+long
+VisMF::Write (const FabArray<BaseFab<float> >& mf,
+              const std::string& mf_name,
+              VisMF::How         how,
+              bool               set_ghost)
+{
+    BL_PROFILE("VisMF::Write(FabArray<BaseFab<float> >)");
+    BL_ASSERT(mf_name[mf_name.length() - 1] != '/');
+    BL_ASSERT(currentVersion != VisMF::Header::Undefined_v1);
+
+    //
+    // The floats are written as they are in memory, so the data are in the
+    // native 32 bit format whatever FArrayBox::getFormat() is.
+    //
+    const RealDescriptor &rd = FPC::Native32RealDescriptor();
+    BL_ASSERT(rd.numBytes() == sizeof(float));
+
+    int version(currentVersion);
+    if(version == VisMF::Header::Compressed_v1) {
+      version = VisMF::Header::NoFabHeaderMinMax_v1;
+    }
+    const bool oldHeader(version == VisMF::Header::Version_v1);
+    const bool fabMinMax(version == VisMF::Header::Version_v1 ||
+                         version == VisMF::Header::NoFabHeaderMinMax_v1);
+    const bool faMinMax(version == VisMF::Header::NoFabHeaderFAMinMax_v1);
+
+    if(set_ghost) {
+        SetGhostToMidRange(mf);
+    }
+
+    const BoxArray &ba = mf.boxArray();
+    const int nComps(mf.nComp());
+    const int nBoxes(ba.size());
+    const int ioProc(ParallelDescriptor::IOProcessorNumber());
+    const std::string filePrefix(mf_name + FabFileSuffix);
+
+    //
+    // The heads of the fabs and the min and max of their components,
+    // summed into the IOProcessor.
+    //
+    Vector<long> heads(nBoxes, 0L);
+    Vector<Real> fabmm(fabMinMax ? 2*nComps*nBoxes : 0, 0.0);
+    Vector<Real> famin(nComps,  std::numeric_limits<Real>::max());
+    Vector<Real> famax(nComps, -std::numeric_limits<Real>::max());
+
+    for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+      const int idx(mfi.index());
+      for(int j(0); j < nComps; ++j) {
+        const Real vmin(mf[mfi].min(ba[idx], j));
+        const Real vmax(mf[mfi].max(ba[idx], j));
+        if(fabMinMax) {
+          fabmm[2*nComps*idx + j]          = vmin;
+          fabmm[2*nComps*idx + nComps + j] = vmax;
+        }
+        famin[j] = std::min(famin[j], vmin);
+        famax[j] = std::max(famax[j], vmax);
+      }
+    }
+
+    long bytesWritten(0);
+
+    NFilesIter nfi(nOutFiles, filePrefix, groupSets, setBuf);
+
+    for( ; nfi.ReadyToWrite(); ++nfi) {
+      for(MFIter mfi(mf); mfi.isValid(); ++mfi) {
+        const BaseFab<float> &fab = mf[mfi];
+        heads[mfi.index()] = VisMF::FileOffset(nfi.Stream());
+        if(oldHeader) {
+          std::stringstream hss;
+          hss << "FAB " << rd << fab.box() << ' ' << nComps << '\n';
+          const std::string fabHeader(hss.str());
+          nfi.Stream().write(fabHeader.c_str(), fabHeader.size());
+          bytesWritten += fabHeader.size();
+        }
+        const long nBytes(fab.box().numPts() * nComps * sizeof(float));
+        nfi.Stream().write(reinterpret_cast<const char *>(fab.dataPtr()), nBytes);
+        bytesWritten += nBytes;
+      }
+      nfi.Stream().flush();
+    }
+
+    ParallelDescriptor::ReduceLongSum(heads.dataPtr(), nBoxes, ioProc);
+    if(fabMinMax) {
+      ParallelDescriptor::ReduceRealSum(fabmm.dataPtr(), fabmm.size(), ioProc);
+    }
+    if(faMinMax) {
+      ParallelDescriptor::ReduceRealMin(famin.dataPtr(), nComps, ioProc);
+      ParallelDescriptor::ReduceRealMax(famax.dataPtr(), nComps, ioProc);
+    }
+
+    VisMF::Header hdr;
+    hdr.m_vers      = version;
+    hdr.m_how       = how;
+    hdr.m_ncomp     = nComps;
+    hdr.m_ngrow     = mf.nGrowVect();
+    hdr.m_ba        = ba;
+    hdr.m_writtenRD = rd;
+
+    if(ParallelDescriptor::MyProc() == ioProc) {
+      const DistributionMapping &dm = mf.DistributionMap();
+      hdr.m_fod.resize(nBoxes);
+      for(int i(0); i < nBoxes; ++i) {
+        const std::string name(NFilesIter::FileName(nOutFiles, filePrefix, dm[i], groupSets));
+        hdr.m_fod[i] = VisMF::FabOnDisk(VisMF::BaseName(name), heads[i]);
+      }
+      if(fabMinMax) {
+        hdr.m_min.resize(nBoxes);
+        hdr.m_max.resize(nBoxes);
+        for(int i(0); i < nBoxes; ++i) {
+          hdr.m_min[i].assign(fabmm.begin() + 2*nComps*i,
+                              fabmm.begin() + 2*nComps*i + nComps);
+          hdr.m_max[i].assign(fabmm.begin() + 2*nComps*i + nComps,
+                              fabmm.begin() + 2*nComps*(i+1));
+        }
+      }
+      if(faMinMax) {
+        hdr.m_famin = famin;
+        hdr.m_famax = famax;
+      }
+    }
+
+    bytesWritten += VisMF::WriteHeader(mf_name, hdr, ioProc);
+
+    return bytesWritten;
+}
+
+
+void
+VisMF::Read (FabArray<BaseFab<float> > &mf,
+             const std::string         &mf_name)
+{
+    BL_PROFILE("VisMF::Read(FabArray<BaseFab<float> >)");
+
+    FabArray<FArrayBox> tmp;
+    if ( ! mf.empty()) {
+        tmp.define(mf.boxArray(), mf.DistributionMap(), mf.nComp(), mf.nGrow());
+    }
+
+    VisMF::Read(tmp, mf_name);
+
+    if (mf.empty()) {
+        mf.define(tmp.boxArray(), tmp.DistributionMap(), tmp.nComp(), tmp.nGrow());
+    }
+
+    BL_ASSERT(mf.nComp() == tmp.nComp() && mf.nGrow() == tmp.nGrow());
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+    {
+        const FArrayBox& src = tmp[mfi];
+        BaseFab<float>&  dst = mf[mfi];
+        const Real* s = src.dataPtr();
+        float*      d = dst.dataPtr();
+        const long  n = src.box().numPts() * src.nComp();
+        for (long i = 0; i < n; ++i) {
+            d[i] = static_cast<float>(s[i]);
+        }
+    }
+}
+
+
+long
+VisMF::Write (const FabArray<AoSoAFab>& mf,
+              const std::string& mf_name,
+              VisMF::How         how,
+              bool               set_ghost)
+{
+    BL_PROFILE("VisMF::Write(FabArray<AoSoAFab>)");
+
+    FabArray<FArrayBox> tmp(mf.boxArray(), mf.DistributionMap(), mf.nComp(), mf.nGrow());
+    amrex::Copy(tmp, mf, 0, 0, mf.nComp(), mf.nGrow());
+
+    return VisMF::Write(tmp, mf_name, how, set_ghost);
+}
+
+
+void
+VisMF::Read (FabArray<AoSoAFab> &mf,
+             const std::string  &mf_name)
+{
+    BL_PROFILE("VisMF::Read(FabArray<AoSoAFab>)");
+
+    FabArray<FArrayBox> tmp;
+    if ( ! mf.empty()) {
+        tmp.define(mf.boxArray(), mf.DistributionMap(), mf.nComp(), mf.nGrow());
+    }
+
+    VisMF::Read(tmp, mf_name);
+
+    if (mf.empty()) {
+        mf.define(tmp.boxArray(), tmp.DistributionMap(), tmp.nComp(), tmp.nGrow());
+    }
+
+    BL_ASSERT(mf.nComp() == tmp.nComp() && mf.nGrow() == tmp.nGrow());
+
+    amrex::Copy(mf, tmp, 0, 0, mf.nComp(), mf.nGrow());
+}
+
+
 bool
 VisMF::Exist (const std::string& mf_name)
 {
@@ -1973,7 +3599,8 @@ VisMF::clear ()
 bool VisMF::NoFabHeader(const VisMF::Header &hdr) {
   if(hdr.m_vers == VisMF::Header::NoFabHeader_v1       ||
     hdr.m_vers == VisMF::Header::NoFabHeaderMinMax_v1 ||
-    hdr.m_vers == VisMF::Header::NoFabHeaderFAMinMax_v1)
+    hdr.m_vers == VisMF::Header::NoFabHeaderFAMinMax_v1 ||
+    hdr.m_vers == VisMF::Header::Compressed_v1)
   {
     return true;
   }
@@ -0,0 +1,423 @@
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <AMReX_BLassert.H>
+#include <AMReX_fMultiFab.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_BaseFabSIMD.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_BLProfiler.H>
+
+namespace amrex {
+
+namespace
+{
+    //
+    // Calls f(d[i], s[i]) for the cells of numcomp components of dst and
+    // src in the valid region grown by nghost.
+    //
+    template <class DFAB, class SFAB, class F>
+    void
+    ForEachCell (FabArray<DFAB>&       dst,
+                 const FabArray<SFAB>& src,
+                 int                   srccomp,
+                 int                   dstcomp,
+                 int                   numcomp,
+                 int                   nghost,
+                 F                     f)
+    {
+        BL_ASSERT(dst.boxArray() == src.boxArray());
+        BL_ASSERT(dst.DistributionMap() == src.DistributionMap());
+        BL_ASSERT(dst.nGrow() >= nghost && src.nGrow() >= nghost);
+        BL_ASSERT(srccomp >= 0 && srccomp+numcomp <= src.nComp());
+        BL_ASSERT(dstcomp >= 0 && dstcomp+numcomp <= dst.nComp());
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        for (MFIter mfi(dst,true); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.growntilebox(nghost);
+
+            if (bx.ok())
+            {
+                DFAB&       dfab = dst[mfi];
+                const SFAB& sfab = src[mfi];
+                simd::ForEachLine(bx, numcomp, [&] (const IntVect& off, int n, int len)
+                {
+                    auto       d = dfab.dataPtr(bx.smallEnd()+off, dstcomp+n);
+                    const auto s = sfab.dataPtr(bx.smallEnd()+off, srccomp+n);
+                    for (int i = 0; i < len; ++i) {
+                        f(d[i], s[i]);
+                    }
+                });
+            }
+        }
+    }
+
+    //
+    // Calls f(p, len) for each i-line of component comp of fab in bx.
+    //
+    template <class F>
+    void
+    ForEachLine (const BaseFab<float>& fab, const Box& bx, int comp, F f)
+    {
+        simd::ForEachLine(bx, 1, [&] (const IntVect& off, int, int len)
+        {
+            f(fab.dataPtr(bx.smallEnd()+off, comp), len);
+        });
+    }
+}
+
+fMultiFab::fMultiFab () {}
+
+fMultiFab::fMultiFab (const BoxArray&            bxs,
+                      const DistributionMapping& dm,
+                      int                        ncomp,
+                      int                        ngrow,
+		      const MFInfo&              info,
+                      const FabFactory<BaseFab<float> >& factory)
+    :
+    FabArray<BaseFab<float> >(bxs,dm,ncomp,ngrow,info,factory)
+{
+}
+
+fMultiFab::fMultiFab (const fMultiFab& rhs, MakeType maketype, int scomp, int ncomp)
+    :
+    FabArray<BaseFab<float> >(rhs, maketype, scomp, ncomp)
+{
+}
+
+void
+fMultiFab::operator= (const float& r)
+{
+    setVal(r);
+}
+
+void
+fMultiFab::define (const BoxArray&            bxs,
+		   const DistributionMapping& dm,
+		   int                        nvar,
+		   int                        ngrow,
+		   const MFInfo&              info,
+                   const FabFactory<BaseFab<float> >& factory)
+{
+    this->FabArray<BaseFab<float> >::define(bxs,dm,nvar,ngrow,info,factory);
+}
+
+const BaseFab<float>&
+fMultiFab::operator[] (int K) const
+{
+    BL_ASSERT(defined(K));
+
+    return this->FabArray<BaseFab<float> >::get(K);
+}
+
+BaseFab<float>&
+fMultiFab::operator[] (int K)
+{
+    BL_ASSERT(defined(K));
+
+    return this->FabArray<BaseFab<float> >::get(K);
+}
+
+Real
+fMultiFab::min (int comp, int nghost, bool local) const
+{
+    BL_ASSERT(nghost >= 0 && nghost <= n_grow.min());
+
+    Real mn = std::numeric_limits<Real>::max();
+
+#ifdef _OPENMP
+#pragma omp parallel reduction(min:mn)
+#endif
+    for (MFIter mfi(*this,true); mfi.isValid(); ++mfi)
+    {
+        ForEachLine(get(mfi), mfi.growntilebox(nghost), comp, [&] (const float* p, int len) {
+            for (int i = 0; i < len; ++i) mn = std::min(mn, Real(p[i]));
+        });
+    }
+
+    if (!local)
+	ParallelDescriptor::ReduceRealMin(mn);
+
+    return mn;
+}
+
+Real
+fMultiFab::max (int comp, int nghost, bool local) const
+{
+    BL_ASSERT(nghost >= 0 && nghost <= n_grow.min());
+
+    Real mx = std::numeric_limits<Real>::lowest();
+
+#ifdef _OPENMP
+#pragma omp parallel reduction(max:mx)
+#endif
+    for (MFIter mfi(*this,true); mfi.isValid(); ++mfi)
+    {
+        ForEachLine(get(mfi), mfi.growntilebox(nghost), comp, [&] (const float* p, int len) {
+            for (int i = 0; i < len; ++i) mx = std::max(mx, Real(p[i]));
+        });
+    }
+
+    if (!local)
+	ParallelDescriptor::ReduceRealMax(mx);
+
+    return mx;
+}
+
+Real
+fMultiFab::norm0 (int comp, int nghost, bool local) const
+{
+    BL_ASSERT(nghost >= 0 && nghost <= n_grow.min());
+
+    Real nm0 = 0.0;
+
+#ifdef _OPENMP
+#pragma omp parallel reduction(max:nm0)
+#endif
+    for (MFIter mfi(*this,true); mfi.isValid(); ++mfi)
+    {
+        ForEachLine(get(mfi), mfi.growntilebox(nghost), comp, [&] (const float* p, int len) {
+            for (int i = 0; i < len; ++i) nm0 = std::max(nm0, Real(std::abs(p[i])));
+        });
+    }
+
+    if (!local)
+	ParallelDescriptor::ReduceRealMax(nm0);
+
+    return nm0;
+}
+
+Real
+fMultiFab::norm1 (int comp, int ngrow, bool local) const
+{
+    BL_ASSERT(ngrow >= 0 && ngrow <= n_grow.min());
+
+    Real nm1 = 0.0;
+
+#ifdef _OPENMP
+#pragma omp parallel reduction(+:nm1)
+#endif
+    for (MFIter mfi(*this,true); mfi.isValid(); ++mfi)
+    {
+        ForEachLine(get(mfi), mfi.growntilebox(ngrow), comp, [&] (const float* p, int len) {
+            for (int i = 0; i < len; ++i) nm1 += std::abs(p[i]);
+        });
+    }
+
+    if (!local)
+	ParallelDescriptor::ReduceRealSum(nm1);
+
+    return nm1;
+}
+
+Real
+fMultiFab::norm2 (int comp, bool local) const
+{
+    BL_ASSERT(ixType().cellCentered());
+
+    return std::sqrt(Dot(*this, comp, *this, comp, 1, 0, local));
+}
+
+Real
+fMultiFab::sum (int comp, bool local) const
+{
+    Real sm = 0.0;
+
+#ifdef _OPENMP
+#pragma omp parallel reduction(+:sm)
+#endif
+    for (MFIter mfi(*this,true); mfi.isValid(); ++mfi)
+    {
+        ForEachLine(get(mfi), mfi.tilebox(), comp, [&] (const float* p, int len) {
+            for (int i = 0; i < len; ++i) sm += p[i];
+        });
+    }
+
+    if (!local)
+	ParallelDescriptor::ReduceRealSum(sm);
+
+    return sm;
+}
+
+void
+fMultiFab::plus (float val, int comp, int num_comp, int nghost)
+{
+    ForEachCell(*this, *this, comp, comp, num_comp, nghost,
+                [=] (float& d, float) { d += val; });
+}
+
+void
+fMultiFab::mult (float val, int comp, int num_comp, int nghost)
+{
+    ForEachCell(*this, *this, comp, comp, num_comp, nghost,
+                [=] (float& d, float) { d *= val; });
+}
+
+void
+fMultiFab::Add (fMultiFab& dst, const fMultiFab& src,
+                int srccomp, int dstcomp, int numcomp, int nghost)
+{
+    ForEachCell(dst, src, srccomp, dstcomp, numcomp, nghost,
+                [] (float& d, float s) { d += s; });
+}
+
+void
+fMultiFab::Copy (fMultiFab& dst, const fMultiFab& src,
+                 int srccomp, int dstcomp, int numcomp, int nghost)
+{
+    ForEachCell(dst, src, srccomp, dstcomp, numcomp, nghost,
+                [] (float& d, float s) { d = s; });
+}
+
+void
+fMultiFab::Subtract (fMultiFab& dst, const fMultiFab& src,
+                     int srccomp, int dstcomp, int numcomp, int nghost)
+{
+    ForEachCell(dst, src, srccomp, dstcomp, numcomp, nghost,
+                [] (float& d, float s) { d -= s; });
+}
+
+void
+fMultiFab::Multiply (fMultiFab& dst, const fMultiFab& src,
+                     int srccomp, int dstcomp, int numcomp, int nghost)
+{
+    ForEachCell(dst, src, srccomp, dstcomp, numcomp, nghost,
+                [] (float& d, float s) { d *= s; });
+}
+
+void
+fMultiFab::Divide (fMultiFab& dst, const fMultiFab& src,
+                   int srccomp, int dstcomp, int numcomp, int nghost)
+{
+    ForEachCell(dst, src, srccomp, dstcomp, numcomp, nghost,
+                [] (float& d, float s) { d /= s; });
+}
+
+void
+fMultiFab::Saxpy (fMultiFab& dst, float a, const fMultiFab& src,
+                  int srccomp, int dstcomp, int numcomp, int nghost)
+{
+    ForEachCell(dst, src, srccomp, dstcomp, numcomp, nghost,
+                [=] (float& d, float s) { d += a*s; });
+}
+
+void
+fMultiFab::Xpay (fMultiFab& dst, float a, const fMultiFab& src,
+                 int srccomp, int dstcomp, int numcomp, int nghost)
+{
+    ForEachCell(dst, src, srccomp, dstcomp, numcomp, nghost,
+                [=] (float& d, float s) { d = s + a*d; });
+}
+
+void
+fMultiFab::LinComb (fMultiFab& dst,
+                    float a, const fMultiFab& x, int xcomp,
+                    float b, const fMultiFab& y, int ycomp,
+                    int dstcomp, int numcomp, int nghost)
+{
+    BL_ASSERT(dst.boxArray() == x.boxArray());
+    BL_ASSERT(dst.DistributionMap() == x.DistributionMap());
+    BL_ASSERT(dst.boxArray() == y.boxArray());
+    BL_ASSERT(dst.DistributionMap() == y.DistributionMap());
+    BL_ASSERT(dst.nGrow() >= nghost && x.nGrow() >= nghost && y.nGrow() >= nghost);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(dst,true); mfi.isValid(); ++mfi)
+    {
+        const Box& bx = mfi.growntilebox(nghost);
+
+        if (bx.ok())
+        {
+            BaseFab<float>&       dfab = dst[mfi];
+            const BaseFab<float>& xfab = x[mfi];
+            const BaseFab<float>& yfab = y[mfi];
+            simd::ForEachLine(bx, numcomp, [&] (const IntVect& off, int n, int len)
+            {
+                const IntVect iv = bx.smallEnd()+off;
+                float*       d  = dfab.dataPtr(iv, dstcomp+n);
+                const float* xp = xfab.dataPtr(iv, xcomp+n);
+                const float* yp = yfab.dataPtr(iv, ycomp+n);
+                for (int i = 0; i < len; ++i) {
+                    d[i] = a*xp[i] + b*yp[i];
+                }
+            });
+        }
+    }
+}
+
+Real
+fMultiFab::Dot (const fMultiFab& x, int xcomp,
+                const fMultiFab& y, int ycomp,
+                int numcomp, int nghost, bool local)
+{
+    BL_ASSERT(x.boxArray() == y.boxArray());
+    BL_ASSERT(x.DistributionMap() == y.DistributionMap());
+    BL_ASSERT(x.nGrow() >= nghost && y.nGrow() >= nghost);
+
+    Real sm = 0.0;
+
+#ifdef _OPENMP
+#pragma omp parallel reduction(+:sm)
+#endif
+    for (MFIter mfi(x,true); mfi.isValid(); ++mfi)
+    {
+        const Box& bx = mfi.growntilebox(nghost);
+        const BaseFab<float>& xfab = x[mfi];
+        const BaseFab<float>& yfab = y[mfi];
+        simd::ForEachLine(bx, numcomp, [&] (const IntVect& off, int n, int len)
+        {
+            const IntVect iv = bx.smallEnd()+off;
+            const float* xp = xfab.dataPtr(iv, xcomp+n);
+            const float* yp = yfab.dataPtr(iv, ycomp+n);
+            for (int i = 0; i < len; ++i) {
+                sm += Real(xp[i])*Real(yp[i]);
+            }
+        });
+    }
+
+    if (!local)
+        ParallelDescriptor::ReduceRealSum(sm);
+
+    return sm;
+}
+
+void
+fMultiFab::Copy (fMultiFab& dst, const MultiFab& src,
+                 int srccomp, int dstcomp, int numcomp, int nghost)
+{
+    ForEachCell(dst, src, srccomp, dstcomp, numcomp, nghost,
+                [] (float& d, Real s) { d = static_cast<float>(s); });
+}
+
+void
+fMultiFab::Copy (MultiFab& dst, const fMultiFab& src,
+                 int srccomp, int dstcomp, int numcomp, int nghost)
+{
+    ForEachCell(dst, src, srccomp, dstcomp, numcomp, nghost,
+                [] (Real& d, float s) { d = s; });
+}
+
+void
+fMultiFab::Add (MultiFab& dst, const fMultiFab& src,
+                int srccomp, int dstcomp, int numcomp, int nghost)
+{
+    ForEachCell(dst, src, srccomp, dstcomp, numcomp, nghost,
+                [] (Real& d, float s) { d += s; });
+}
+
+void
+fMultiFab::Saxpy (MultiFab& dst, Real a, const fMultiFab& src,
+                  int srccomp, int dstcomp, int numcomp, int nghost)
+{
+    ForEachCell(dst, src, srccomp, dstcomp, numcomp, nghost,
+                [=] (Real& d, float s) { d += a*s; });
+}
+
+}
@@ -215,7 +215,7 @@ MGT_Solver::Build(const Vector<Geometry>& geom,
 
   for ( int lev = 0; lev < m_nlevel; ++lev )
     {
-      const Vector<int>& pmap = dmap[lev].ProcessorMap();
+      const auto& pmap = dmap[lev].ProcessorMap();
       Box domain = geom[lev].Domain();
 
       int nb = m_grids[lev].size();
@@ -0,0 +1,179 @@
+//
+// Compare the Fortran BaseFab<Real> kernels with the C++ ones in
+// AMReX_BaseFabSIMD.H, tile by tile.
+//
+//   main.ex [n_cell=64] [tile_size=8] [nrep=20] [tol=1.e-9]
+//
+// It aborts if a result differs from the Fortran one by more than tol,
+// relative for the reductions, which add up in a different order.
+//
+#include <AMReX.H>
+#include <AMReX_Print.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_FArrayBox.H>
+#include <AMReX_BaseFabSIMD.H>
+
+#include <cstring>
+#include <functional>
+#include <iomanip>
+
+using namespace amrex;
+
+namespace
+{
+    struct Result
+    {
+        double t_fort;
+        double t_cxx;
+        Real   diff;
+    };
+
+    //
+    // Runs f(tilebox) on all the tiles nrep times, first with the Fortran
+    // kernels through the BaseFab<Real> members, then with g, which calls
+    // the inlined C++ kernels.  The result of the last rep is compared.
+    //
+    Result
+    Compare (const BoxList& tiles, int nrep, FArrayBox& d, const FArrayBox& d0,
+             std::function<Real(const Box&)> f, std::function<Real(const Box&)> g)
+    {
+        Result r;
+
+        BaseFab_cxx_kernels = false;
+        Real rf = 0.0;
+        double t0 = ParallelDescriptor::second();
+        for (int irep = 0; irep < nrep; ++irep) {
+            std::memcpy(d.dataPtr(), d0.dataPtr(), d.nBytes());
+            rf = 0.0;
+            for (const Box& bx : tiles) rf += f(bx);
+        }
+        r.t_fort = ParallelDescriptor::second() - t0;
+        FArrayBox df(d.box(), d.nComp());
+        df.copy(d);
+
+        BaseFab_cxx_kernels = true;
+        Real rc = 0.0;
+        t0 = ParallelDescriptor::second();
+        for (int irep = 0; irep < nrep; ++irep) {
+            std::memcpy(d.dataPtr(), d0.dataPtr(), d.nBytes());
+            rc = 0.0;
+            for (const Box& bx : tiles) rc += g(bx);
+        }
+        r.t_cxx = ParallelDescriptor::second() - t0;
+
+        df.minus(d);
+        r.diff = std::max(df.norm(0), std::abs(rf-rc)/std::max(std::abs(rf),1.e-300));
+
+        return r;
+    }
+}
+
+int
+main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+
+    int n_cell    = 64;
+    int tile_size = 8;
+    int nrep      = 20;
+    Real tol      = 1.e-9;
+    {
+        ParmParse pp;
+        pp.query("n_cell", n_cell);
+        pp.query("tile_size", tile_size);
+        pp.query("nrep", nrep);
+        pp.query("tol", tol);
+    }
+
+    const Box domain(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(n_cell-1,n_cell-1,n_cell-1)));
+    const Box gbox = amrex::grow(domain, 2);
+    const int ncomp = 2;
+
+    BoxList tiles(domain);
+    tiles.maxSize(tile_size);
+
+    FArrayBox x(gbox, ncomp), y(gbox, ncomp), d(gbox, ncomp), d0(gbox, ncomp);
+    for (IntVect iv = gbox.smallEnd(); iv <= gbox.bigEnd(); gbox.next(iv)) {
+        for (int n = 0; n < ncomp; ++n) {
+            x(iv,n)  = std::sin(0.1*iv[0] + 0.2*iv[1] + 0.3*iv[2] + n);
+            y(iv,n)  = std::cos(0.3*iv[0] - 0.1*iv[1] + 0.2*iv[2] + n);
+            d0(iv,n) = 0.5 + 0.01*(iv[0] - iv[1]);
+        }
+    }
+
+    const Real a = 0.75, b = -1.25;
+    const IntVect shift = IntVect::TheUnitVector();
+
+    amrex::Print() << "Box " << domain << ", tile size " << tile_size
+                   << ", " << ncomp << " components, " << nrep << " reps\n";
+#if defined(BL_USE_DOUBLE) && defined(__AVX512F__)
+    amrex::Print() << "SIMD: AVX-512\n";
+#elif defined(BL_USE_DOUBLE) && defined(__AVX2__)
+    amrex::Print() << "SIMD: AVX2\n";
+#else
+    amrex::Print() << "SIMD: none\n";
+#endif
+    amrex::Print() << "  kernel        fortran (s)     c++ (s)     speedup    max diff\n";
+
+    int nfail = 0;
+    auto report = [&] (const char* name, const Result& r) {
+        const bool fail = !(r.diff <= tol);
+        amrex::Print() << "  " << std::left << std::setw(10) << name << std::right
+                       << std::setprecision(4)
+                       << std::setw(14) << r.t_fort << std::setw(12) << r.t_cxx
+                       << std::setw(12) << r.t_fort/r.t_cxx
+                       << std::setw(12) << r.diff << (fail ? "  FAILED" : "") << "\n";
+        if (fail) ++nfail;
+    };
+
+    report("copy", Compare(tiles, nrep, d, d0,
+        [&] (const Box& bx) { d.copy(x, bx+shift, 0, bx, 0, ncomp); return 0.0; },
+        [&] (const Box& bx) { simd::fabCopy(d, bx, 0, x, bx+shift, 0, ncomp); return 0.0; }));
+
+    report("setVal", Compare(tiles, nrep, d, d0,
+        [&] (const Box& bx) { d.setVal(a, bx, 0, ncomp); return 0.0; },
+        [&] (const Box& bx) { simd::fabSetVal(d, bx, 0, ncomp, a); return 0.0; }));
+
+    report("plus", Compare(tiles, nrep, d, d0,
+        [&] (const Box& bx) { d.plus(x, bx, bx, 0, 0, ncomp); return 0.0; },
+        [&] (const Box& bx) { simd::fabPlus(d, bx, 0, x, bx, 0, ncomp); return 0.0; }));
+
+    report("mult", Compare(tiles, nrep, d, d0,
+        [&] (const Box& bx) { d.mult(x, bx, bx, 0, 0, ncomp); return 0.0; },
+        [&] (const Box& bx) { simd::fabMult(d, bx, 0, x, bx, 0, ncomp); return 0.0; }));
+
+    report("saxpy", Compare(tiles, nrep, d, d0,
+        [&] (const Box& bx) { d.saxpy(a, x, bx, bx, 0, 0, ncomp); return 0.0; },
+        [&] (const Box& bx) { simd::fabSaxpy(d, bx, 0, a, x, bx, 0, ncomp); return 0.0; }));
+
+    report("xpay", Compare(tiles, nrep, d, d0,
+        [&] (const Box& bx) { d.xpay(a, x, bx, bx, 0, 0, ncomp); return 0.0; },
+        [&] (const Box& bx) { simd::fabXpay(d, bx, 0, a, x, bx, 0, ncomp); return 0.0; }));
+
+    report("linComb", Compare(tiles, nrep, d, d0,
+        [&] (const Box& bx) { d.linComb(x, bx, 0, y, bx, 0, a, b, bx, 0, ncomp); return 0.0; },
+        [&] (const Box& bx) { simd::fabLinComb(d, bx, 0, a, x, bx, 0, b, y, bx, 0, ncomp); return 0.0; }));
+
+    report("sum", Compare(tiles, nrep, d, d0,
+        [&] (const Box& bx) { return x.sum(bx, 0, ncomp); },
+        [&] (const Box& bx) { return simd::fabSum(x, bx, 0, ncomp); }));
+
+    report("dot", Compare(tiles, nrep, d, d0,
+        [&] (const Box& bx) { return x.dot(bx, 0, y, bx, 0, ncomp); },
+        [&] (const Box& bx) { return simd::fabDot(x, bx, 0, y, bx, 0, ncomp); }));
+
+    report("norm0", Compare(tiles, nrep, d, d0,
+        [&] (const Box& bx) { return x.norm(bx, 0, 0, ncomp); },
+        [&] (const Box& bx) { return simd::fabNorm0(x, bx, 0, ncomp); }));
+
+    report("norm1", Compare(tiles, nrep, d, d0,
+        [&] (const Box& bx) { return x.norm(bx, 1, 0, ncomp); },
+        [&] (const Box& bx) { return simd::fabNorm1(x, bx, 0, ncomp); }));
+
+    if (nfail > 0) {
+        amrex::Abort("BaseFabKernels: the C++ kernels differ from the Fortran ones by more than tol");
+    }
+
+    amrex::Finalize();
+}
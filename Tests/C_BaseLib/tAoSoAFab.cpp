@@ -0,0 +1,143 @@
+//
+// A test program for AoSoAFab: the layout of the data, and FillBoundary
+// and ParallelCopy of FabArray<AoSoAFab> against those of a MultiFab.
+//
+
+#include <AMReX_Utility.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_AoSoAFab.H>
+
+using namespace amrex;
+
+namespace
+{
+    Real value (const IntVect& iv, int n)
+    {
+        return D_TERM(iv[0], + 100*iv[1], + 10000*iv[2]) + 0.25*n;
+    }
+
+    void fail (const char* what)
+    {
+        amrex::Print(Print::AllProcs) << "tAoSoAFab: " << what << " failed\n";
+        amrex::Abort("tAoSoAFab failed");
+    }
+
+    //
+    // The data must be where AoSoAFab.H says they are.
+    //
+    void check_layout (int block)
+    {
+        const Box bx(IntVect(D_DECL(-1,2,0)), IntVect(D_DECL(5,4,3)));
+        const int ncomp = 3;
+        AoSoAFab fab(bx, ncomp, block);
+
+        if (fab.blockSize() != block) fail("blockSize");
+        if (fab.size() < bx.numPts()*ncomp) fail("size");
+
+        for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+            for (int n = 0; n < ncomp; ++n) {
+                fab(iv,n) = value(iv,n);
+            }
+        }
+
+        const Real* p = fab.dataPtr();
+        for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+        {
+            const long c = bx.index(iv);
+            for (int n = 0; n < ncomp; ++n)
+            {
+                const long k = (c/block)*block*ncomp + n*block + c%block;
+                if (fab.index(iv,n) != k)                fail("index");
+                if (p[k] != value(iv,n))                 fail("operator()");
+                if (fab.cellPtr(iv)[n*block] != p[k])    fail("cellPtr");
+            }
+        }
+        //
+        // Conversion to and from FArrayBox.
+        //
+        FArrayBox f(bx, ncomp);
+        fab.copyTo(f, bx, 0, 0, ncomp);
+        AoSoAFab g(bx, ncomp, block);
+        g.copyFrom(f, bx, 0, 0, ncomp);
+        for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+            for (int n = 0; n < ncomp; ++n) {
+                if (f(iv,n) != value(iv,n) || g(iv,n) != value(iv,n)) fail("copyTo/copyFrom");
+            }
+        }
+    }
+}
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv);
+    {
+        for (int block : {1, 4, 8}) {
+            check_layout(block);
+        }
+
+        const int  n_cell = 32;
+        const Box  domain(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(n_cell-1,n_cell-1,n_cell-1)));
+        BoxArray   ba(domain);
+        ba.maxSize(8);
+        DistributionMapping dm(ba);
+        const Periodicity period(IntVect(D_DECL(n_cell,n_cell,n_cell)));
+
+        const int ncomp = 3;
+        const int ngrow = 2;
+
+        MultiFab mf(ba, dm, ncomp, ngrow);
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.validbox();
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                for (int n = 0; n < ncomp; ++n) {
+                    mf[mfi](iv,n) = value(iv,n);
+                }
+            }
+        }
+        mf.setBndry(-1.0);
+        mf.FillBoundary(period);
+
+        for (int block : {1, 4})
+        {
+            FabArray<AoSoAFab> afa(ba, dm, ncomp, ngrow, MFInfo(), AoSoAFabFactory(block));
+            afa.setVal(-2.0);
+            amrex::Copy(afa, mf, 0, 0, ncomp, 0);
+            afa.setBndry(-1.0);
+            afa.FillBoundary(period);
+
+            MultiFab back(ba, dm, ncomp, ngrow);
+            back.setVal(0.0);
+            amrex::Copy(back, afa, 0, 0, ncomp, ngrow);
+            MultiFab::Subtract(back, mf, 0, 0, ncomp, ngrow);
+            if (back.norm0(0, ngrow) != 0.0 || back.norm0(ncomp-1, ngrow) != 0.0) {
+                fail("FillBoundary");
+            }
+            //
+            // Between different block sizes.
+            //
+            BoxArray ba2(domain);
+            ba2.maxSize(16);
+            DistributionMapping dm2(ba2);
+            FabArray<AoSoAFab> afa2(ba2, dm2, ncomp, 0, MFInfo(), AoSoAFabFactory(block == 1 ? 8 : 1));
+            afa2.setVal(0.0, 0, ncomp);
+            afa2.ParallelCopy(afa, 0, 0, ncomp);
+
+            MultiFab mf2(ba2, dm2, ncomp, 0);
+            amrex::Copy(mf2, afa2, 0, 0, ncomp, 0);
+            for (MFIter mfi(mf2); mfi.isValid(); ++mfi)
+            {
+                const Box& bx = mfi.validbox();
+                for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                    for (int n = 0; n < ncomp; ++n) {
+                        if (mf2[mfi](iv,n) != value(iv,n)) fail("ParallelCopy");
+                    }
+                }
+            }
+        }
+
+        amrex::Print() << "tAoSoAFab passed\n";
+    }
+    amrex::Finalize();
+}
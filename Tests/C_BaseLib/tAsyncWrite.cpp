@@ -0,0 +1,176 @@
+//
+// A test program for VisMF::AsyncWrite with amrex.async_out=1.  The
+// FabArrays written in the background, into fewer files than processes,
+// must read back as they were, files written over must be cut to their
+// new size, and a directory renamed by an OnComplete function must only
+// have its new name once Test or Finish has run it.
+//
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <AMReX_Utility.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_VisMF.H>
+#include <AMReX_AsyncOut.H>
+#include <AMReX_ParmParse.H>
+
+#include "tCheck.H"
+
+using namespace amrex;
+
+namespace
+{
+    const int nfiles = 2;
+
+    Real value (const IntVect& iv, int n, int m)
+    {
+        return D_TERM(iv[0], + 100*iv[1], + 10000*iv[2]) + 0.25*n + 1.e6*m;
+    }
+
+    void fill (MultiFab& mf, int m)
+    {
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.fabbox();
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                for (int n = 0; n < mf.nComp(); ++n) {
+                    mf[mfi](iv,n) = value(iv,n,m);
+                }
+            }
+        }
+    }
+
+    void check (const std::string& name, const BoxArray& ba, int ncomp, int m, const std::string& what)
+    {
+        MultiFab mf;
+        VisMF::Read(mf, name);
+        tCheck::Require(mf.boxArray() == ba && mf.nComp() == ncomp, "tAsyncWrite", what + " layout");
+
+        long nbad = 0;
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.fabbox();
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                for (int n = 0; n < ncomp; ++n) {
+                    if (mf[mfi](iv,n) != value(iv,n,m)) ++nbad;
+                }
+            }
+        }
+        tCheck::Require(nbad == 0, "tAsyncWrite", what);
+        //
+        // Before the file is written over.
+        //
+        ParallelDescriptor::Barrier();
+    }
+
+    long file_size (const std::string& file)
+    {
+        std::ifstream ifs(file, std::ios::binary | std::ios::ate);
+        return ifs.good() ? long(ifs.tellg()) : 0L;
+    }
+
+    //
+    // The total size of the data files of name.
+    //
+    long data_size (const std::string& name)
+    {
+        long sz = 0;
+        for (int k = 0; k < nfiles; ++k) {
+            sz += file_size(amrex::Concatenate(name + "_D_", k, 5));
+        }
+        return sz;
+    }
+}
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv, true, MPI_COMM_WORLD, [] () {
+        ParmParse pp("amrex");
+        pp.add("async_out", 1);
+    });
+    {
+        tCheck::Require(AsyncOut::UseAsyncOut(), "tAsyncWrite", "amrex.async_out");
+        VisMF::SetNOutFiles(nfiles);
+
+        const Box domain(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(31,31,31)));
+        BoxArray ba(domain);
+        ba.maxSize(8);
+        DistributionMapping dm(ba);
+
+        const std::string dir("tAsyncWrite_dir");
+        amrex::UtilCreateCleanDirectory(dir, true);
+
+        for (VisMF::Header::Version v : { VisMF::Header::Version_v1,
+                                          VisMF::Header::NoFabHeaderMinMax_v1 })
+        {
+            VisMF::SetHeaderVersion(v);
+            const std::string tag = " of version " + std::to_string(int(v));
+            const std::string name = dir + "/mf_v" + std::to_string(int(v));
+            //
+            // The data are staged, so the MultiFab may change right away.
+            // The second write is over the first, and smaller.
+            //
+            MultiFab big(ba, dm, 3, 1);
+            fill(big, 0);
+            VisMF::AsyncWrite(big, name);
+            big.setVal(-1.0);
+            AsyncOut::Finish();
+            check(name, ba, 3, 0, "reading back" + tag);
+
+            MultiFab small(ba, dm, 1, 0);
+            fill(small, 1);
+            long nbytes = VisMF::AsyncWrite(small, name);
+            small.setVal(-1.0);
+            AsyncOut::Finish();
+            check(name, ba, 1, 1, "reading back a smaller one" + tag);
+
+            //
+            // The bytes written include the header.
+            //
+            ParallelDescriptor::ReduceLongSum(nbytes);
+            if (ParallelDescriptor::IOProcessor()) {
+                tCheck::Require(data_size(name) == nbytes - file_size(name + "_H"),
+                                "tAsyncWrite", "cutting the files" + tag);
+            }
+        }
+        //
+        // A directory written as .temp and renamed once all the data are
+        // on disk, by Test if it gets to it and by Finish otherwise.
+        //
+        for (bool finish : { false, true })
+        {
+            const std::string final_dir = dir + "/renamed_" + std::to_string(int(finish));
+            const std::string temp_dir  = final_dir + ".temp";
+            amrex::UtilCreateCleanDirectory(temp_dir, true);
+
+            MultiFab mf(ba, dm, 2, 0);
+            fill(mf, 2);
+            VisMF::AsyncWrite(mf, temp_dir + "/mf");
+            AsyncOut::OnComplete([temp_dir, final_dir] () {
+                if (ParallelDescriptor::IOProcessor()) {
+                    std::rename(temp_dir.c_str(), final_dir.c_str());
+                }
+            });
+            ParallelDescriptor::Barrier();
+            tCheck::Require(!amrex::FileExists(final_dir), "tAsyncWrite", "not renamed before");
+
+            if (finish) {
+                AsyncOut::Finish();
+            } else {
+                AsyncOut::Wait();
+                ParallelDescriptor::Barrier();
+                tCheck::Require(AsyncOut::Test(), "tAsyncWrite", "Test running OnComplete");
+            }
+            ParallelDescriptor::Barrier();
+            tCheck::Require(amrex::FileExists(final_dir) && !amrex::FileExists(temp_dir),
+                            "tAsyncWrite", "renamed after");
+            check(final_dir + "/mf", ba, 2, 2, "reading the renamed one");
+        }
+
+        tCheck::Passed("tAsyncWrite");
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,153 @@
+//
+// A test program for the bounding volume hierarchy of BoxArray.  The
+// intersections it finds, one at a time or in batches, with ghost cells
+// and at periodic shifts, must be those of a scan over all the boxes.
+// removeOverlap, which still uses the hash, must agree with it as well.
+//
+
+#include <algorithm>
+#include <random>
+#include <string>
+
+#include <AMReX_Utility.H>
+#include <AMReX_BoxArray.H>
+#include <AMReX_Periodicity.H>
+
+#include "tCheck.H"
+
+using namespace amrex;
+
+namespace
+{
+    typedef std::vector< std::pair<int,Box> > ISects;
+
+    const int n_cell = 32;
+
+    Box random_box (std::mt19937& gen, int maxlen)
+    {
+        std::uniform_int_distribution<int> pos(-4, n_cell+3);
+        std::uniform_int_distribution<int> len(1, maxlen);
+        IntVect lo, hi;
+        for (int d = 0; d < BL_SPACEDIM; ++d) {
+            lo[d] = pos(gen);
+            hi[d] = lo[d] + len(gen) - 1;
+        }
+        return Box(lo, hi);
+    }
+
+    ISects scan (const BoxArray& ba, const Box& bx, const IntVect& ng)
+    {
+        ISects isects;
+        for (int i = 0; i < ba.size(); ++i)
+        {
+            const Box& isect = bx & amrex::grow(ba[i], ng);
+            if (isect.ok()) {
+                isects.push_back(std::make_pair(i, isect));
+            }
+        }
+        return isects;
+    }
+
+    //
+    // The intersections of the query boxes, at each periodic shift, with
+    // each ghost cell width, for all of them and for the first one only.
+    //
+    void check (const BoxArray& ba, const Vector<Box>& queries, const std::string& what)
+    {
+        const Periodicity period(IntVect(D_DECL(n_cell,n_cell,n_cell)));
+        const std::vector<IntVect> shifts = period.shiftIntVect();
+
+        long nbad = 0;
+        long nfound = 0;
+        for (const IntVect& ng : { IntVect::TheZeroVector(), IntVect(2), IntVect(D_DECL(1,0,3)) })
+        {
+            for (bool first_only : { false, true })
+            {
+                Vector<Box> bxs;
+                for (const Box& q : queries) {
+                    for (const IntVect& iv : shifts) {
+                        bxs.push_back(amrex::convert(q, ba.ixType()) + iv);
+                    }
+                }
+
+                Vector<ISects> batched;
+                ba.intersections(bxs, batched, first_only, ng);
+
+                for (int k = 0; k < bxs.size(); ++k)
+                {
+                    const ISects& ref = scan(ba, bxs[k], ng);
+                    const ISects& isects = ba.intersections(bxs[k], first_only, ng);
+                    nfound += ref.size();
+                    if (first_only) {
+                        if (isects.size() != std::min<std::size_t>(ref.size(), 1) ||
+                            (!isects.empty() && std::find(ref.begin(), ref.end(), isects[0]) == ref.end())) {
+                            ++nbad;
+                        }
+                    } else if (isects != ref) {
+                        ++nbad;
+                    }
+                    if (batched[k] != isects) ++nbad;
+                }
+            }
+        }
+        tCheck::Require(nbad == 0, "tBVH", what);
+        tCheck::Require(nfound > 0, "tBVH", what + " finding anything");
+    }
+}
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv);
+    {
+        std::mt19937 gen(12345);
+
+        Vector<Box> queries;
+        for (int k = 0; k < 200; ++k) {
+            queries.push_back(random_box(gen, 12));
+        }
+        //
+        // Overlapping boxes of all sizes, including ones outside the
+        // domain, so that the periodic shifts find some.
+        //
+        BoxList bl;
+        for (int k = 0; k < 500; ++k) {
+            bl.push_back(random_box(gen, (k%10 == 0) ? 16 : 4));
+        }
+        BoxArray ba(bl);
+        check(ba, queries, "random boxes");
+        //
+        // The same boxes coarsened and converted, so the query regions are
+        // not the boxes themselves.
+        //
+        BoxArray cba = ba;
+        cba.coarsen(2);
+        check(cba, queries, "coarsened boxes");
+
+        BoxArray nba = ba;
+        nba.surroundingNodes();
+        check(nba, queries, "nodal boxes");
+        //
+        // removeOverlap must cover the same cells without overlap.
+        //
+        BoxArray dba = ba;
+        dba.removeOverlap();
+        tCheck::Require(dba.isDisjoint(), "tBVH", "removeOverlap disjoint");
+
+        const Box bbox = ba.minimalBox();
+        long ncovered = 0;
+        long nbad = 0;
+        for (IntVect iv = bbox.smallEnd(); iv <= bbox.bigEnd(); bbox.next(iv))
+        {
+            const Box cell(iv, iv);
+            const bool in = !scan(ba, cell, IntVect::TheZeroVector()).empty();
+            if (in) ++ncovered;
+            if (in != dba.intersects(cell)) ++nbad;
+        }
+        tCheck::Require(nbad == 0 && dba.numPts() == ncovered, "tBVH", "removeOverlap cells");
+        check(dba, queries, "disjoint boxes");
+
+        tCheck::Passed("tBVH");
+    }
+    amrex::Finalize();
+}
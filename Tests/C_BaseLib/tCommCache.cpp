@@ -0,0 +1,138 @@
+//
+// A test program for the memory limit of the FillBoundary cache.  When the
+// limit is exceeded, the least recently used entry must be evicted first,
+// and pinned entries and those of FillBoundaries in flight not at all.
+//
+
+#include <AMReX_Utility.H>
+#include <AMReX_MultiFab.H>
+
+#include "tCheck.H"
+
+using namespace amrex;
+
+namespace
+{
+    //
+    // The limit and the pins are protected, as they are normally only
+    // used by the library.
+    //
+    struct CacheKnobs
+        : public FabArrayBase
+    {
+        static void setMaxBytes (long max_bytes) { comm_cache_max_bytes = max_bytes; }
+
+        static void flush () { flushFBCache(); }
+
+        static void pinFB (const FabArrayBase& fa, const IntVect& ng, const Periodicity& period)
+        {
+            pin((fa.*(&CacheKnobs::getFB))(ng, period, false, false, false));
+        }
+
+        static void unpinFB (const FabArrayBase& fa, const IntVect& ng, const Periodicity& period)
+        {
+            unpin((fa.*(&CacheKnobs::getFB))(ng, period, false, false, false));
+        }
+    };
+
+    //
+    // Returns whether the FillBoundary found its entry in the cache.
+    //
+    bool cached (MultiFab& mf, const IntVect& ng, const Periodicity& period)
+    {
+        const long nbuild = FabArrayBase::FBCacheStats().nbuild;
+        mf.FillBoundary(0, mf.nComp(), ng, period);
+        return FabArrayBase::FBCacheStats().nbuild == nbuild;
+    }
+
+    long cache_bytes () { return FabArrayBase::FBCacheStats().bytes; }
+}
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv);
+    {
+        const int n_cell = 64;
+        const Box domain(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(n_cell-1,n_cell-1,n_cell-1)));
+        const Periodicity period(IntVect(D_DECL(n_cell,n_cell,n_cell)));
+        const Periodicity nonperiodic = Periodicity::NonPeriodic();
+
+        BoxArray ba(domain);
+        ba.maxSize(16);
+        DistributionMapping dm(ba);
+
+        MultiFab a(ba, dm, 2, 2);
+        MultiFab b(ba, dm, 2, 2);
+        a.setVal(1.0);
+        b.setVal(2.0);
+        //
+        // Three different entries.
+        //
+        const IntVect ng1(D_DECL(1,1,1));
+        const IntVect ng2(D_DECL(2,2,2));
+
+        CacheKnobs::flush();
+        CacheKnobs::setMaxBytes(-1);
+
+        long bytes0 = cache_bytes();
+        cached(a, ng1, period);
+        const long bytes1 = cache_bytes() - bytes0;
+        bytes0 = cache_bytes();
+        cached(a, ng2, period);
+        const long bytes2 = cache_bytes() - bytes0;
+        bytes0 = cache_bytes();
+        cached(a, ng2, nonperiodic);
+        const long bytes3 = cache_bytes() - bytes0;
+        //
+        // Room for all but one byte of the three, so building the third
+        // must evict the least recently used one only.
+        //
+        CacheKnobs::flush();
+        cached(a, ng1, period);
+        cached(a, ng2, period);
+        tCheck::Require(cached(a, ng1, period), "tCommCache", "hit");
+
+        CacheKnobs::setMaxBytes(bytes1 + bytes2 + bytes3 - 1);
+        tCheck::Require(!cached(a, ng2, nonperiodic), "tCommCache", "miss");
+        tCheck::Require(cached(a, ng1, period), "tCommCache", "keeping a recent entry");
+        tCheck::Require(!cached(a, ng2, period), "tCommCache", "evicting the oldest entry");
+        tCheck::Require(cached(a, ng1, period), "tCommCache", "keeping a recent entry");
+        tCheck::Require(!cached(a, ng2, nonperiodic), "tCommCache", "evicting the oldest entry");
+        tCheck::Require(cache_bytes() < bytes1 + bytes2 + bytes3, "tCommCache", "cache size");
+        //
+        // No room at all.  A pinned entry stays, however old.
+        //
+        CacheKnobs::flush();
+        CacheKnobs::setMaxBytes(-1);
+        cached(a, ng1, period);
+        CacheKnobs::pinFB(a, ng1, period);
+        cached(a, ng2, period);
+
+        CacheKnobs::setMaxBytes(0);
+        tCheck::Require(!cached(a, ng2, nonperiodic), "tCommCache", "miss");
+        tCheck::Require(cached(a, ng1, period), "tCommCache", "keeping a pinned entry");
+        tCheck::Require(!cached(a, ng2, period), "tCommCache", "evicting an entry");
+
+        CacheKnobs::unpinFB(a, ng1, period);
+        cached(a, ng2, nonperiodic);
+        tCheck::Require(!cached(a, ng1, period), "tCommCache", "evicting an unpinned entry");
+        //
+        // Nor is an entry evicted while its FillBoundary is in flight.  With
+        // one process, FillBoundary_nowait finishes before it returns.
+        //
+        CacheKnobs::flush();
+        b.FillBoundary_nowait(period);
+        tCheck::Require(!cached(a, ng2, nonperiodic), "tCommCache", "miss");
+        b.FillBoundary_finish();
+        if (ParallelDescriptor::NProcs() > 1) {
+            tCheck::Require(cached(b, ng2, period), "tCommCache", "keeping an entry in flight");
+        }
+        tCheck::Require(b.min(0, 2) == 2.0 && b.max(0, 2) == 2.0, "tCommCache", "FillBoundary");
+
+        CacheKnobs::setMaxBytes(-1);
+
+        tCheck::Passed("tCommCache");
+    }
+    amrex::Finalize();
+}
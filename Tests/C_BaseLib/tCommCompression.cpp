@@ -0,0 +1,142 @@
+//
+// A test program for the compression of FillBoundary and ParallelCopy
+// messages.  Lossless compression must give the data bit for bit, and
+// lossy compression each value within the tolerance relative to it.
+//
+
+#include <cmath>
+#include <string>
+
+#include <AMReX_Utility.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_iMultiFab.H>
+
+#include "tCheck.H"
+
+using namespace amrex;
+
+namespace
+{
+    const int n_cell = 64;
+
+    //
+    // Smooth in space, with values of very different sizes and both signs
+    // in the different components.
+    //
+    Real value (IntVect iv, int n)
+    {
+        for (int d = 0; d < BL_SPACEDIM; ++d) {
+            iv[d] = (iv[d] + n_cell) % n_cell;
+        }
+        Real v = 1.5;
+        for (int d = 0; d < BL_SPACEDIM; ++d) {
+            v += std::sin(0.2*(d+1)*iv[d]);
+        }
+        return (n == 0) ? v : ((n == 1) ? -1.e-8*v : 1.e6*v*v);
+    }
+
+    long ivalue (IntVect iv)
+    {
+        for (int d = 0; d < BL_SPACEDIM; ++d) {
+            iv[d] = (iv[d] + n_cell) % n_cell;
+        }
+        return D_TERM(iv[0], + 100*iv[1], + 10000*iv[2]);
+    }
+
+    bool close_enough (Real v, Real expected, Real tol)
+    {
+        return (tol == 0.0) ? v == expected : std::abs(v - expected) <= tol*std::abs(expected);
+    }
+
+    void check (const MultiFab& mf, int ng, Real factor, Real tol, const std::string& what)
+    {
+        long nbad = 0;
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = amrex::grow(mfi.validbox(), ng);
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                for (int n = 0; n < mf.nComp(); ++n) {
+                    if (!close_enough(mf[mfi](iv,n), factor*value(iv,n), tol)) ++nbad;
+                }
+            }
+        }
+        tCheck::Require(nbad == 0, "tCommCompression", what);
+    }
+}
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv);
+    {
+        const Box domain(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(n_cell-1,n_cell-1,n_cell-1)));
+        const Periodicity period(IntVect(D_DECL(n_cell,n_cell,n_cell)));
+
+        BoxArray ba(domain);
+        ba.maxSize(16);
+        DistributionMapping dm(ba);
+
+        BoxArray ba2(domain);
+        ba2.maxSize(32);
+        DistributionMapping dm2(ba2);
+
+        typedef FabArrayBase::CommCompression CC;
+
+        for (const CC& cc : { CC(CC::None), CC(CC::Lossless), CC(CC::Lossy, 1.e-6) })
+        {
+            const std::string mode = std::to_string(int(cc.mode));
+            const Real tol = (cc.mode == CC::Lossy) ? cc.tol : 0.0;
+
+            MultiFab a(ba, dm, 3, 2);
+            iMultiFab ia(ba, dm, 1, 1);
+            a.SetCommCompression(cc);
+            ia.SetCommCompression(CC(cc.mode == CC::None ? CC::None : CC::Lossless));
+
+            for (MFIter mfi(a); mfi.isValid(); ++mfi)
+            {
+                const Box& bx = mfi.validbox();
+                for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                    for (int n = 0; n < 3; ++n) {
+                        a[mfi](iv,n) = value(iv,n);
+                    }
+                    ia[mfi](iv,0) = ivalue(iv);
+                }
+            }
+            //
+            // Twice, so that the cached communication is reused.
+            //
+            for (int iter = 0; iter < 2; ++iter)
+            {
+                a.setBndry(-1.0);
+                ia.setBndry(-1);
+
+                a.FillBoundary(1, 1, period);
+                a.FillBoundary_nowait(period);
+                a.FillBoundary_finish();
+                ia.FillBoundary(period);
+                check(a, 2, 1.0, tol, "FillBoundary with mode " + mode);
+
+                long nbad = 0;
+                for (MFIter mfi(ia); mfi.isValid(); ++mfi)
+                {
+                    const Box& bx = mfi.fabbox();
+                    for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                        if (ia[mfi](iv,0) != ivalue(iv)) ++nbad;
+                    }
+                }
+                tCheck::Require(nbad == 0, "tCommCompression", "iMultiFab FillBoundary with mode " + mode);
+                //
+                // The destination does not compress, so the source decides.
+                //
+                MultiFab b(ba2, dm2, 3, 0);
+                b.setVal(0.0);
+                b.ParallelCopy(a, 0, 0, 3);
+                b.ParallelCopy(a, 0, 0, 3, 0, 0, Periodicity::NonPeriodic(), FabArrayBase::ADD);
+                check(b, 0, 2.0, 2*tol, "ParallelCopy with mode " + mode);
+            }
+        }
+
+        tCheck::Passed("tCommCompression");
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,137 @@
+//
+// A test program for the persistent communication plans of FillBoundary
+// and ParallelCopy.  Repeated calls through a cached plan must give what
+// the calls without plans give, also after entries have been evicted from
+// the cache and rebuilt.
+//
+
+#include <AMReX_Utility.H>
+#include <AMReX_MultiFab.H>
+
+#include "tCheck.H"
+
+using namespace amrex;
+
+namespace
+{
+    //
+    // The knobs are protected, as they are normally set from the inputs.
+    //
+    struct CommKnobs
+        : public FabArrayBase
+    {
+        static void set (bool persistent, long max_bytes)
+        {
+            do_persistent_comm   = persistent;
+            comm_cache_max_bytes = max_bytes;
+        }
+
+        static void flush ()
+        {
+            flushFBCache();
+            flushCPCache();
+        }
+    };
+
+    //
+    // Different numbers of components need different plans, and different
+    // numbers of ghost cells different cache entries.
+    //
+    void exchange (MultiFab& a, MultiFab& b, const Periodicity& period)
+    {
+        a.setBndry(-1.0);
+        a.FillBoundary(0, 2, period);
+        a.FillBoundary(2, 1, IntVect(D_DECL(1,1,1)), period);
+        a.FillBoundary_nowait(2, 1, period);
+        a.FillBoundary_finish();
+
+        b.setVal(0.0);
+        b.ParallelCopy(a, 0, 0, a.nComp());
+        b.ParallelCopy(a, 1, 1, 1, 0, 0, Periodicity::NonPeriodic(), FabArrayBase::ADD);
+    }
+
+    void compare (const MultiFab& mf, const MultiFab& ref, const std::string& what)
+    {
+        MultiFab diff(ref.boxArray(), ref.DistributionMap(), ref.nComp(), ref.nGrow());
+        MultiFab::Copy(diff, ref, 0, 0, ref.nComp(), ref.nGrow());
+        MultiFab::Subtract(diff, mf, 0, 0, ref.nComp(), ref.nGrow());
+        for (int n = 0; n < ref.nComp(); ++n) {
+            tCheck::Require(diff.norm0(n, ref.nGrow()) == 0.0, "tCommPlan", what);
+        }
+    }
+}
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv);
+    {
+        const int n_cell = 64;
+        const Box domain(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(n_cell-1,n_cell-1,n_cell-1)));
+        const Periodicity period(IntVect(D_DECL(n_cell,n_cell,n_cell)));
+
+        BoxArray ba(domain);
+        ba.maxSize(16);
+        DistributionMapping dm(ba);
+
+        BoxArray ba2(domain);
+        ba2.maxSize(32);
+        DistributionMapping dm2(ba2);
+
+        const int ncomp = 3;
+        const int ngrow = 2;
+        MultiFab a(ba, dm, ncomp, ngrow);
+        for (MFIter mfi(a); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.validbox();
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                for (int n = 0; n < ncomp; ++n) {
+                    a[mfi](iv,n) = D_TERM(iv[0], + 100*iv[1], + 10000*iv[2]) + 0.5*n;
+                }
+            }
+        }
+        MultiFab b(ba2, dm2, ncomp, 0);
+
+        CommKnobs::set(false, -1);
+        exchange(a, b, period);
+
+        MultiFab ref_a(ba, dm, ncomp, ngrow);
+        MultiFab ref_b(ba2, dm2, ncomp, 0);
+        MultiFab::Copy(ref_a, a, 0, 0, ncomp, ngrow);
+        MultiFab::Copy(ref_b, b, 0, 0, ncomp, 0);
+
+        CommKnobs::flush();
+        //
+        // The first time builds the plans, the others reuse them.
+        //
+        CommKnobs::set(true, -1);
+        for (int iter = 0; iter < 3; ++iter)
+        {
+            exchange(a, b, period);
+            compare(a, ref_a, "FillBoundary through a plan");
+            compare(b, ref_b, "ParallelCopy through a plan");
+        }
+        //
+        // No room in the cache, so each new entry evicts the others.  The
+        // cache is only trimmed when an entry is built, so build one first.
+        //
+        const long nevict = FabArrayBase::FBCacheStats().nevict
+                          + FabArrayBase::CPCacheStats().nevict;
+        CommKnobs::set(true, 0);
+        a.FillBoundary(Periodicity::NonPeriodic());
+        for (int iter = 0; iter < 3; ++iter)
+        {
+            exchange(a, b, period);
+            compare(a, ref_a, "FillBoundary after eviction");
+            compare(b, ref_b, "ParallelCopy after eviction");
+        }
+        tCheck::Require(FabArrayBase::FBCacheStats().nevict
+                        + FabArrayBase::CPCacheStats().nevict > nevict,
+                        "tCommPlan", "eviction");
+
+        CommKnobs::set(true, -1);
+
+        tCheck::Passed("tCommPlan");
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,206 @@
+//
+// A test program for the compact BoxArray and the run-length encoded
+// DistributionMapping.  Both must give what their uncompressed forms
+// give, also after boxes are set, and building a new processor map must
+// drop the compressed and node shared ones.
+//
+
+#include <random>
+#include <string>
+
+#include <AMReX_Utility.H>
+#include <AMReX_BoxArray.H>
+#include <AMReX_DistributionMapping.H>
+#include <AMReX_NodeShared.H>
+#include <AMReX_ParmParse.H>
+
+#include "tCheck.H"
+
+using namespace amrex;
+
+namespace
+{
+    const int n_cell = 64;
+
+    bool same_boxes (const BoxArray& a, const BoxArray& b)
+    {
+        if (a.size() != b.size() || a.ixType() != b.ixType()) return false;
+        for (int i = 0; i < a.size(); ++i) {
+            if (a[i] != b[i]) return false;
+        }
+        return true;
+    }
+
+    bool same_map (const DistributionMapping& a, const DistributionMapping& b)
+    {
+        if (a.size() != b.size()) return false;
+        const auto& pa = a.ProcessorMap();
+        const auto& pb = b.ProcessorMap();
+        for (int i = 0; i < a.size(); ++i) {
+            if (pa[i] != pb[i] || a[i] != pb[i]) return false;
+        }
+        return true;
+    }
+
+    //
+    // Intersections of random boxes, with and without ghost cells, which
+    // also reach outside the domain.
+    //
+    void check_intersections (const BoxArray& ba, const BoxArray& ref, const std::string& what)
+    {
+        std::mt19937 gen(4321);
+        std::uniform_int_distribution<int> pos(-8, n_cell+4);
+        std::uniform_int_distribution<int> len(1, 20);
+
+        long nbad = 0;
+        for (int k = 0; k < 500; ++k)
+        {
+            IntVect lo, hi;
+            for (int d = 0; d < BL_SPACEDIM; ++d) {
+                lo[d] = pos(gen);
+                hi[d] = lo[d] + len(gen) - 1;
+            }
+            const Box bx = amrex::convert(Box(lo, hi), ba.ixType());
+            for (int ng : { 0, 2 })
+            {
+                if (ba.intersections(bx, false, ng) != ref.intersections(bx, false, ng)) ++nbad;
+                if (ba.intersects(bx, ng) != ref.intersects(bx, ng)) ++nbad;
+            }
+        }
+        tCheck::Require(nbad == 0, "tCompactLayout", what + " intersections");
+    }
+}
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv, true, MPI_COMM_WORLD, [] () {
+        ParmParse pp("boxarray");
+        pp.add("compact_min_boxes", 64);
+        pp.add("node_shared", 1);
+        ParmParse ppdm("DistributionMapping");
+        ppdm.add("compress_min_boxes", 64);
+    });
+    {
+        const int nprocs = ParallelDescriptor::NProcs();
+        //
+        // A regular BoxArray and the same boxes as a list.
+        //
+        const Box domain(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(n_cell-1,n_cell-1,n_cell-1)));
+        BoxArray ba(domain);
+        ba.maxSize(IntVect(D_DECL(8,16,8)));
+        tCheck::Require(ba.isCompact(), "tCompactLayout", "maxSize making a lattice");
+
+        BoxArray ref(ba.boxList());
+        tCheck::Require(!ref.isCompact(), "tCompactLayout", "a list");
+        tCheck::Require(same_boxes(ba, ref) && ba == ref && ref == ba, "tCompactLayout", "lattice boxes");
+        check_intersections(ba, ref, "lattice");
+        //
+        // Boxes that differ from the lattice, smaller than their cell and
+        // reaching into the others.  The list has been searched, so its
+        // bounding volume hierarchy must be rebuilt.
+        //
+        const int i1 = 5;
+        const int i2 = ba.size()/2;
+        const Box b1 = amrex::growHi(ba[i1], 0, -3);
+        const Box b2 = amrex::grow(ba[i2], 3);
+        ba.set(i1, b1);
+        ba.set(i2, b2);
+        ref.set(i1, b1);
+        ref.set(i2, b2);
+        ref.clear_hash_bin();
+        tCheck::Require(ba.isCompact(), "tCompactLayout", "set keeping the lattice");
+        tCheck::Require(same_boxes(ba, ref) && ba == ref, "tCompactLayout", "exceptions");
+        check_intersections(ba, ref, "exceptions");
+
+        BoxArray cba = ba;
+        BoxArray cref = ref;
+        cba.coarsen(2);
+        cref.coarsen(2);
+        tCheck::Require(cba.isCompact() && same_boxes(cba, cref) && cba == cref,
+                        "tCompactLayout", "coarsened lattice");
+        check_intersections(cba, cref, "coarsened lattice");
+
+        BoxArray nba = ba;
+        BoxArray nref = ref;
+        nba.convert(IntVect::TheNodeVector());
+        nref.convert(IntVect::TheNodeVector());
+        tCheck::Require(nba.isCompact() && same_boxes(nba, nref) && nba == nref,
+                        "tCompactLayout", "nodal lattice");
+        check_intersections(nba, nref, "nodal lattice");
+
+        BoxArray uba = ba;
+        uba.uniqify();
+        tCheck::Require(!uba.isCompact() && ba.isCompact() && same_boxes(uba, ref) && uba == ref,
+                        "tCompactLayout", "uniqify");
+
+        BoxArray ucba = cba;
+        ucba.uniqify();
+        tCheck::Require(!ucba.isCompact() && same_boxes(ucba, cref), "tCompactLayout",
+                        "uniqify of the coarsened lattice");
+
+        BoxArray other(domain);
+        other.maxSize(IntVect(D_DECL(16,8,8)));
+        tCheck::Require(other.isCompact() && !(other == ba) && !(other == ref), "tCompactLayout",
+                        "different lattices");
+        //
+        // A map along the last direction, which the SFC strategy gives in
+        // runs.
+        //
+        const Box column(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(7,7,1023)));
+        BoxArray zba(column);
+        zba.maxSize(IntVect(D_DECL(8,8,1)));
+        tCheck::Require(zba.isCompact(), "tCompactLayout", "column lattice");
+
+        DistributionMapping dm(zba);
+        tCheck::Require(dm.isCompressed(), "tCompactLayout", "compressing the map");
+
+        const auto& pmap = dm.ProcessorMap();
+        DistributionMapping dmref(Vector<int>(pmap.begin(), pmap.end()));
+        tCheck::Require(!dmref.isCompressed() && same_map(dm, dmref) && dm == dmref && dmref == dm,
+                        "tCompactLayout", "compressed map");
+
+        DistributionMapping dmcopy = dm;
+        tCheck::Require(dmcopy == dm && same_map(dmcopy, dmref), "tCompactLayout", "copied map");
+        //
+        // The maps of the general BoxArray too, compressed or not.
+        //
+        DistributionMapping dmba(ba);
+        DistributionMapping dmbaref(Vector<int>(dmba.ProcessorMap().begin(), dmba.ProcessorMap().end()));
+        tCheck::Require(same_map(dmba, dmbaref) && dmba == dmbaref, "tCompactLayout", "lattice map");
+        //
+        // New processor maps, on a compressed map and on a node shared one.
+        //
+        std::vector<long> wgts(zba.size());
+        for (int i = 0; i < zba.size(); ++i) {
+            wgts[i] = 1 + i%7;
+        }
+
+        for (int m = 0; m < 4; ++m)
+        {
+            DistributionMapping compressed(zba);
+            DistributionMapping shared(Vector<int>(zba.size()/2, 0));
+            shared.ShareOnNode();
+            DistributionMapping fresh;
+
+            for (DistributionMapping* d : { &compressed, &shared, &fresh })
+            {
+                switch (m) {
+                case 0: d->RoundRobinProcessorMap(zba.size(), nprocs); break;
+                case 1: d->RoundRobinProcessorMap(wgts, nprocs); break;
+                case 2: d->KnapSackProcessorMap(wgts, nprocs); break;
+                default: d->SFCProcessorMap(zba, wgts, nprocs);
+                }
+            }
+
+            const std::string what = "new map " + std::to_string(m);
+            tCheck::Require(!compressed.isCompressed() && same_map(compressed, fresh) && compressed == fresh,
+                            "tCompactLayout", what + " on a compressed map");
+            tCheck::Require(same_map(shared, fresh) && shared == fresh,
+                            "tCompactLayout", what + " on a shared map");
+        }
+
+        tCheck::Passed("tCompactLayout");
+    }
+    amrex::Finalize();
+}
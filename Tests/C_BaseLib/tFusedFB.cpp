@@ -0,0 +1,104 @@
+//
+// A test program for the FillBoundary of several FabArrays at once.  It
+// must give what FillBoundary of each of them gives, also for FabArrays
+// that differ from the first one and are therefore filled separately.
+//
+
+#include <memory>
+#include <string>
+
+#include <AMReX_Utility.H>
+#include <AMReX_MultiFab.H>
+
+#include "tCheck.H"
+
+using namespace amrex;
+
+namespace
+{
+    void fill (MultiFab& mf, int m)
+    {
+        mf.setVal(-1.0);
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.validbox();
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                for (int n = 0; n < mf.nComp(); ++n) {
+                    mf[mfi](iv,n) = D_TERM(iv[0], + 100*iv[1], + 10000*iv[2]) + 0.5*n + 1.e6*m;
+                }
+            }
+        }
+    }
+}
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv);
+    {
+        const int n_cell = 64;
+        const Box domain(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(n_cell-1,n_cell-1,n_cell-1)));
+        const Periodicity period(IntVect(D_DECL(n_cell,n_cell,n_cell)));
+
+        BoxArray ba(domain);
+        ba.maxSize(16);
+        DistributionMapping dm(ba);
+
+        BoxArray ba2(domain);
+        ba2.maxSize(32);
+        DistributionMapping dm2(ba2);
+        //
+        // Different numbers of components.  The fifth has fewer ghost cells
+        // and the last another BoxArray, so those are filled on their own.
+        //
+        const int N = 7;
+        Vector<std::unique_ptr<MultiFab> > mfs(N);
+        Vector<std::unique_ptr<MultiFab> > refs(N);
+        for (int m = 0; m < N; ++m)
+        {
+            const int ncomp = 1 + m%3;
+            const int ngrow = (m == 4) ? 1 : 2;
+            if (m == N-1) {
+                mfs[m].reset(new MultiFab(ba2, dm2, ncomp, ngrow));
+                refs[m].reset(new MultiFab(ba2, dm2, ncomp, ngrow));
+            } else {
+                mfs[m].reset(new MultiFab(ba, dm, ncomp, ngrow));
+                refs[m].reset(new MultiFab(ba, dm, ncomp, ngrow));
+            }
+        }
+
+        for (const Periodicity& per : {period, Periodicity::NonPeriodic()})
+        {
+            for (bool cross : {false, true})
+            {
+                //
+                // Twice, so that the cached FB is reused.
+                //
+                for (int iter = 0; iter < 2; ++iter)
+                {
+                    for (int m = 0; m < N; ++m)
+                    {
+                        fill(*mfs[m], m);
+                        fill(*refs[m], m);
+                        refs[m]->FillBoundary(per, cross);
+                    }
+
+                    amrex::FillBoundary(GetVecOfPtrs(mfs), per, cross);
+
+                    for (int m = 0; m < N; ++m)
+                    {
+                        MultiFab& ref = *refs[m];
+                        MultiFab::Subtract(ref, *mfs[m], 0, 0, ref.nComp(), ref.nGrow());
+                        for (int n = 0; n < ref.nComp(); ++n) {
+                            tCheck::Require(ref.norm0(n, ref.nGrow()) == 0.0, "tFusedFB",
+                                            "MultiFab " + std::to_string(m));
+                        }
+                    }
+                }
+            }
+        }
+
+        tCheck::Passed("tFusedFB");
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,126 @@
+//
+// A test program for the MultiFab expression templates.  Each assignment
+// must give, point by point, what the expression gives when it is
+// evaluated directly, on the requested components and cells only.
+//
+
+#include <cmath>
+
+#include <AMReX_Utility.H>
+#include <AMReX_MultiFab.H>
+
+#include "tCheck.H"
+
+using namespace amrex;
+
+namespace
+{
+    bool close_enough (Real v, Real expected)
+    {
+        return std::abs(v - expected) <= 1.e-14*std::abs(expected);
+    }
+}
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv);
+    {
+        const Box domain(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(63,63,63)));
+        BoxArray ba(domain);
+        ba.maxSize(32);
+        DistributionMapping dm(ba);
+
+        MultiFab a(ba, dm, 2, 1);
+        MultiFab b(ba, dm, 2, 1);
+        MultiFab c(ba, dm, 3, 1);
+        MultiFab d(ba, dm, 2, 1);
+        for (MFIter mfi(b); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.fabbox();
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+            {
+                for (int n = 0; n < 2; ++n) {
+                    b[mfi](iv,n) = iv[0] + n + 1;
+                    d[mfi](iv,n) = 0.5*iv[BL_SPACEDIM-1] - n;
+                }
+                for (int n = 0; n < 3; ++n) {
+                    c[mfi](iv,n) = 0.25*iv[0] + 2*n + 1;
+                }
+            }
+        }
+
+        const Real alpha = 2.5;
+        const Real beta  = 0.75;
+        //
+        // All components of the valid region, then one component including
+        // the ghost cells, and additions.  The ghost cells of component 0
+        // must keep their value.  Component 1 of a is computed from the
+        // first component of each term, which for c is its component 1.
+        //
+        a.setVal(-1.0);
+        a = b + alpha*c - beta*d;
+        MFExpr::Assign(a, -MFExpr::comp(c,1)*b/2.0 + 1.0, 1, 1, 1);
+        a += 3.0*d;
+        MFExpr::Add(a, b/(2.0 + c) - (-d), 0, 1, 0);
+
+        long nbad = 0;
+        for (MFIter mfi(a); mfi.isValid(); ++mfi)
+        {
+            const FArrayBox& fa = a[mfi];
+            const FArrayBox& fb = b[mfi];
+            const FArrayBox& fc = c[mfi];
+            const FArrayBox& fd = d[mfi];
+            const Box& bx = mfi.fabbox();
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+            {
+                const bool valid = mfi.validbox().contains(iv);
+                const Real e0 = valid
+                    ? fb(iv,0) + alpha*fc(iv,0) - beta*fd(iv,0) + 3.0*fd(iv,0)
+                      + (fb(iv,0)/(2.0 + fc(iv,0)) + fd(iv,0))
+                    : -1.0;
+                const Real e1 = -fc(iv,1)*fb(iv,0)/2.0 + 1.0 + (valid ? 3.0*fd(iv,1) : 0.0);
+                if (!close_enough(fa(iv,0), e0)) ++nbad;
+                if (!close_enough(fa(iv,1), e1)) ++nbad;
+            }
+        }
+        tCheck::Require(nbad == 0, "tMFExpr", "MultiFab expressions");
+        //
+        // The same as the MultiFab functions.
+        //
+        MultiFab r(ba, dm, 2, 0);
+        MultiFab::LinComb(r, 1.0, b, 0, alpha, c, 0, 0, 2, 0);
+        MultiFab::Saxpy(r, -beta, d, 0, 0, 2, 0);
+        a = b + alpha*c - beta*d;
+        MultiFab::Subtract(r, a, 0, 0, 2, 0);
+        tCheck::Require(r.norm0(0) <= 1.e-14*a.norm0(0) && r.norm0(1) <= 1.e-14*a.norm0(1),
+                        "tMFExpr", "LinComb and Saxpy");
+        //
+        // The destination may be in the expression.
+        //
+        MultiFab::Copy(a, b, 0, 0, 2, 0);
+        a = a*a - b;
+        MultiFab t(ba, dm, 2, 0);
+        MultiFab::Copy(t, b, 0, 0, 2, 0);
+        MultiFab::Multiply(t, b, 0, 0, 2, 0);
+        MultiFab::Subtract(t, b, 0, 0, 2, 0);
+        MultiFab::Subtract(t, a, 0, 0, 2, 0);
+        tCheck::Require(t.norm0(0) == 0.0 && t.norm0(1) == 0.0, "tMFExpr", "aliasing");
+        //
+        // FArrayBoxes only.
+        //
+        const Box fbx(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(3,3,3)));
+        FArrayBox f(fbx, 2);
+        FArrayBox g(fbx, 2);
+        f.setVal(0.0);
+        g.setVal(2.0, 0);
+        g.setVal(5.0, 1);
+        MFExpr::Assign(f, fbx, g*MFExpr::comp(g,1) - 1.0);
+        MFExpr::Add(f, fbx, 0.5/g, 1, 1);
+        tCheck::Require(f.min(0) == 9.0 && f.max(0) == 9.0 && f.min(1) == 0.25 && f.max(1) == 0.25,
+                        "tMFExpr", "FArrayBox expressions");
+
+        tCheck::Passed("tMFExpr");
+    }
+    amrex::Finalize();
+}
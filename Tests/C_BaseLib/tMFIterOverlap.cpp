@@ -0,0 +1,87 @@
+//
+// A test program for the overlap mode of MFIter.  A tile visited between
+// FillBoundary_nowait and FillBoundary_finish must already see its ghost
+// cells filled, every tile must be visited once, and the result after
+// FillBoundary_finish must be that of FillBoundary.
+//
+
+#include <AMReX_Utility.H>
+#include <AMReX_MultiFab.H>
+
+#include "tCheck.H"
+
+using namespace amrex;
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv);
+    {
+        const int n_cell = 64;
+        BoxArray ba(Box(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(n_cell-1,n_cell-1,n_cell-1))));
+        ba.maxSize(16);
+        DistributionMapping dm(ba);
+        const Periodicity period(IntVect(D_DECL(n_cell,n_cell,n_cell)));
+
+        const int ncomp = 2;
+        const int ngrow = 2;
+        MultiFab mf(ba, dm, ncomp, ngrow);
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.validbox();
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                for (int n = 0; n < ncomp; ++n) {
+                    mf[mfi](iv,n) = D_TERM(iv[0], + 100*iv[1], + 10000*iv[2]) + 0.5*n;
+                }
+            }
+        }
+
+        MultiFab ref(ba, dm, ncomp, ngrow);
+        MultiFab::Copy(ref, mf, 0, 0, ncomp, 0);
+        ref.setBndry(-1.0);
+        ref.FillBoundary(period);
+
+        const IntVect tilesize(D_DECL(8,8,8));
+        long ntiles = 0;
+        for (MFIter mfi(mf, tilesize); mfi.isValid(); ++mfi) {
+            ++ntiles;
+        }
+        //
+        // Several times, so that the cached FillBoundary is reused.
+        //
+        for (int iter = 0; iter < 3; ++iter)
+        {
+            mf.setBndry(-1.0);
+            mf.FillBoundary_nowait(period);
+
+            long nvisited = 0;
+            long nbad     = 0;
+#ifdef _OPENMP
+#pragma omp parallel reduction(+:nvisited,nbad)
+#endif
+            for (MFIter mfi(mf, MFItInfo().EnableTiling(tilesize).SetOverlap(true));
+                 mfi.isValid(); ++mfi)
+            {
+                ++nvisited;
+                const Box& bx = mfi.growntilebox();
+                for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                    for (int n = 0; n < ncomp; ++n) {
+                        if (mf[mfi](iv,n) != ref[mfi](iv,n)) ++nbad;
+                    }
+                }
+            }
+
+            mf.FillBoundary_finish();
+
+            tCheck::Require(nvisited == ntiles, "tMFIterOverlap", "visiting every tile once");
+            tCheck::Require(nbad == 0, "tMFIterOverlap", "ghost cells in the loop");
+        }
+
+        MultiFab::Subtract(ref, mf, 0, 0, ncomp, ngrow);
+        tCheck::Require(ref.norm0(0, ngrow) == 0.0 && ref.norm0(1, ngrow) == 0.0,
+                        "tMFIterOverlap", "FillBoundary_finish");
+
+        tCheck::Passed("tMFIterOverlap");
+    }
+    amrex::Finalize();
+}
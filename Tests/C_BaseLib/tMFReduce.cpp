@@ -0,0 +1,99 @@
+//
+// A test program for MultiFabReduce.  The fused reductions must agree
+// with the ones of MultiFab.  Run it on several processes.
+//
+
+#include <cmath>
+#include <string>
+
+#include <AMReX_Utility.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_MultiFabReduce.H>
+
+#include "tCheck.H"
+
+using namespace amrex;
+
+static
+void
+check (const char* what, Real fused, Real expected)
+{
+    const Real tol = 1.e-12 * std::max(Real(1.0), std::abs(expected));
+    tCheck::Require(std::abs(fused - expected) <= tol, "tMFReduce",
+                    std::string(what) + " = " + std::to_string(fused) + ", expected "
+                    + std::to_string(expected) + ",");
+}
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv);
+    {
+        BoxArray ba(Box(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(63,63,63))));
+        ba.maxSize(16);
+        DistributionMapping dm(ba);
+
+        const int ncomp = 2;
+        const int ngrow = 1;
+        MultiFab x(ba, dm, ncomp, ngrow);
+        MultiFab y(ba, dm, ncomp, ngrow);
+        //
+        // Values of both signs, different on every process and in the ghost cells.
+        //
+        for (MFIter mfi(x); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.fabbox();
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+            {
+                for (int n = 0; n < ncomp; ++n)
+                {
+                    Real v = 0.0;
+                    for (int d = 0; d < BL_SPACEDIM; ++d) {
+                        v += std::sin(0.1*(d+1)*iv[d] + n);
+                    }
+                    x[mfi](iv,n) = v;
+                    y[mfi](iv,n) = std::cos(v) - 0.25*n;
+                }
+            }
+        }
+
+        MultiFabReduce r;
+        const int i_norm0  = r.norm0(x, 0);
+        const int i_norm0g = r.norm0(x, 1, ngrow);
+        const int i_norm1  = r.norm1(y, 0);
+        const int i_norm2  = r.norm2(x, 1);
+        const int i_sum    = r.sum(y, 1);
+        const int i_min    = r.min(x, 0);
+        const int i_ming   = r.min(y, 1, ngrow);
+        const int i_max    = r.max(y, 0);
+        const int i_maxg   = r.max(x, 1, ngrow);
+        const int i_dot    = r.dot(x, 0, y, 0, ncomp);
+        r.eval();
+
+        check("norm0",  r[i_norm0],  x.norm0(0));
+        check("norm0g", r[i_norm0g], x.norm0(1, ngrow));
+        check("norm1",  r[i_norm1],  y.norm1(0));
+        check("norm2",  r[i_norm2],  x.norm2(1));
+        check("sum",    r[i_sum],    y.sum(1));
+        check("min",    r[i_min],    x.min(0));
+        check("ming",   r[i_ming],   y.min(1, ngrow));
+        check("max",    r[i_max],    y.max(0));
+        check("maxg",   r[i_maxg],   x.max(1, ngrow));
+        check("dot",    r[i_dot],    MultiFab::Dot(x, 0, y, 0, ncomp, 0));
+        //
+        // Only maxima, and only sums.
+        //
+        MultiFabReduce rmax;
+        const int j_max = rmax.max(x, 0);
+        rmax.eval();
+        check("max only", rmax[j_max], x.max(0));
+
+        MultiFabReduce rsum;
+        const int j_sum = rsum.sum(x, 0);
+        rsum.eval();
+        check("sum only", rsum[j_sum], x.sum(0));
+
+        tCheck::Passed("tMFReduce");
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,90 @@
+//
+// A test program for fabarray.numa_first_touch.  Every page of the fabs
+// of a new FabArray must be in memory, that is placed on some NUMA node,
+// before anything is written to it, and the FabArray must work as usual.
+//
+
+#include <AMReX_Utility.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_iMultiFab.H>
+
+#include "tCheck.H"
+
+using namespace amrex;
+
+namespace
+{
+    //
+    // The page queries are protected, as they are normally only used by
+    // the library.
+    //
+    struct NUMAPages
+        : public FabArrayBase
+    {
+        static bool supported () { return NUMANode() >= 0; }
+
+        //
+        // The number of pages of the local fabs that are not in memory.
+        //
+        template <class FAB>
+        static long absent (const FabArray<FAB>& fa)
+        {
+            long nabsent = 0;
+            for (MFIter mfi(fa); mfi.isValid(); ++mfi)
+            {
+                const FAB& fab = fa[mfi];
+                const char* begin = reinterpret_cast<const char*>(fab.dataPtr());
+                const char* end   = reinterpret_cast<const char*>(fab.dataPtr() + fab.size());
+                Vector<char*> pages;
+                NUMAPagesIn(begin, end, pages);
+                Vector<int> nodes;
+                NUMAQueryPages(pages, nodes);
+                for (int nd : nodes) {
+                    if (nd < 0) ++nabsent;
+                }
+            }
+            return nabsent;
+        }
+    };
+}
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv);
+    {
+        FabArrayBase::numa_first_touch = true;
+
+        const Box domain(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(127,127,127)));
+        BoxArray ba(domain);
+        ba.maxSize(64);
+        DistributionMapping dm(ba);
+        //
+        // Several sizes, so that both fresh memory and memory the arena
+        // hands out again are placed.
+        //
+        for (int ncomp : {3, 1, 5})
+        {
+            MultiFab mf(ba, dm, ncomp, 2);
+            iMultiFab imf(ba, dm, 1, 1);
+
+            if (NUMAPages::supported()) {
+                tCheck::Require(NUMAPages::absent(mf) == 0, "tNUMAFirstTouch", "placing a MultiFab");
+                tCheck::Require(NUMAPages::absent(imf) == 0, "tNUMAFirstTouch", "placing an iMultiFab");
+            }
+
+            mf.setVal(1.0);
+            imf.setVal(2);
+            mf.FillBoundary();
+            tCheck::Require(mf.sum(ncomp-1) == domain.numPts(), "tNUMAFirstTouch", "MultiFab sum");
+            tCheck::Require(imf.min(0) == 2 && imf.max(0) == 2, "tNUMAFirstTouch", "iMultiFab values");
+
+            mf.NUMAReport("mf");
+        }
+
+        FabArrayBase::numa_first_touch = false;
+
+        tCheck::Passed("tNUMAFirstTouch");
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,189 @@
+//
+// A test program for NodeShared and the BoxArrays and DistributionMappings
+// kept in it.  Memory released by some processes of the node only must
+// stay there through Collect, two BoxArrays shared at once must keep
+// their own boxes, and changing a copy must not change the shared one.
+//
+
+#include <memory>
+#include <string>
+
+#include <AMReX_Utility.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_NodeShared.H>
+#include <AMReX_ParmParse.H>
+
+#include "tCheck.H"
+
+using namespace amrex;
+
+namespace
+{
+    const int n_cell = 64;
+
+    bool same_boxes (const BoxArray& a, const BoxArray& b)
+    {
+        if (a.size() != b.size()) return false;
+        for (int i = 0; i < a.size(); ++i) {
+            if (a[i] != b[i]) return false;
+        }
+        return true;
+    }
+
+    bool check_ints (const char* p, int n, int offset)
+    {
+        const int* q = reinterpret_cast<const int*>(p);
+        for (int i = 0; i < n; ++i) {
+            if (q[i] != i + offset) return false;
+        }
+        return true;
+    }
+
+    void check_fill (const BoxArray& ba, const DistributionMapping& dm, const std::string& what)
+    {
+        const Periodicity period(IntVect(D_DECL(n_cell,n_cell,n_cell)));
+        MultiFab mf(ba, dm, 1, 1);
+        mf.setVal(1.0);
+        mf.setBndry(-1.0);
+        mf.FillBoundary(period);
+        tCheck::Require(mf.min(0, 1) == 1.0, "tNodeShared", what);
+    }
+}
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv, true, MPI_COMM_WORLD, [] () {
+        ParmParse pp("boxarray");
+        pp.add("node_shared", 1);
+    });
+    {
+        const int myproc = ParallelDescriptor::MyProc();
+        const bool enabled = NodeShared::Enabled();
+#if defined(BL_USE_MPI) && (MPI_VERSION >= 3)
+        int node_size;
+        MPI_Comm_size(ParallelDescriptor::NodeCommunicator(), &node_size);
+        tCheck::Require(enabled == (node_size > 1), "tNodeShared", "Enabled");
+#endif
+        //
+        // Memory released at different times by the processes of the
+        // node must still be readable by those that have not released it.
+        //
+        if (enabled)
+        {
+            const int n = 1000;
+            const int nwin = 4;
+            int ids[nwin];
+            char* ptrs[nwin];
+            for (int w = 0; w < nwin; ++w)
+            {
+                ptrs[w] = NodeShared::Share(n*sizeof(int),
+                                            [=] (char* dst) {
+                                                int* q = reinterpret_cast<int*>(dst);
+                                                for (int i = 0; i < n; ++i) q[i] = i + 1000*w;
+                                            },
+                                            [] () {},
+                                            ids[w]);
+            }
+
+            const int r = NodeShared::Rank();
+            for (int step = 0; step < nwin; ++step)
+            {
+                //
+                // Each process releases one window per step, a different
+                // one on each, and reads the others after the Collect.
+                //
+                const int w = (r + step) % nwin;
+                NodeShared::Release(ids[w]);
+                ptrs[w] = nullptr;
+                NodeShared::Collect();
+
+                bool ok = true;
+                for (int k = 0; k < nwin; ++k) {
+                    if (ptrs[k]) ok = ok && check_ints(ptrs[k], n, 1000*k);
+                }
+                tCheck::Require(ok, "tNodeShared", "memory kept until all release it");
+            }
+            //
+            // And new memory after all of that.
+            //
+            int id;
+            char* p = NodeShared::Share(n*sizeof(int),
+                                        [=] (char* dst) {
+                                            int* q = reinterpret_cast<int*>(dst);
+                                            for (int i = 0; i < n; ++i) q[i] = i + 7;
+                                        },
+                                        [] () {}, id);
+            tCheck::Require(check_ints(p, n, 7), "tNodeShared", "memory shared after Collect");
+            NodeShared::Release(id);
+            NodeShared::Collect();
+        }
+        //
+        // Two BoxArrays and their maps shared at once.  The first is
+        // destroyed before or after the second depending on the process.
+        //
+        const Box domain(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(n_cell-1,n_cell-1,n_cell-1)));
+        BoxList bl1(domain);
+        bl1.maxSize(16);
+        BoxList bl2(domain);
+        bl2.maxSize(IntVect(D_DECL(32,16,8)));
+        const BoxArray ref1(bl1);
+        const BoxArray ref2(bl2);
+
+        for (int iter = 0; iter < 3; ++iter)
+        {
+            std::unique_ptr<BoxArray> ba1(new BoxArray(bl1));
+            std::unique_ptr<BoxArray> ba2(new BoxArray(bl2));
+            std::unique_ptr<DistributionMapping> dm1(new DistributionMapping(*ba1));
+            std::unique_ptr<DistributionMapping> dm2(new DistributionMapping(*ba2));
+            const Vector<int> pmap1 = dm1->ProcessorMap();
+            const Vector<int> pmap2 = dm2->ProcessorMap();
+
+            ba1->ShareOnNode();
+            dm1->ShareOnNode();
+            ba2->ShareOnNode();
+            dm2->ShareOnNode();
+
+            tCheck::Require(same_boxes(*ba1, ref1) && same_boxes(*ba2, ref2), "tNodeShared",
+                            "shared boxes");
+            tCheck::Require(*dm1 == DistributionMapping(pmap1) && *dm2 == DistributionMapping(pmap2),
+                            "tNodeShared", "shared maps");
+            check_fill(*ba1, *dm1, "FillBoundary on the first BoxArray");
+            check_fill(*ba2, *dm2, "FillBoundary on the second BoxArray");
+            //
+            // A copy made unique and changed gets its own boxes.
+            //
+            BoxArray copy = *ba2;
+            copy.uniqify();
+            copy.set(0, amrex::grow((*ba2)[0], -1));
+            tCheck::Require(same_boxes(*ba2, ref2) && copy[0] != ref2[0], "tNodeShared",
+                            "changing a copy");
+
+            //
+            // Released in a different order on each process, so that each
+            // Collect finds memory that some processes still use.
+            //
+            if ((myproc + iter) % 2 == 0) {
+                dm1.reset();
+                ba1.reset();
+                NodeShared::Collect();
+                tCheck::Require(same_boxes(*ba2, ref2) && *dm2 == DistributionMapping(pmap2),
+                                "tNodeShared", "the second after the first");
+            } else {
+                dm2.reset();
+                ba2.reset();
+                NodeShared::Collect();
+                tCheck::Require(same_boxes(*ba1, ref1) && *dm1 == DistributionMapping(pmap1),
+                                "tNodeShared", "the first after the second");
+            }
+            dm1.reset();
+            ba1.reset();
+            dm2.reset();
+            ba2.reset();
+            NodeShared::Collect();
+        }
+
+        tCheck::Passed("tNodeShared");
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,147 @@
+//
+// A test program for fabarray.node_shmem.  FillBoundary and ParallelCopy
+// of FabArrays in the shared memory windows of the node must give the
+// same data as without them, and FabArrays may be moved and destroyed in
+// a different order on each process.
+//
+
+#include <memory>
+
+#include <AMReX_Utility.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_iMultiFab.H>
+#include <AMReX_ParmParse.H>
+
+#include "tCheck.H"
+
+using namespace amrex;
+
+namespace
+{
+    const int n_cell = 64;
+
+    //
+    // The value of component n at iv, and at its periodic image.
+    //
+    long value (IntVect iv, int n)
+    {
+        for (int d = 0; d < BL_SPACEDIM; ++d) {
+            iv[d] = (iv[d] + n_cell) % n_cell;
+        }
+        return D_TERM(iv[0], + 100*iv[1], + 10000*iv[2]) + 1000000L*n;
+    }
+
+    template <class FAB>
+    void fill_valid (FabArray<FAB>& fa)
+    {
+        for (MFIter mfi(fa); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.validbox();
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                for (int n = 0; n < fa.nComp(); ++n) {
+                    fa[mfi](iv,n) = value(iv,n);
+                }
+            }
+        }
+    }
+
+    //
+    // Checks the data of fa in bx grown by ng, times factor.
+    //
+    template <class FAB>
+    void check (const FabArray<FAB>& fa, int ng, int factor, const std::string& what)
+    {
+        long nbad = 0;
+        for (MFIter mfi(fa); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = amrex::grow(mfi.validbox(), ng);
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                for (int n = 0; n < fa.nComp(); ++n) {
+                    if (fa[mfi](iv,n) != factor*value(iv,n)) ++nbad;
+                }
+            }
+        }
+        tCheck::Require(nbad == 0, "tNodeShmem", what);
+    }
+}
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv, true, MPI_COMM_WORLD, [] () {
+        ParmParse pp("fabarray");
+        pp.add("node_shmem", 1);
+    });
+    {
+        const Box domain(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(n_cell-1,n_cell-1,n_cell-1)));
+        const Periodicity period(IntVect(D_DECL(n_cell,n_cell,n_cell)));
+
+        BoxArray ba(domain);
+        ba.maxSize(16);
+        DistributionMapping dm(ba);
+
+        BoxArray ba2(domain);
+        ba2.maxSize(32);
+        DistributionMapping dm2(ba2);
+
+        MultiFab a(ba, dm, 3, 2);
+        iMultiFab ia(ba, dm, 1, 1);
+        fill_valid(a);
+        fill_valid(ia);
+        //
+        // Repeated, so that the cached communication is reused.
+        //
+        for (int iter = 0; iter < 3; ++iter)
+        {
+            a.setBndry(-1.0);
+            ia.setBndry(-1);
+
+            a.FillBoundary(1, 1, period);
+            a.FillBoundary_nowait(period);
+            a.FillBoundary_finish();
+            ia.FillBoundary(period);
+            check(a, 2, 1, "MultiFab FillBoundary");
+            check(ia, 1, 1, "iMultiFab FillBoundary");
+
+            MultiFab b(ba2, dm2, 3, 0);
+            b.setVal(0.0);
+            b.ParallelCopy(a, 0, 0, 3);
+            b.ParallelCopy(a, 0, 0, 3, 0, 0, Periodicity::NonPeriodic(), FabArrayBase::ADD);
+            check(b, 0, 2, "ParallelCopy");
+        }
+        //
+        // Into ghost cells, across the periodic boundary, and after a move.
+        //
+        {
+            MultiFab c(ba2, dm2, 3, 1);
+            c.setVal(-5.0);
+            c.ParallelCopy(a, 0, 0, 3, 0, 1, period);
+            check(c, 1, 1, "ParallelCopy to ghost cells");
+
+            MultiFab d(std::move(c));
+            d.setBndry(-5.0);
+            d.FillBoundary(period);
+            check(d, 1, 1, "FillBoundary after a move");
+        }
+        //
+        // FabArrays destroyed in an order that depends on the process.
+        //
+        Vector<std::unique_ptr<MultiFab> > mfs;
+        for (int iter = 0; iter < 12; ++iter)
+        {
+            mfs.emplace_back(new MultiFab(ba, dm, 1 + iter%3, 1));
+            MultiFab& mf = *mfs.back();
+            fill_valid(mf);
+            mf.FillBoundary(period);
+            check(mf, 1, 1, "FillBoundary of a new MultiFab");
+
+            if (mfs.size() > 3) {
+                const int k = (ParallelDescriptor::MyProc() + iter) % mfs.size();
+                mfs.erase(mfs.begin() + k);
+            }
+        }
+
+        tCheck::Passed("tNodeShmem");
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,153 @@
+//
+// A test program for PArena.  Threads allocate blocks of many sizes and
+// free those of other threads, and short-lived threads allocate and exit.
+// The blocks must be aligned and keep their contents, and the memory of
+// freed blocks and of exited threads must be reused.
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <AMReX_PArena.H>
+
+#include "tCheck.H"
+
+using namespace amrex;
+
+namespace
+{
+    //
+    // Mostly small blocks, some up to the largest size class, and a few
+    // that bypass the pool.
+    //
+    std::size_t block_size (std::mt19937& gen)
+    {
+        const unsigned r = gen() % 500;
+        if (r == 0) {
+            return gen() % (3*PArena::MaxClassSize/2);
+        } else if (r < 50) {
+            return gen() % (PArena::MaxClassSize/8);
+        } else {
+            return gen() % 4096;
+        }
+    }
+
+    bool aligned (const void* p)
+    {
+        const std::size_t addr = reinterpret_cast<std::uintptr_t>(p);
+        return Arena::align(addr) == addr;
+    }
+
+    //
+    // A thread that allocates n blocks, frees them if asked to, and exits.
+    //
+    void short_lived (PArena& arena, int n, bool release, std::vector<void*>& blocks)
+    {
+        std::thread t([&arena, n, release, &blocks] () {
+            for (int i = 0; i < n; ++i) {
+                blocks.push_back(arena.alloc(64 + 64*(i%32)));
+            }
+            if (release) {
+                for (void* p : blocks) arena.free(p);
+                blocks.clear();
+            }
+        });
+        t.join();
+    }
+}
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv);
+    {
+        PArena arena;
+
+#ifdef _OPENMP
+        const int nthreads = std::max(omp_get_max_threads(), 2);
+#else
+        const int nthreads = 1;
+#endif
+        const int nblocks = 2000;
+        std::vector<void*>       ptrs(nthreads*nblocks, nullptr);
+        std::vector<std::size_t> sizes(nthreads*nblocks, 0);
+        //
+        // The same requests every time, so the pool must stop growing.
+        //
+        std::size_t used_first = 0;
+        for (int iter = 0; iter < 4; ++iter)
+        {
+            long nbad = 0;
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads) reduction(+:nbad)
+#endif
+            {
+#ifdef _OPENMP
+                const int tid = omp_get_thread_num();
+#else
+                const int tid = 0;
+#endif
+                std::mt19937 gen(tid);
+                for (int i = tid*nblocks; i < (tid+1)*nblocks; ++i)
+                {
+                    sizes[i] = block_size(gen);
+                    ptrs[i]  = arena.alloc(sizes[i]);
+                    if (!aligned(ptrs[i])) ++nbad;
+                    std::memset(ptrs[i], i & 0xff, sizes[i]);
+                }
+#ifdef _OPENMP
+#pragma omp barrier
+#endif
+                //
+                // Free the blocks of the next thread.
+                //
+                const int other = (tid+1) % nthreads;
+                for (int i = other*nblocks; i < (other+1)*nblocks; ++i)
+                {
+                    const unsigned char* p = static_cast<const unsigned char*>(ptrs[i]);
+                    for (std::size_t k = 0; k < sizes[i]; k += 97) {
+                        if (p[k] != (i & 0xff)) { ++nbad; break; }
+                    }
+                    arena.free(ptrs[i]);
+                }
+            }
+            tCheck::Require(nbad == 0, "tPArena", "alignment and contents");
+
+            if (iter == 1) {
+                used_first = arena.heap_space_used();
+            } else if (iter > 1) {
+                tCheck::Require(arena.heap_space_used() <= used_first, "tPArena", "reusing freed blocks");
+            }
+        }
+        //
+        // A thread that exits hands its cache to the next new thread, also
+        // with blocks that are still in use and freed by another thread.
+        //
+        std::vector<void*> blocks;
+        short_lived(arena, 1000, true, blocks);
+        const std::size_t used_threads = arena.heap_space_used();
+        for (int i = 0; i < 20; ++i) {
+            short_lived(arena, 1000, true, blocks);
+        }
+        tCheck::Require(arena.heap_space_used() == used_threads, "tPArena", "adopting caches");
+
+        short_lived(arena, 1000, false, blocks);
+        for (void* p : blocks) arena.free(p);
+        blocks.clear();
+        for (int i = 0; i < 20; ++i) {
+            short_lived(arena, 1000, true, blocks);
+        }
+        tCheck::Require(arena.heap_space_used() == used_threads, "tPArena", "freeing after exit");
+
+        tCheck::Passed("tPArena");
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,141 @@
+//
+// A test program for DistributionMapping::makeRebalanced and the costs
+// collected by MFIter.  A badly balanced map must be replaced by one with
+// the reported, better efficiency that moves no more than
+// DistributionMapping.rebalance_max_move of the cells, and a well
+// balanced one must be kept.
+//
+
+#include <algorithm>
+#include <cmath>
+
+#include <AMReX_Utility.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_LayoutData.H>
+#include <AMReX_ParmParse.H>
+
+#include "tCheck.H"
+
+using namespace amrex;
+
+namespace
+{
+    const Real max_move = 0.25;
+
+    Vector<Real> global_costs (const LayoutData<Real>& cost)
+    {
+        Vector<Real> rcost(cost.size(), 0.0);
+        for (MFIter mfi(cost); mfi.isValid(); ++mfi) {
+            rcost[mfi.index()] = cost[mfi];
+        }
+        ParallelDescriptor::ReduceRealSum(rcost.data(), rcost.size());
+        return rcost;
+    }
+
+    Real efficiency (const Vector<Real>& rcost, const DistributionMapping& dm)
+    {
+        Vector<Real> load(ParallelDescriptor::NProcs(), 0.0);
+        for (int i = 0; i < rcost.size(); ++i) {
+            load[dm[i]] += rcost[i];
+        }
+        Real sum = 0.0;
+        for (Real l : load) sum += l;
+        const Real mx = *std::max_element(load.begin(), load.end());
+        return (mx > 0.0) ? sum/(load.size()*mx) : 1.0;
+    }
+}
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv, true, MPI_COMM_WORLD, [] () {
+        ParmParse pp("DistributionMapping");
+        pp.add("rebalance_max_move", max_move);
+    });
+    {
+        const Box domain(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(63,63,63)));
+        BoxArray ba(domain);
+        ba.maxSize(16);
+        DistributionMapping dm(ba);
+        const int N = ba.size();
+        //
+        // Measured costs cover at least the time spent in the loop body.
+        //
+        MultiFab mf(ba, dm, 1, 0);
+        LayoutData<Real> cost(ba, dm);
+        for (MFIter mfi(cost); mfi.isValid(); ++mfi) {
+            cost[mfi] = 0.0;
+        }
+
+        const Real wait = 1.e-4;
+        LayoutData<int> ntiles(ba, dm);
+        for (MFIter mfi(ntiles); mfi.isValid(); ++mfi) {
+            ntiles[mfi] = 0;
+        }
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        for (MFIter mfi(mf, MFItInfo().EnableTiling().SetCost(&cost)); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.tilebox();
+            const Real t0 = ParallelDescriptor::second();
+            while (ParallelDescriptor::second() - t0 < wait) {}
+            mf[mfi].setVal(Real(mfi.index()), bx);
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+            ++ntiles[mfi];
+        }
+        for (MFIter mfi(cost); mfi.isValid(); ++mfi) {
+            tCheck::Require(cost[mfi] >= ntiles[mfi]*wait, "tRebalance", "measured cost");
+        }
+        //
+        // Equal costs are already balanced as well as the boxes allow.
+        //
+        for (MFIter mfi(cost); mfi.isValid(); ++mfi) {
+            cost[mfi] = 1.0;
+        }
+        Real old_eff, new_eff;
+        DistributionMapping same = DistributionMapping::makeRebalanced(cost, &old_eff, &new_eff);
+        if (old_eff >= 0.9) {
+            tCheck::Require(same == dm && new_eff == old_eff, "tRebalance", "keeping a balanced map");
+        }
+        //
+        // Much heavier boxes on process 0.
+        //
+        for (MFIter mfi(cost); mfi.isValid(); ++mfi) {
+            cost[mfi] = (dm[mfi.index()] == 0) ? 10.0 : 1.0;
+        }
+        const Vector<Real> rcost = global_costs(cost);
+
+        DistributionMapping newdm = DistributionMapping::makeRebalanced(cost, &old_eff, &new_eff);
+
+        tCheck::Require(std::abs(old_eff - efficiency(rcost, dm)) < 1.e-12,
+                        "tRebalance", "old efficiency");
+        tCheck::Require(std::abs(new_eff - efficiency(rcost, newdm)) < 1.e-12,
+                        "tRebalance", "new efficiency");
+        if (ParallelDescriptor::NProcs() > 1) {
+            tCheck::Require(new_eff > old_eff, "tRebalance", "improving the balance");
+        } else {
+            tCheck::Require(newdm == dm, "tRebalance", "keeping the map on one process");
+        }
+
+        long moved = 0;
+        for (int i = 0; i < N; ++i) {
+            if (newdm[i] != dm[i]) moved += ba[i].numPts();
+        }
+        tCheck::Require(moved <= max_move*domain.numPts(), "tRebalance", "limiting the moves");
+        //
+        // The data moves with the boxes.
+        //
+        MultiFab mf2(ba, newdm, 1, 0);
+        mf2.ParallelCopy(mf);
+        for (MFIter mfi(mf2); mfi.isValid(); ++mfi) {
+            tCheck::Require(mf2[mfi].min() == mfi.index() && mf2[mfi].max() == mfi.index(),
+                            "tRebalance", "moving the data");
+        }
+
+        tCheck::Passed("tRebalance");
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,145 @@
+//
+// A test program for MFIter::scratchFab in nested MFIter loops.  The
+// scratch fabs of an outer loop must keep their data through inner loops
+// that get their own, also when a loop is left early, and the memory must
+// be given back when the loops end.
+//
+
+#include <AMReX_Utility.H>
+#include <AMReX_MultiFab.H>
+
+#include "tCheck.H"
+
+using namespace amrex;
+
+namespace
+{
+    Real value (const IntVect& iv, int n)
+    {
+        return D_TERM(iv[0], + 100*iv[1], + 10000*iv[2]) + 0.5*n;
+    }
+
+    bool disjoint (const FArrayBox& a, const FArrayBox& b)
+    {
+        const char* alo = reinterpret_cast<const char*>(a.dataPtr());
+        const char* blo = reinterpret_cast<const char*>(b.dataPtr());
+        const char* ahi = alo + a.nBytes();
+        const char* bhi = blo + b.nBytes();
+        return ahi <= blo || bhi <= alo;
+    }
+
+    bool has_values (const FArrayBox& fab)
+    {
+        const Box& bx = fab.box();
+        for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+            for (int n = 0; n < fab.nComp(); ++n) {
+                if (fab(iv,n) != value(iv,n)) return false;
+            }
+        }
+        return true;
+    }
+
+    void set_values (FArrayBox& fab)
+    {
+        const Box& bx = fab.box();
+        for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+            for (int n = 0; n < fab.nComp(); ++n) {
+                fab(iv,n) = value(iv,n);
+            }
+        }
+    }
+}
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv);
+    {
+        const Box domain(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(63,63,63)));
+        BoxArray ba(domain);
+        ba.maxSize(32);
+        DistributionMapping dm(ba);
+
+        BoxArray ba2(domain);
+        ba2.maxSize(16);
+        DistributionMapping dm2(ba2);
+
+        MultiFab mf(ba, dm, 2, 0);
+        MultiFab other(ba2, dm2, 1, 0);
+        //
+        // An outer loop over tiles, and in it inner loops with scratch fabs
+        // large enough to need new chunks, one of them left early.
+        //
+        long nbad = 0;
+#ifdef _OPENMP
+#pragma omp parallel reduction(+:nbad)
+#endif
+        for (MFIter mfi(mf, true); mfi.isValid(); ++mfi)
+        {
+            const Box& tbx = mfi.tilebox();
+            FArrayBox& a = mfi.scratchFab(amrex::grow(tbx,1), 2);
+            set_values(a);
+
+            for (int pass = 0; pass < 2; ++pass)
+            {
+                int n = 0;
+                for (MFIter mfi2(other); mfi2.isValid(); ++mfi2)
+                {
+                    FArrayBox& b = mfi2.scratchFab(amrex::grow(mfi2.validbox(), 8*pass), 2);
+                    FArrayBox& c = mfi2.scratchFab(mfi2.validbox());
+                    b.setVal(-1.0);
+                    c.setVal(-2.0);
+                    if (!disjoint(a, b) || !disjoint(a, c) || !disjoint(b, c)) ++nbad;
+                    if (pass == 1 && ++n == 2) break;
+                }
+            }
+
+            FArrayBox& d = mfi.scratchFab(tbx, 2);
+            d.setVal(-3.0);
+            if (!disjoint(a, d) || !has_values(a)) ++nbad;
+
+            mf[mfi].copy(a, tbx);
+        }
+        tCheck::Require(nbad == 0, "tScratchFab", "scratch fabs of nested loops");
+
+        nbad = 0;
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            if (!has_values(mf[mfi])) ++nbad;
+        }
+        tCheck::Require(nbad == 0, "tScratchFab", "results of the outer loop");
+        //
+        // A loop left early with live scratch fabs, and an inner one left
+        // early in the same tile, give the memory back: the next loop gets
+        // the same address again.
+        //
+        {
+            const Real* p0 = nullptr;
+            for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+                p0 = mfi.scratchFab(mfi.validbox()).dataPtr();
+                break;
+            }
+
+            for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+            {
+                FArrayBox& a = mfi.scratchFab(mfi.validbox(), 2);
+                set_values(a);
+                for (MFIter mfi2(other); mfi2.isValid(); ++mfi2) {
+                    mfi2.scratchFab(mfi2.validbox()).setVal(-1.0);
+                    break;
+                }
+                tCheck::Require(has_values(a), "tScratchFab", "leaving an inner loop early");
+                break;
+            }
+
+            const Real* p1 = nullptr;
+            for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+                p1 = mfi.scratchFab(mfi.validbox()).dataPtr();
+                break;
+            }
+            tCheck::Require(p0 == nullptr || p1 == p0, "tScratchFab", "memory given back");
+        }
+
+        tCheck::Passed("tScratchFab");
+    }
+    amrex::Finalize();
+}
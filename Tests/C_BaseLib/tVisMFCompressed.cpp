@@ -0,0 +1,128 @@
+//
+// A test program for the Compressed_v1 format of VisMF.  Without a
+// tolerance the data must come back bit for bit, and with one each value
+// must be within the tolerance relative to the original.  Both are read
+// back with Read and, one component at a time, with readFAB, and the min
+// and max in the header must be those of the data written.
+//
+
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include <AMReX_Utility.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_VisMF.H>
+#include <AMReX_AsyncOut.H>
+
+#include "tCheck.H"
+
+using namespace amrex;
+
+namespace
+{
+    bool close_enough (Real v, Real expected, Real tol)
+    {
+        if (tol == 0.0) {
+            return std::memcmp(&v, &expected, sizeof(Real)) == 0;
+        } else {
+            return std::abs(v - expected) <= tol * std::abs(expected);
+        }
+    }
+
+    void check (const MultiFab& mf, const std::string& name, Real tol)
+    {
+        MultiFab rd(mf.boxArray(), mf.DistributionMap(), mf.nComp(), mf.nGrow());
+        VisMF::Read(rd, name);
+
+        VisMF vmf(name);
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            const FArrayBox& orig = mf[mfi];
+            const Box& bx = orig.box();
+            for (int n = 0; n < mf.nComp(); ++n)
+            {
+                std::unique_ptr<FArrayBox> comp(vmf.readFAB(mfi.index(), n));
+                tCheck::Require(comp->box() == bx && comp->nComp() == 1, "tVisMFCompressed",
+                                name + " readFAB box");
+
+                long nbad = 0;
+                for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+                {
+                    if (!close_enough(rd[mfi](iv,n), orig(iv,n), tol)) ++nbad;
+                    if ((*comp)(iv,0) != rd[mfi](iv,n)) ++nbad;
+                }
+                tCheck::Require(nbad == 0, "tVisMFCompressed", name + " Read and readFAB");
+
+                const Box& vbx = mfi.validbox();
+                tCheck::Require(vmf.min(mfi.index(), n) == rd[mfi].min(vbx, n) &&
+                                vmf.max(mfi.index(), n) == rd[mfi].max(vbx, n),
+                                "tVisMFCompressed", name + " min and max");
+            }
+        }
+    }
+}
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv);
+    {
+        BoxArray ba(Box(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(47,47,47))));
+        ba.maxSize(16);
+        DistributionMapping dm(ba);
+
+        const int ncomp = 3;
+        const int ngrow = 1;
+        MultiFab mf(ba, dm, ncomp, ngrow);
+        //
+        // Values of both signs and of very different sizes, including in
+        // the ghost cells, which are written too.
+        //
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.fabbox();
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv))
+            {
+                Real v = 1.5;
+                for (int d = 0; d < BL_SPACEDIM; ++d) {
+                    v += std::sin(0.3*(d+1)*iv[d]);
+                }
+                mf[mfi](iv,0) = v;
+                mf[mfi](iv,1) = -1.e-8 * v;
+                mf[mfi](iv,2) = 1.e6 * v * v + 0.5;
+            }
+        }
+
+        const std::string dir("tVisMFCompressed_dir");
+        amrex::UtilCreateCleanDirectory(dir, true);
+
+        VisMF::SetHeaderVersion(VisMF::Header::Compressed_v1);
+        FArrayBox::setFormat(FABio::FAB_NATIVE);
+        //
+        // Blocks much smaller than the fabs, and one block per component.
+        //
+        int k = 0;
+        for (Real t : {0.0, 1.e-3, 1.e-6})
+        {
+            for (long blocksize : {long(4096), long(1) << 20})
+            {
+                VisMF::SetCompressionTol(t);
+                VisMF::SetCompressionBlockSize(blocksize);
+
+                const std::string name = dir + "/mf" + std::to_string(k++);
+                VisMF::Write(mf, name);
+                check(mf, name, t);
+
+                const std::string aname = dir + "/amf" + std::to_string(k++);
+                VisMF::AsyncWrite(mf, aname);
+                AsyncOut::Finish();
+                check(mf, aname, t);
+            }
+        }
+
+        tCheck::Passed("tVisMFCompressed");
+    }
+    amrex::Finalize();
+}
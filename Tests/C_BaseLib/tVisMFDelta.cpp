@@ -0,0 +1,104 @@
+//
+// A test program for the delta writes of VisMF.  A full write is followed
+// by two deltas.  The last one must read back as the data, and again
+// after it is folded and the two before it are removed.
+//
+
+#include <fstream>
+#include <string>
+
+#include <AMReX_Utility.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_VisMF.H>
+#include <AMReX_NFiles.H>
+
+#include "tCheck.H"
+
+using namespace amrex;
+
+namespace
+{
+    void set_fab (MultiFab& mf, int idx, Real val)
+    {
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+            if (mfi.index() == idx) mf[mfi].setVal(val);
+        }
+    }
+
+    void check (const MultiFab& mf, const std::string& name)
+    {
+        MultiFab rd(mf.boxArray(), mf.DistributionMap(), mf.nComp(), mf.nGrow());
+        VisMF::Read(rd, name);
+        MultiFab::Subtract(rd, mf, 0, 0, mf.nComp(), mf.nGrow());
+        for (int n = 0; n < mf.nComp(); ++n) {
+            tCheck::Require(rd.norm0(n, mf.nGrow()) == 0.0, "tVisMFDelta", "reading " + name);
+        }
+    }
+}
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv);
+    {
+        BoxArray ba(Box(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(31,31,31))));
+        ba.maxSize(8);
+        DistributionMapping dm(ba);
+
+        const int ncomp = 2;
+        const int ngrow = 1;
+        MultiFab mf(ba, dm, ncomp, ngrow);
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.fabbox();
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                for (int n = 0; n < ncomp; ++n) {
+                    mf[mfi](iv,n) = D_TERM(iv[0], + 100*iv[1], + 10000*iv[2]) + 0.25*n;
+                }
+            }
+        }
+
+        const std::string dir("tVisMFDelta_dir");
+        amrex::UtilCreateCleanDirectory(dir, true);
+
+        const std::string chk0(dir + "/chk0");
+        const std::string chk1(dir + "/chk1");
+        const std::string chk2(dir + "/chk2");
+        //
+        // Each delta changes a few fabs, so it must write less than the
+        // full write.
+        //
+        long full = VisMF::WriteDelta(mf, chk0, "");
+
+        set_fab(mf, 1, 7.0);
+        set_fab(mf, ba.size()-1, -3.0);
+        long delta1 = VisMF::WriteDelta(mf, chk1, chk0);
+
+        set_fab(mf, 2, 11.0);
+        long delta2 = VisMF::WriteDelta(mf, chk2, chk1);
+
+        ParallelDescriptor::ReduceLongSum(full);
+        ParallelDescriptor::ReduceLongSum(delta1);
+        ParallelDescriptor::ReduceLongSum(delta2);
+        tCheck::Require(delta1 < full && delta2 < full, "tVisMFDelta", "delta size");
+
+        check(mf, chk2);
+        //
+        // After folding, chk2 must not need the files of the others.
+        //
+        VisMF::Fold(chk2);
+        VisMF::RemoveFiles(chk0);
+        VisMF::RemoveFiles(chk1);
+        ParallelDescriptor::Barrier();
+        tCheck::Require(!VisMF::Exist(chk0) && !VisMF::Exist(chk1), "tVisMFDelta", "RemoveFiles");
+        if (ParallelDescriptor::IOProcessor()) {
+            std::ifstream ifs(NFilesIter::FileName(0, chk0 + "_D_"));
+            tCheck::Require(!ifs.good(), "tVisMFDelta", "RemoveFiles of the data");
+        }
+
+        check(mf, chk2);
+
+        tCheck::Passed("tVisMFDelta");
+    }
+    amrex::Finalize();
+}
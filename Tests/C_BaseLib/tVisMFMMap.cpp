@@ -0,0 +1,188 @@
+//
+// A test program for VisMF with the data files mapped into memory.  The
+// fabs of versions 1, 2 and 3 in the native format must be used in place,
+// those of other formats read as before, a single component must start at
+// its offset in the same mapping, and the mapping must stay as long as a
+// fab points into it.
+//
+
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include <AMReX_Utility.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_VisMF.H>
+#include <AMReX_FPC.H>
+
+#include "tCheck.H"
+
+using namespace amrex;
+
+namespace
+{
+    const int ncomp = 3;
+
+    Real value (const IntVect& iv, int n, int m)
+    {
+        return D_TERM(iv[0], + 100*iv[1], + 10000*iv[2]) + 0.25*n + 1.e6*m;
+    }
+
+    void fill (MultiFab& mf, int m)
+    {
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.fabbox();
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                for (int n = 0; n < mf.nComp(); ++n) {
+                    mf[mfi](iv,n) = value(iv,n,m);
+                }
+            }
+        }
+    }
+
+    //
+    // Whether component k of fab holds component scomp+k of the data.
+    // Written as 32 bit floats they are only close.
+    //
+    bool has_values (const FArrayBox& fab, const Box& bx, int scomp, int m, bool exact)
+    {
+        if (fab.box() != bx) return false;
+        for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+            for (int k = 0; k < fab.nComp(); ++k) {
+                const Real expected = value(iv,scomp+k,m);
+                if (exact ? fab(iv,k) != expected
+                          : std::abs(fab(iv,k) - expected) > 1.e-6*std::abs(expected)) return false;
+            }
+        }
+        return true;
+    }
+
+    //
+    // Whether the data of fab idx start where a Real may, which mapping
+    // them needs.  In version 1 they follow a fab header of any length.
+    //
+    bool aligned (const std::string& name, int idx)
+    {
+        VisMF::Header hdr;
+        std::ifstream hfs(name + "_H");
+        hfs >> hdr;
+
+        const VisMF::FabOnDisk& fod = hdr.m_fod[idx];
+        long offset = fod.m_head;
+        if (hdr.m_vers == VisMF::Header::Version_v1)
+        {
+            std::ifstream dfs(name.substr(0, name.rfind('/')+1) + fod.m_name);
+            dfs.seekg(offset);
+            std::string fabHeader;
+            std::getline(dfs, fabHeader);
+            offset += fabHeader.size() + 1;
+        }
+        return offset % alignof(Real) == 0;
+    }
+
+    void check (const MultiFab& mf, const std::string& name, int m, bool native,
+                const std::string& what)
+    {
+        long nbad = 0, nmismapped = 0;
+        std::unique_ptr<FArrayBox> kept;
+        {
+            VisMF vmf(name);
+            for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+            {
+                const int idx = mfi.index();
+                const Box& bx = mfi.fabbox();
+                const bool mapped = native && aligned(name, idx);
+
+                std::unique_ptr<FArrayBox> whole(vmf.readFAB(idx, name));
+                if (whole->nComp() != ncomp || !has_values(*whole, bx, 0, m, native)) ++nbad;
+
+                for (int n = 0; n < ncomp; ++n)
+                {
+                    const FArrayBox& fab = vmf.GetFab(idx, n);
+                    std::unique_ptr<FArrayBox> comp(vmf.readFAB(idx, n));
+                    if (fab.nComp() != 1 || !has_values(fab, bx, n, m, native)) ++nbad;
+                    if (comp->nComp() != 1 || !has_values(*comp, bx, n, m, native)) ++nbad;
+                    //
+                    // Mapped, they all point into the one mapping of the file.
+                    //
+                    const bool shared = fab.dataPtr() == whole->dataPtr(n) &&
+                                        comp->dataPtr() == whole->dataPtr(n);
+                    if (shared != mapped) ++nmismapped;
+
+                    if (n == ncomp-1 && !kept) kept = std::move(comp);
+                }
+            }
+        }
+        tCheck::Require(nbad == 0, "tVisMFMMap", what + " values");
+        tCheck::Require(nmismapped == 0, "tVisMFMMap", what + " mapping");
+        //
+        // The VisMF and the other fabs are gone, the mapping is not.
+        //
+        if (kept) {
+            MFIter mfi(mf);
+            tCheck::Require(has_values(*kept, mfi.fabbox(), ncomp-1, m, native),
+                            "tVisMFMMap", what + " kept fab");
+        }
+        //
+        // Before the files are written over.
+        //
+        ParallelDescriptor::Barrier();
+    }
+}
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv);
+    {
+        VisMF::SetUseMMap(true);
+
+        BoxArray ba(Box(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(31,31,31))));
+        ba.maxSize(16);
+        DistributionMapping dm(ba);
+
+        MultiFab mf(ba, dm, ncomp, 1);
+        fill(mf, 0);
+
+        const std::string dir("tVisMFMMap_dir");
+        amrex::UtilCreateCleanDirectory(dir, true);
+
+        const VisMF::Header::Version versions[] = { VisMF::Header::Version_v1,
+                                                    VisMF::Header::NoFabHeader_v1,
+                                                    VisMF::Header::NoFabHeaderMinMax_v1 };
+        //
+        // The native format is used in place.  32 bit floats are read and
+        // converted, unless they are the native Real.
+        //
+        const bool native32 = FPC::Native32RealDescriptor() == FPC::NativeRealDescriptor();
+        for (FABio::Format format : { FABio::FAB_NATIVE, FABio::FAB_NATIVE_32 })
+        {
+            FArrayBox::setFormat(format);
+            const bool native = format == FABio::FAB_NATIVE || native32;
+            for (VisMF::Header::Version v : versions)
+            {
+                VisMF::SetHeaderVersion(v);
+                const std::string tag = std::to_string(int(v)) + "_" + std::to_string(int(format));
+                const std::string name = dir + "/mf_" + tag;
+                VisMF::Write(mf, name);
+                check(mf, name, 0, native, "version " + tag);
+            }
+        }
+        //
+        // A file written over once nothing points into its old mapping.
+        //
+        FArrayBox::setFormat(FABio::FAB_NATIVE);
+        VisMF::SetHeaderVersion(VisMF::Header::NoFabHeaderMinMax_v1);
+        const std::string name = dir + "/mf_over";
+        VisMF::Write(mf, name);
+        check(mf, name, 0, true, "before writing over");
+        fill(mf, 1);
+        VisMF::Write(mf, name);
+        check(mf, name, 1, true, "after writing over");
+
+        tCheck::Passed("tVisMFMMap");
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,109 @@
+//
+// A test program for VisMF::ReadRegion.  Reading a region and a subset of
+// the components must give what Read followed by a ParallelCopy gives,
+// for the header versions with and without fab headers and compressed.
+//
+
+#include <string>
+
+#include <AMReX_Utility.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_VisMF.H>
+
+#include "tCheck.H"
+
+using namespace amrex;
+
+namespace
+{
+    void check (const std::string& name, const Box& region, const Vector<int>& comps)
+    {
+        MultiFab sub;
+        VisMF::ReadRegion(sub, name, region, comps);
+
+        MultiFab full;
+        VisMF::Read(full, name);
+
+        const Box domain = full.boxArray().minimalBox();
+        const long npts  = (region & domain).ok() ? (region & domain).numPts() : 0;
+        tCheck::Require(sub.boxArray().numPts() == npts, "tVisMFRegion", name + " number of points");
+        if (sub.size() == 0) return;
+
+        tCheck::Require(sub.nComp() == comps.size() && sub.nGrow() == 0, "tVisMFRegion",
+                        name + " shape");
+        for (int i = 0; i < sub.size(); ++i) {
+            tCheck::Require(region.contains(sub.boxArray()[i]), "tVisMFRegion", name + " boxes");
+        }
+
+        MultiFab ref(sub.boxArray(), sub.DistributionMap(), sub.nComp(), 0);
+        ref.setVal(0.0);
+        for (int n = 0; n < comps.size(); ++n) {
+            ref.ParallelCopy(full, comps[n], n, 1);
+        }
+
+        MultiFab::Subtract(ref, sub, 0, 0, sub.nComp(), 0);
+        for (int n = 0; n < sub.nComp(); ++n) {
+            tCheck::Require(ref.norm0(n) == 0.0, "tVisMFRegion", name + " data");
+        }
+    }
+}
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv);
+    {
+        const Box domain(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(47,47,47)));
+        BoxArray ba(domain);
+        ba.maxSize(16);
+        DistributionMapping dm(ba);
+
+        const int ncomp = 4;
+        MultiFab mf(ba, dm, ncomp, 1);
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.fabbox();
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                for (int n = 0; n < ncomp; ++n) {
+                    mf[mfi](iv,n) = D_TERM(iv[0], + 100*iv[1], + 10000*iv[2]) + 0.25*n;
+                }
+            }
+        }
+        //
+        // A region that cuts the boxes in every direction, a plane, and
+        // one that misses the domain.
+        //
+        const Vector<Box> regions = {
+            Box(IntVect(D_DECL(5,7,9)),      IntVect(D_DECL(30,20,40))),
+            Box(IntVect(D_DECL(0,0,17)),     IntVect(D_DECL(47,47,17))),
+            Box(IntVect(D_DECL(100,100,100)), IntVect(D_DECL(101,101,101)))
+        };
+        const Vector<Vector<int> > compsets = { {0,1,2,3}, {2}, {3,1} };
+
+        const std::string dir("tVisMFRegion_dir");
+        amrex::UtilCreateCleanDirectory(dir, true);
+
+        //
+        // Small blocks, so that the region only needs some of them.
+        //
+        VisMF::SetCompressionBlockSize(2048);
+
+        for (VisMF::Header::Version v : { VisMF::Header::Version_v1,
+                                          VisMF::Header::NoFabHeaderMinMax_v1,
+                                          VisMF::Header::Compressed_v1 })
+        {
+            VisMF::SetHeaderVersion(v);
+            const std::string name = dir + "/mf_v" + std::to_string(int(v));
+            VisMF::Write(mf, name);
+
+            for (const Box& region : regions) {
+                for (const auto& comps : compsets) {
+                    check(name, region, comps);
+                }
+            }
+        }
+
+        tCheck::Passed("tVisMFRegion");
+    }
+    amrex::Finalize();
+}
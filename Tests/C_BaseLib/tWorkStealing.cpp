@@ -0,0 +1,125 @@
+//
+// A test program for fabarray.mfiter_work_stealing.  Every tile of a
+// work-stealing MFIter loop must be visited by exactly one thread, with
+// and without tiling, and a reduction over the loop must give the sum
+// over all the cells.
+//
+
+#include <cmath>
+#include <string>
+
+#include <AMReX_Utility.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_iMultiFab.H>
+#include <AMReX_ParmParse.H>
+
+#include "tCheck.H"
+
+using namespace amrex;
+
+namespace
+{
+    //
+    // Some work, more of it in the first boxes, so that the threads that
+    // get those lag behind and the others steal from them.
+    //
+    Real work (const FArrayBox& fab, const Box& bx, int index)
+    {
+        Real s = 0.0;
+        const int nrep = (index < 4) ? 20 : 1;
+        for (int rep = 0; rep < nrep; ++rep) {
+            s = fab.sum(bx, 0);
+        }
+        return s;
+    }
+}
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv, true, MPI_COMM_WORLD, [] () {
+        ParmParse pp("fabarray");
+        pp.add("mfiter_work_stealing", 1);
+    });
+    {
+        const Box domain(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(63,63,63)));
+        BoxArray ba(domain);
+        ba.maxSize(16);
+        DistributionMapping dm(ba);
+
+        MultiFab mf(ba, dm, 1, 0);
+        for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.validbox();
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                mf[mfi](iv) = D_TERM(iv[0], + 64*iv[1], + 4096*iv[2]);
+            }
+        }
+        const Real total = mf.sum();
+
+        iMultiFab count(ba, dm, 1, 0);
+
+        MFIter::ResetWorkStealingStats();
+        long nloops = 0;
+        long ntiles = 0;
+
+        const IntVect tilesize(D_DECL(1024000,4,4));
+        //
+        // The dynamic schedule, which work stealing replaces, and work
+        // stealing asked for directly, without and with tiling.
+        //
+        for (const MFItInfo& info : { MFItInfo().SetDynamic(true),
+                                      MFItInfo().SetWorkStealing(true),
+                                      MFItInfo().EnableTiling(tilesize).SetDynamic(true),
+                                      MFItInfo().EnableTiling(tilesize).SetWorkStealing(true) })
+        {
+            const std::string what = info.do_tiling ? " with tiling" : " without tiling";
+
+            count.setVal(0);
+            Real sum = 0.0;
+            long n = 0;
+#ifdef _OPENMP
+#pragma omp parallel reduction(+:sum,n)
+#endif
+            for (MFIter mfi(mf, info); mfi.isValid(); ++mfi)
+            {
+                const Box& bx = mfi.tilebox();
+                count[mfi].plus(1, bx);
+                sum += work(mf[mfi], bx, mfi.index());
+                ++n;
+            }
+            ParallelDescriptor::ReduceRealSum(sum);
+
+            tCheck::Require(count.min(0) == 1 && count.max(0) == 1, "tWorkStealing",
+                            "visiting each cell once" + what);
+            tCheck::Require(std::abs(sum - total) <= 1.e-12*total, "tWorkStealing",
+                            "ReduceSum" + what);
+
+            long nexpected = 0;
+            const MFItInfo serial = info.do_tiling ? MFItInfo().EnableTiling(tilesize) : MFItInfo();
+            for (MFIter mfi(mf, serial); mfi.isValid(); ++mfi) {
+                ++nexpected;
+            }
+            tCheck::Require(n == nexpected, "tWorkStealing", "number of tiles" + what);
+
+#ifdef _OPENMP
+            if (omp_get_max_threads() > 1) {
+                ++nloops;
+                ntiles += n;
+            }
+#endif
+        }
+        //
+        // The work-stealing loops, each of which counts every tile once.
+        //
+        const MFIter::WorkStealingStats& stats = MFIter::GetWorkStealingStats();
+        long nstats = 0;
+        for (long nt : stats.ntiles) {
+            nstats += nt;
+        }
+        tCheck::Require(stats.nloops == nloops && nstats == ntiles, "tWorkStealing", "statistics");
+
+        tCheck::Passed("tWorkStealing");
+    }
+    amrex::Finalize();
+}
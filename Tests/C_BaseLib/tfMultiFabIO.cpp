@@ -0,0 +1,116 @@
+//
+// A test program for VisMF::Write and VisMF::Read of fMultiFabs.  The
+// data must be written as floats, taking about as much room on disk as
+// in memory, and come back unchanged when read as an fMultiFab, whether
+// defined or not, and as a MultiFab.
+//
+
+#include <string>
+
+#include <AMReX_Utility.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_fMultiFab.H>
+#include <AMReX_VisMF.H>
+
+#include "tCheck.H"
+
+using namespace amrex;
+
+namespace
+{
+    float value (const IntVect& iv, int n)
+    {
+        return float(D_TERM(iv[0], + 32*iv[1], + 1024*iv[2])) + 0.25f*n;
+    }
+
+    //
+    // The data of fa, including its ghost cells, which must have been
+    // written as well.
+    //
+    template <class FAB>
+    void check (const FabArray<FAB>& fa, const BoxArray& ba, int ngrow, const std::string& what)
+    {
+        tCheck::Require(fa.boxArray() == ba && fa.nComp() == 2 && fa.nGrow() == ngrow,
+                        "tfMultiFabIO", what + " layout");
+
+        long nbad = 0;
+        for (MFIter mfi(fa); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.fabbox();
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                for (int n = 0; n < fa.nComp(); ++n) {
+                    if (fa[mfi](iv,n) != value(iv,n)) ++nbad;
+                }
+            }
+        }
+        tCheck::Require(nbad == 0, "tfMultiFabIO", what);
+    }
+}
+
+int
+main (int argc, char** argv)
+{
+    amrex::Initialize(argc, argv);
+    {
+        const Box domain(IntVect(D_DECL(0,0,0)), IntVect(D_DECL(31,31,31)));
+        BoxArray ba(domain);
+        ba.maxSize(8);
+        DistributionMapping dm(ba);
+
+        const int ncomp = 2;
+        const int ngrow = 1;
+        fMultiFab a(ba, dm, ncomp, ngrow);
+        for (MFIter mfi(a); mfi.isValid(); ++mfi)
+        {
+            const Box& bx = mfi.fabbox();
+            for (IntVect iv = bx.smallEnd(); iv <= bx.bigEnd(); bx.next(iv)) {
+                for (int n = 0; n < ncomp; ++n) {
+                    a[mfi](iv,n) = value(iv,n);
+                }
+            }
+        }
+
+        long nbytes = 0;
+        for (int i = 0; i < ba.size(); ++i) {
+            nbytes += amrex::grow(ba[i], ngrow).numPts() * ncomp * sizeof(float);
+        }
+
+        const std::string dir("tfMultiFabIO_dir");
+        amrex::UtilCreateCleanDirectory(dir, true);
+
+        const VisMF::Header::Version version = VisMF::GetHeaderVersion();
+        const FABio::Format format = FArrayBox::getFormat();
+
+        for (VisMF::Header::Version v : { VisMF::Header::Version_v1,
+                                          VisMF::Header::NoFabHeaderMinMax_v1,
+                                          VisMF::Header::Compressed_v1 })
+        {
+            VisMF::SetHeaderVersion(v);
+            const std::string name = dir + "/fmf_v" + std::to_string(int(v));
+            const std::string tag  = " of version " + std::to_string(int(v));
+
+            long written = VisMF::Write(a, name);
+            ParallelDescriptor::ReduceLongSum(written);
+            tCheck::Require(written >= nbytes && written < nbytes + nbytes/2,
+                            "tfMultiFabIO", "size on disk" + tag);
+            tCheck::Require(FArrayBox::getFormat() == format, "tfMultiFabIO", "keeping the format");
+
+            fMultiFab defined(ba, dm, ncomp, ngrow);
+            VisMF::Read(defined, name);
+            check(defined, ba, ngrow, "reading into a defined fMultiFab" + tag);
+
+            fMultiFab undefined;
+            VisMF::Read(undefined, name);
+            check(undefined, ba, ngrow, "reading into an undefined fMultiFab" + tag);
+
+            MultiFab mf;
+            VisMF::Read(mf, name);
+            check(mf, ba, ngrow, "reading into a MultiFab" + tag);
+        }
+
+        VisMF::SetHeaderVersion(version);
+
+        tCheck::Passed("tfMultiFabIO");
+    }
+    amrex::Finalize();
+}
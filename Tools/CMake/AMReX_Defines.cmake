@@ -118,6 +118,9 @@ elseif (${TP_PROFILE} MATCHES "VTUNE")
    add_define ( AMREX_VTUNE )
 endif ()
 
+# FAB memory arena
+add_define ( AMREX_POOL_FABS IF ENABLE_POOL_ARENA )
+
 # MPI
 add_define ( AMREX_USE_MPI IF ENABLE_MPI )
 
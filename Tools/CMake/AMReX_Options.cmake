@@ -182,6 +182,9 @@ endif ()
 option (ENABLE_FPE "Enable Floating Point Exceptions checks" OFF)
 print_option ( ENABLE_FPE )
 
+option ( ENABLE_POOL_ARENA "Allocate FAB data from thread-local memory pools" OFF )
+print_option ( ENABLE_POOL_ARENA )
+
 if (DEBUG)
    option ( ENABLE_ASSERTION "Enable assertions" ON)
 else ()
@@ -0,0 +1,87 @@
+//
+// Make a checkpoint written with amr.checkpoint_deltas self-contained, so
+// that the checkpoints it refers to can be removed:
+//
+//   FoldCheckpoint.exe chk=chk00200 [mf="Level_0/Extra_MF ..."]
+//
+// Folds the FabArrays listed in the FabArrayHeaders.txt of the checkpoint,
+// and those given by mf, relative to the checkpoint directory.  Fold the
+// newer checkpoints before the older ones they refer to are removed.
+//
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <AMReX_REAL.H>
+#include "AMReX_ParmParse.H"
+#include <AMReX_ParallelDescriptor.H>
+#include "AMReX_Utility.H"
+#include <AMReX_VisMF.H>
+
+using namespace amrex;
+
+static
+void
+PrintUsage (const char* progName)
+{
+    amrex::Print() << "Usage: " << progName << " chk=checkpoint [mf=\"names ...\"] [verbose=0]\n";
+    amrex::Finalize();
+    exit(1);
+}
+
+int
+main (int   argc,
+      char* argv[])
+{
+    amrex::Initialize(argc,argv);
+
+    if (argc < 2)
+        PrintUsage(argv[0]);
+
+    ParmParse pp;
+
+    std::string chkfile;
+    if ( ! pp.query("chk",chkfile))
+        PrintUsage(argv[0]);
+
+    int verbose(0);
+    pp.query("verbose",verbose);
+
+    Vector<std::string> names;
+    {
+        Vector<char> fileChars;
+        bool bExitOnError(false);
+        ParallelDescriptor::ReadAndBcastFile(chkfile + "/FabArrayHeaders.txt", fileChars,
+                                             bExitOnError);
+        if (fileChars.size() > 0)
+        {
+            std::istringstream is(std::string(fileChars.dataPtr()), std::istringstream::in);
+            std::string name;
+            while (is >> name)
+                names.push_back(name);
+        }
+    }
+    for (int i = 0, N = pp.countval("mf"); i < N; ++i)
+    {
+        std::string name;
+        pp.get("mf",name,i);
+        names.push_back(name);
+    }
+
+    long bytesCopied(0);
+    for (int i = 0; i < names.size(); ++i)
+    {
+        const std::string mf_name(chkfile + '/' + names[i]);
+        if (verbose > 0)
+            amrex::Print() << "Folding " << mf_name << '\n';
+        bytesCopied += VisMF::Fold(mf_name);
+    }
+
+    ParallelDescriptor::ReduceLongSum(bytesCopied, ParallelDescriptor::IOProcessorNumber());
+
+    amrex::Print() << "Folded " << names.size() << " FabArrays of " << chkfile
+                   << ", copying " << bytesCopied << " bytes\n";
+
+    amrex::Finalize();
+}